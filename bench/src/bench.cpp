@@ -0,0 +1,362 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file bench.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief The cipher and MAC throughput benchmarks.
+ *
+ * Usage: bench [--time <ms>] [--filter <substring>] [--max-size <bytes>]
+ *
+ * The results are written to the standard output, as JSON. Progress is written to the standard error.
+ */
+
+#include "harness.hpp"
+
+#include <cryptoplus/cryptoplus.hpp>
+#include <cryptoplus/cipher/cipher_algorithm.hpp>
+#include <cryptoplus/cipher/cipher_context.hpp>
+#include <cryptoplus/cipher/cipher_stream.hpp>
+#include <cryptoplus/cipher/etm_context.hpp>
+#include <cryptoplus/bio/bio_chain.hpp>
+#include <cryptoplus/hash/message_digest_algorithm.hpp>
+#include <cryptoplus/hash/hmac_context.hpp>
+#include <cryptoplus/hash/cmac_context.hpp>
+#include <cryptoplus/hash/gmac_context.hpp>
+#include <cryptoplus/random/random.hpp>
+#include <cryptoplus/error/error_strings.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	using namespace cryptoplus;
+
+	const size_t default_max_size = 16 * 1024 * 1024;
+	const unsigned int default_time_ms = 200;
+
+	/**
+	 * \brief The shared benchmark buffers.
+	 */
+	struct buffers
+	{
+		explicit buffers(size_t max_size) :
+			in(max_size),
+			out(max_size + 2 * EVP_MAX_BLOCK_LENGTH + EVP_MAX_MD_SIZE)
+		{
+			random::get_random_bytes(&in[0], in.size());
+			random::get_random_bytes(key, sizeof(key));
+			random::get_random_bytes(iv, sizeof(iv));
+		}
+
+		std::vector<unsigned char> in;
+		std::vector<unsigned char> out;
+		unsigned char key[EVP_MAX_KEY_LENGTH];
+		unsigned char iv[EVP_MAX_IV_LENGTH];
+	};
+
+	// cipher_context, keyed once: each message only sets the IV.
+	void keyed_context_case(cipher::cipher_context& ctx, buffers& b, size_t size)
+	{
+		const cipher::cipher_algorithm algorithm = ctx.algorithm();
+
+		if (algorithm.iv_length() > 0)
+		{
+			ctx.set_iv(b.iv, algorithm.iv_length());
+		}
+
+		size_t cnt = ctx.update(&b.out[0], b.out.size(), &b.in[0], size);
+		ctx.finalize(&b.out[cnt], b.out.size() - cnt);
+	}
+
+	// A new cipher_context for every message.
+	void one_shot_case(const cipher::cipher_algorithm& algorithm, buffers& b, size_t size)
+	{
+		cipher::cipher_context ctx;
+		ctx.initialize(algorithm, cipher::cipher_context::encrypt, b.key, algorithm.key_length(), b.iv, algorithm.iv_length());
+
+		size_t cnt = ctx.update(&b.out[0], b.out.size(), &b.in[0], size);
+		ctx.finalize(&b.out[cnt], b.out.size() - cnt);
+	}
+
+	void cipher_stream_case(const cipher::cipher_algorithm& algorithm, buffers& b, size_t size)
+	{
+		cipher::cipher_stream stream(size + algorithm.block_size());
+
+		stream.initialize(algorithm, cipher::cipher_stream::encrypt, b.key, algorithm.key_length(), b.iv, algorithm.iv_length());
+		stream.append(&b.in[0], size);
+		stream.finalize();
+	}
+
+	void bio_case(const cipher::cipher_algorithm& algorithm, buffers& b, size_t size)
+	{
+		bio::bio_chain chain(BIO_f_cipher());
+		chain.first().push(bio::bio_ptr(BIO_new(BIO_s_mem())));
+		chain.first().set_cipher(algorithm, b.key, b.iv, cipher::cipher_context::encrypt);
+
+		if ((size > 0) && (chain.first().write(&b.in[0], size) != static_cast<ptrdiff_t>(size)))
+		{
+			throw std::runtime_error("BIO write failed");
+		}
+
+		chain.first().flush();
+	}
+
+	void hmac_case(hash::hmac_context& ctx, buffers& b, size_t size)
+	{
+		ctx.initialize(NULL, 0, NULL);
+		ctx.update(&b.in[0], size);
+		ctx.finalize(&b.out[0], b.out.size());
+	}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+	void cmac_case(hash::cmac_context& ctx, buffers& b, size_t size)
+	{
+		ctx.compute(&b.out[0], b.out.size(), &b.in[0], size);
+	}
+
+	void gmac_case(hash::gmac_context& ctx, buffers& b, size_t size)
+	{
+		ctx.compute(&b.out[0], b.out.size(), b.iv, ctx.iv_length(), &b.in[0], size);
+	}
+#endif
+
+	void etm_case(cipher::etm_context& ctx, buffers& b, size_t size)
+	{
+		ctx.seal(&b.out[0], b.out.size(), b.iv, ctx.algorithm().iv_length(), NULL, 0, &b.in[0], size);
+	}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10000000
+	void add_cipher_name(const EVP_CIPHER* cipher, const char*, const char*, void* arg)
+	{
+		// Aliases have no cipher.
+		if (cipher)
+		{
+			static_cast<std::set<std::string>*>(arg)->insert(OBJ_nid2ln(EVP_CIPHER_nid(cipher)));
+		}
+	}
+#endif
+
+	std::set<std::string> get_cipher_names()
+	{
+		std::set<std::string> names;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10000000
+		EVP_CIPHER_do_all_sorted(add_cipher_name, &names);
+#else
+		const char* const defaults[] = { "DES-CBC", "DES-EDE3-CBC", "BF-CBC", "AES-128-CBC", "AES-192-CBC", "AES-256-CBC" };
+
+		names.insert(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+#endif
+
+		return names;
+	}
+
+	std::vector<size_t> get_sizes(size_t max_size)
+	{
+		std::vector<size_t> sizes;
+
+		for (size_t size = 16; size <= max_size; size *= 4)
+		{
+			sizes.push_back(size);
+		}
+
+		return sizes;
+	}
+
+	void run_ciphers(bench::harness& h, buffers& b, const std::vector<size_t>& sizes)
+	{
+		const std::set<std::string> names = get_cipher_names();
+
+		for (std::set<std::string>::const_iterator name = names.begin(); name != names.end(); ++name)
+		{
+			const std::string apis[] = { "cipher_context", "one_shot", "cipher_stream", "bio_ptr" };
+
+			bool any = false;
+
+			for (size_t i = 0; i < sizeof(apis) / sizeof(apis[0]); ++i)
+			{
+				any = any || h.selected(*name, apis[i]);
+			}
+
+			if (!any)
+			{
+				continue;
+			}
+
+			cipher::cipher_algorithm algorithm(*name);
+			cipher::cipher_context ctx;
+
+			std::string keyed_error;
+
+			try
+			{
+				ctx.initialize(algorithm, cipher::cipher_context::encrypt, b.key, algorithm.key_length(), NULL, algorithm.iv_length());
+			}
+			catch (const std::exception& ex)
+			{
+				keyed_error = ex.what();
+			}
+
+			for (std::vector<size_t>::const_iterator size = sizes.begin(); size != sizes.end(); ++size)
+			{
+				if (keyed_error.empty())
+				{
+					h.run("cipher", *name, apis[0], *size, boost::bind(&keyed_context_case, boost::ref(ctx), boost::ref(b), *size));
+				}
+
+				h.run("cipher", *name, apis[1], *size, boost::bind(&one_shot_case, algorithm, boost::ref(b), *size));
+				h.run("cipher", *name, apis[2], *size, boost::bind(&cipher_stream_case, algorithm, boost::ref(b), *size));
+				h.run("cipher", *name, apis[3], *size, boost::bind(&bio_case, algorithm, boost::ref(b), *size));
+			}
+		}
+	}
+
+	void run_macs(bench::harness& h, buffers& b, const std::vector<size_t>& sizes)
+	{
+		const char* const digests[] = { "SHA1", "SHA256", "SHA512" };
+
+		for (size_t i = 0; i < sizeof(digests) / sizeof(digests[0]); ++i)
+		{
+			const std::string name = std::string("HMAC-") + digests[i];
+
+			if (!h.selected(name, "hmac_context"))
+			{
+				continue;
+			}
+
+			const hash::message_digest_algorithm algorithm(digests[i]);
+			hash::hmac_context ctx;
+			ctx.initialize(b.key, algorithm.result_size(), &algorithm);
+
+			for (std::vector<size_t>::const_iterator size = sizes.begin(); size != sizes.end(); ++size)
+			{
+				h.run("mac", name, "hmac_context", *size, boost::bind(&hmac_case, boost::ref(ctx), boost::ref(b), *size));
+			}
+		}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+		if (h.selected("AES-128-CMAC", "cmac_context"))
+		{
+			hash::cmac_context ctx;
+			ctx.initialize(b.key, 16, cipher::cipher_algorithm(EVP_aes_128_cbc()));
+
+			for (std::vector<size_t>::const_iterator size = sizes.begin(); size != sizes.end(); ++size)
+			{
+				h.run("mac", "AES-128-CMAC", "cmac_context", *size, boost::bind(&cmac_case, boost::ref(ctx), boost::ref(b), *size));
+			}
+		}
+
+		if (h.selected("AES-128-GMAC", "gmac_context"))
+		{
+			hash::gmac_context ctx;
+			ctx.initialize(b.key, 16, cipher::cipher_algorithm(EVP_aes_128_gcm()));
+
+			for (std::vector<size_t>::const_iterator size = sizes.begin(); size != sizes.end(); ++size)
+			{
+				h.run("mac", "AES-128-GMAC", "gmac_context", *size, boost::bind(&gmac_case, boost::ref(ctx), boost::ref(b), *size));
+			}
+		}
+#endif
+
+		if (h.selected("AES-128-CBC-HMAC-SHA256", "etm_context"))
+		{
+			cipher::etm_context ctx;
+			ctx.initialize(cipher::cipher_algorithm(EVP_aes_128_cbc()), cipher::cipher_context::encrypt, b.key, 16, hash::message_digest_algorithm(EVP_sha256()), b.key + 16, 16, 16);
+
+			for (std::vector<size_t>::const_iterator size = sizes.begin(); size != sizes.end(); ++size)
+			{
+				h.run("mac", "AES-128-CBC-HMAC-SHA256", "etm_context", *size, boost::bind(&etm_case, boost::ref(ctx), boost::ref(b), *size));
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	cryptoplus::crypto_initializer crypto_initializer;
+	cryptoplus::algorithms_initializer algorithms_initializer;
+	cryptoplus::error::error_strings_initializer error_strings_initializer;
+
+	unsigned int time_ms = default_time_ms;
+	size_t max_size = default_max_size;
+	std::string filter;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+
+		if ((arg == "--time") && (i + 1 < argc))
+		{
+			time_ms = static_cast<unsigned int>(std::strtoul(argv[++i], NULL, 10));
+		}
+		else if ((arg == "--filter") && (i + 1 < argc))
+		{
+			filter = argv[++i];
+		}
+		else if ((arg == "--max-size") && (i + 1 < argc))
+		{
+			max_size = static_cast<size_t>(std::strtoul(argv[++i], NULL, 10));
+		}
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--time <ms>] [--filter <substring>] [--max-size <bytes>]" << std::endl;
+
+			return EXIT_FAILURE;
+		}
+	}
+
+	bench::harness h(time_ms, filter);
+	buffers b(max_size);
+	const std::vector<size_t> sizes = get_sizes(max_size);
+
+	run_ciphers(h, b, sizes);
+	run_macs(h, b, sizes);
+
+	h.write_json(std::cout);
+
+	return EXIT_SUCCESS;
+}
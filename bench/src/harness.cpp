@@ -0,0 +1,256 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file harness.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief The benchmark harness.
+ */
+
+#include "harness.hpp"
+#include "timer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+
+namespace bench
+{
+	namespace
+	{
+		// The minimum duration of a timed batch.
+		const boost::uint64_t min_batch_ns = 20000;
+
+		// The maximum count of latency samples kept per case.
+		const size_t max_samples = 100000;
+
+		double percentile(const std::vector<double>& sorted, double p)
+		{
+			if (sorted.empty())
+			{
+				return 0.0;
+			}
+
+			const size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+
+			return sorted[index];
+		}
+
+		std::string json_string(const std::string& str)
+		{
+			std::string out = "\"";
+
+			for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+			{
+				switch (*it)
+				{
+					case '"':
+						out += "\\\"";
+						break;
+					case '\\':
+						out += "\\\\";
+						break;
+					case '\n':
+						out += "\\n";
+						break;
+					default:
+						if (static_cast<unsigned char>(*it) >= 0x20)
+						{
+							out += *it;
+						}
+				}
+			}
+
+			return out + "\"";
+		}
+	}
+
+	harness::harness(unsigned int min_time_ms, const std::string& filter) :
+		m_min_time_ms(min_time_ms),
+		m_filter(filter)
+	{
+	}
+
+	bool harness::selected(const std::string& algorithm, const std::string& api) const
+	{
+		return m_filter.empty() || (algorithm.find(m_filter) != std::string::npos) || (api.find(m_filter) != std::string::npos);
+	}
+
+	void harness::run(const std::string& kind, const std::string& algorithm, const std::string& api, size_t size, case_type function)
+	{
+		if (!selected(algorithm, api))
+		{
+			return;
+		}
+
+		result r;
+		r.kind = kind;
+		r.algorithm = algorithm;
+		r.api = api;
+		r.size = size;
+		r.iterations = 0;
+		r.seconds = 0.0;
+		r.cycles_per_byte = -1.0;
+		r.messages_per_second = 0.0;
+		r.bytes_per_second = 0.0;
+		r.p50_ns = 0.0;
+		r.p90_ns = 0.0;
+		r.p99_ns = 0.0;
+		r.max_ns = 0.0;
+
+		try
+		{
+			measure(r, function);
+		}
+		catch (const std::exception& ex)
+		{
+			r.error = ex.what();
+		}
+
+		std::clog << kind << " " << algorithm << " " << api << " " << size << ": ";
+
+		if (r.error.empty())
+		{
+			std::clog << std::fixed << std::setprecision(1) << (r.bytes_per_second / 1e6) << " MB/s" << std::endl;
+		}
+		else
+		{
+			std::clog << r.error << std::endl;
+		}
+
+		m_results.push_back(r);
+	}
+
+	void harness::measure(result& r, case_type& function)
+	{
+		// Warm up the caches and estimate the batch size.
+		boost::uint64_t start = now_ns();
+		function();
+		const boost::uint64_t first_ns = (std::max)(static_cast<boost::uint64_t>(1), now_ns() - start);
+
+		const boost::uint64_t batch = (std::max)(static_cast<boost::uint64_t>(1), min_batch_ns / first_ns);
+		const boost::uint64_t min_time_ns = static_cast<boost::uint64_t>(m_min_time_ms) * 1000000u;
+
+		std::vector<double> samples;
+		boost::uint64_t elapsed_ns = 0;
+
+		const boost::uint64_t start_cycles = cycles();
+
+		do
+		{
+			start = now_ns();
+
+			for (boost::uint64_t i = 0; i < batch; ++i)
+			{
+				function();
+			}
+
+			const boost::uint64_t batch_ns = now_ns() - start;
+
+			elapsed_ns += batch_ns;
+			r.iterations += batch;
+
+			if (samples.size() < max_samples)
+			{
+				samples.push_back(static_cast<double>(batch_ns) / static_cast<double>(batch));
+			}
+		}
+		while (elapsed_ns < min_time_ns);
+
+		const boost::uint64_t total_cycles = cycles() - start_cycles;
+
+		std::sort(samples.begin(), samples.end());
+
+		r.seconds = static_cast<double>(elapsed_ns) / 1e9;
+		r.messages_per_second = static_cast<double>(r.iterations) / r.seconds;
+		r.bytes_per_second = r.messages_per_second * static_cast<double>(r.size);
+		r.p50_ns = percentile(samples, 0.50);
+		r.p90_ns = percentile(samples, 0.90);
+		r.p99_ns = percentile(samples, 0.99);
+		r.max_ns = samples.back();
+
+		if (has_cycle_counter() && (r.size > 0))
+		{
+			r.cycles_per_byte = static_cast<double>(total_cycles) / (static_cast<double>(r.iterations) * static_cast<double>(r.size));
+		}
+	}
+
+	void harness::write_json(std::ostream& os) const
+	{
+		os << "[" << std::endl;
+
+		for (std::vector<result>::const_iterator r = m_results.begin(); r != m_results.end(); ++r)
+		{
+			os << "  {";
+			os << "\"kind\": " << json_string(r->kind);
+			os << ", \"algorithm\": " << json_string(r->algorithm);
+			os << ", \"api\": " << json_string(r->api);
+			os << ", \"size\": " << r->size;
+
+			if (!r->error.empty())
+			{
+				os << ", \"error\": " << json_string(r->error);
+			}
+			else
+			{
+				os << std::setprecision(std::numeric_limits<double>::digits10);
+				os << ", \"iterations\": " << r->iterations;
+				os << ", \"seconds\": " << r->seconds;
+
+				if (r->cycles_per_byte >= 0.0)
+				{
+					os << ", \"cycles_per_byte\": " << r->cycles_per_byte;
+				}
+				else
+				{
+					os << ", \"cycles_per_byte\": null";
+				}
+
+				os << ", \"messages_per_second\": " << r->messages_per_second;
+				os << ", \"bytes_per_second\": " << r->bytes_per_second;
+				os << ", \"batch_mean_latency_ns\": {\"p50\": " << r->p50_ns << ", \"p90\": " << r->p90_ns << ", \"p99\": " << r->p99_ns << ", \"max\": " << r->max_ns << "}";
+			}
+
+			os << "}" << ((r + 1 != m_results.end()) ? "," : "") << std::endl;
+		}
+
+		os << "]" << std::endl;
+	}
+}
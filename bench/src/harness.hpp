@@ -0,0 +1,138 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file harness.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief The benchmark harness.
+ */
+
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+
+#include <boost/function.hpp>
+#include <boost/cstdint.hpp>
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+namespace bench
+{
+	/**
+	 * \brief A benchmark result.
+	 */
+	struct result
+	{
+		std::string kind;
+		std::string algorithm;
+		std::string api;
+		size_t size;
+		boost::uint64_t iterations;
+		double seconds;
+		double cycles_per_byte;
+		double messages_per_second;
+		double bytes_per_second;
+		double p50_ns;
+		double p90_ns;
+		double p99_ns;
+		double max_ns;
+		std::string error;
+	};
+
+	/**
+	 * \brief The benchmark harness.
+	 *
+	 * Each case is a function that processes one message. The harness calls it repeatedly for at least min_time_ms milliseconds.
+	 *
+	 * Small messages are timed by batches, so that the clock overhead stays negligible. The latency percentiles are thus percentiles of the per-message mean of each batch, reported as batch_mean_latency_ns: they hide the variance within a batch. Only messages that take more than 10 microseconds are timed one by one.
+	 */
+	class harness
+	{
+		public:
+
+			/**
+			 * \brief A benchmark case.
+			 */
+			typedef boost::function<void ()> case_type;
+
+			/**
+			 * \brief Create a new harness.
+			 * \param min_time_ms The minimum duration of each case, in milliseconds.
+			 * \param filter Only the cases whose algorithm or API name contain filter are run. If filter is empty, all the cases are run.
+			 */
+			harness(unsigned int min_time_ms, const std::string& filter);
+
+			/**
+			 * \brief Check if a case is selected by the filter.
+			 * \param algorithm The algorithm name.
+			 * \param api The API name.
+			 * \return true if the case should be run.
+			 */
+			bool selected(const std::string& algorithm, const std::string& api) const;
+
+			/**
+			 * \brief Run a case.
+			 * \param kind The kind of the case ("cipher" or "mac").
+			 * \param algorithm The algorithm name.
+			 * \param api The API name.
+			 * \param size The message size.
+			 * \param function The case.
+			 *
+			 * If function throws, the error is recorded in the result.
+			 */
+			void run(const std::string& kind, const std::string& algorithm, const std::string& api, size_t size, case_type function);
+
+			/**
+			 * \brief Write the results as JSON.
+			 * \param os The output stream.
+			 */
+			void write_json(std::ostream& os) const;
+
+		private:
+
+			void measure(result& r, case_type& function);
+
+			unsigned int m_min_time_ms;
+			std::string m_filter;
+			std::vector<result> m_results;
+	};
+}
+
+#endif /* BENCH_HARNESS_HPP */
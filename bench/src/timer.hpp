@@ -0,0 +1,116 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file timer.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief The benchmark clocks.
+ */
+
+#ifndef BENCH_TIMER_HPP
+#define BENCH_TIMER_HPP
+
+#include <cryptoplus/os.hpp>
+
+#include <boost/cstdint.hpp>
+
+#ifdef WINDOWS
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <time.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace bench
+{
+	/**
+	 * \brief Get a monotonic time.
+	 * \return The time, in nanoseconds.
+	 */
+	inline boost::uint64_t now_ns()
+	{
+#ifdef WINDOWS
+		LARGE_INTEGER frequency;
+		LARGE_INTEGER counter;
+
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&counter);
+
+		return static_cast<boost::uint64_t>(static_cast<double>(counter.QuadPart) * 1e9 / static_cast<double>(frequency.QuadPart));
+#else
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+
+		return static_cast<boost::uint64_t>(ts.tv_sec) * 1000000000u + static_cast<boost::uint64_t>(ts.tv_nsec);
+#endif
+	}
+
+	/**
+	 * \brief Check if a cycle counter is available.
+	 * \return true if cycles() returns meaningful values.
+	 */
+	inline bool has_cycle_counter()
+	{
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * \brief Read the CPU cycle counter.
+	 * \return The cycle counter, or 0 if has_cycle_counter() is false.
+	 *
+	 * On x86, this is the time-stamp counter: on CPUs with frequency scaling it counts reference cycles, not core cycles.
+	 */
+	inline boost::uint64_t cycles()
+	{
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+		return __rdtsc();
+#else
+		return 0;
+#endif
+	}
+}
+
+#endif /* BENCH_TIMER_HPP */
@@ -0,0 +1,217 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file capabilities.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Host capabilities and fastest algorithm selection.
+ */
+
+#ifndef CRYPTOPLUS_CAPABILITIES_HPP
+#define CRYPTOPLUS_CAPABILITIES_HPP
+
+#include "initializer.hpp"
+#include "cipher/cipher_algorithm.hpp"
+#include "hash/message_digest_algorithm.hpp"
+
+#include <vector>
+
+#include <cstddef>
+
+namespace cryptoplus
+{
+	/**
+	 * \brief The CPU features.
+	 *
+	 * Only x86 and x86-64 features are reported.
+	 */
+	enum cpu_feature
+	{
+		cpu_sse2 = 0x01, /**< \brief SSE2. */
+		cpu_ssse3 = 0x02, /**< \brief SSSE3, used by the constant-time vector AES implementation. */
+		cpu_aes = 0x04, /**< \brief The AES-NI instructions. */
+		cpu_pclmulqdq = 0x08, /**< \brief The carry-less multiplication instruction, used by GCM. */
+		cpu_avx = 0x10, /**< \brief AVX. */
+		cpu_avx2 = 0x20, /**< \brief AVX2. */
+		cpu_sha = 0x40, /**< \brief The SHA-NI instructions. */
+		cpu_avx512f = 0x80 /**< \brief AVX-512 foundation. */
+	};
+
+	/**
+	 * \brief Get the CPU features in use.
+	 * \return A combination of cpu_feature values.
+	 *
+	 * With OpenSSL versions prior to 3.0, the features are read from the OpenSSL capability vector: they are the ones OpenSSL actually uses, including any restriction set through the OPENSSL_ia32cap environment variable. Later versions do not export that vector and the features are read with the CPUID instruction instead.
+	 *
+	 * On architectures other than x86 and x86-64, 0 is returned.
+	 */
+	unsigned int get_cpu_features();
+
+	/**
+	 * \brief Check if a CPU feature is in use.
+	 * \param feature The feature.
+	 * \return true if feature is in use.
+	 */
+	inline bool has_cpu_feature(cpu_feature feature)
+	{
+		return ((get_cpu_features() & feature) != 0);
+	}
+
+	/**
+	 * \brief The size of the messages used by the self-benchmark.
+	 */
+	const size_t capabilities_message_size = 4096;
+
+	/**
+	 * \brief The measured throughput of an AEAD cipher.
+	 */
+	struct aead_score
+	{
+		/**
+		 * \brief Create an aead_score.
+		 * \param _algorithm The cipher algorithm.
+		 * \param _bytes_per_second The measured throughput.
+		 * \param _constant_time Whether the implementation in use is believed to be constant-time.
+		 */
+		aead_score(const cipher::cipher_algorithm& _algorithm, double _bytes_per_second, bool _constant_time) :
+			algorithm(_algorithm),
+			bytes_per_second(_bytes_per_second),
+			constant_time(_constant_time)
+		{
+		}
+
+		/**
+		 * \brief The cipher algorithm.
+		 */
+		cipher::cipher_algorithm algorithm;
+
+		/**
+		 * \brief The measured throughput, in bytes per second.
+		 */
+		double bytes_per_second;
+
+		/**
+		 * \brief Whether the implementation in use is believed to be constant-time.
+		 *
+		 * On x86 and x86-64, AES-GCM is only constant-time with PCLMULQDQ and either AES-NI or SSSE3: the generic AES and GHASH implementations use lookup tables.
+		 */
+		bool constant_time;
+	};
+
+	/**
+	 * \brief The measured throughput of a message digest algorithm.
+	 */
+	struct hash_score
+	{
+		/**
+		 * \brief Create a hash_score.
+		 * \param _algorithm The message digest algorithm.
+		 * \param _bytes_per_second The measured throughput.
+		 */
+		hash_score(const hash::message_digest_algorithm& _algorithm, double _bytes_per_second) :
+			algorithm(_algorithm),
+			bytes_per_second(_bytes_per_second)
+		{
+		}
+
+		/**
+		 * \brief The message digest algorithm.
+		 */
+		hash::message_digest_algorithm algorithm;
+
+		/**
+		 * \brief The measured throughput, in bytes per second.
+		 */
+		double bytes_per_second;
+	};
+
+	/**
+	 * \brief Get the AEAD ciphers, fastest first.
+	 * \return The ranking.
+	 *
+	 * The candidates are AES-128-GCM, AES-256-GCM and ChaCha20-Poly1305, when supported by the OpenSSL version in use. Each one seals capabilities_message_size bytes messages for a few milliseconds, the first time a ranking is requested.
+	 */
+	const std::vector<aead_score>& get_aead_ranking();
+
+	/**
+	 * \brief Get the message digest algorithms, fastest first.
+	 * \return The ranking.
+	 *
+	 * The candidates are SHA-256, SHA-512, SHA-512/256, SHA3-256, BLAKE2s-256 and BLAKE2b-512, when supported by the OpenSSL version in use. Each one hashes capabilities_message_size bytes messages for a few milliseconds, the first time a ranking is requested.
+	 */
+	const std::vector<hash_score>& get_hash_ranking();
+
+	/**
+	 * \brief Get the fastest AEAD cipher for this host.
+	 * \param min_key_length The minimum key length, in bytes.
+	 * \return The fastest constant-time AEAD cipher whose key is at least min_key_length bytes long. If no candidate is constant-time, the fastest one.
+	 *
+	 * If no AEAD cipher has a long enough key, a std::runtime_error is thrown.
+	 */
+	cipher::cipher_algorithm get_fastest_aead_algorithm(size_t min_key_length = 32);
+
+	/**
+	 * \brief Get the fastest message digest algorithm for this host.
+	 * \param min_result_size The minimum digest size, in bytes.
+	 * \return The fastest message digest algorithm whose digest is at least min_result_size bytes long.
+	 *
+	 * If no message digest algorithm has a long enough digest, a std::runtime_error is thrown.
+	 */
+	hash::message_digest_algorithm get_fastest_hash_algorithm(size_t min_result_size = 32);
+
+	/**
+	 * \brief Detect the CPU features and run the self-benchmark.
+	 */
+	void _capabilities_initialize();
+
+	/**
+	 * \brief Does nothing: the rankings live until the program exits.
+	 */
+	void _capabilities_cleanup();
+
+	/**
+	 * \brief The capabilities initializer.
+	 *
+	 * Creating an instance runs the self-benchmark at once, so that the first call to get_fastest_aead_algorithm() or get_fastest_hash_algorithm() does not pay for it. Without an instance, the self-benchmark is run on the first call.
+	 *
+	 * The instance must be created after the algorithms_initializer.
+	 */
+	typedef initializer<_capabilities_initialize, _capabilities_cleanup> capabilities_initializer;
+}
+
+#endif /* CRYPTOPLUS_CAPABILITIES_HPP */
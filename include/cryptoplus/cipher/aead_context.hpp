@@ -0,0 +1,314 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file aead_context.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An AEAD cipher context class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_AEAD_CONTEXT_HPP
+#define CRYPTOPLUS_CIPHER_AEAD_CONTEXT_HPP
+
+#include "../error/cryptographic_exception.hpp"
+#include "cipher_algorithm.hpp"
+#include "cipher_context.hpp"
+
+#include <openssl/opensslv.h>
+#include <openssl/evp.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief An AEAD cipher context class.
+		 *
+		 * The aead_context class ease the computation of authenticated encryption with associated data (AEAD) ciphers, such as GCM, CCM or ChaCha20-Poly1305 (if supported by the OpenSSL version in use).
+		 *
+		 * The key schedule is computed only once by initialize(): each message then only requires a call to set_iv() or to one of the one-shot seal() and open() methods.
+		 *
+		 * CCM ciphers cannot be streamed: the whole message must be given in a single call to update(), after a call to set_message_length(). seal() and open() take care of that automatically.
+		 *
+		 * aead_context is noncopyable by design.
+		 */
+		class aead_context : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The default tag length.
+				 */
+				static const size_t default_tag_length;
+
+				/**
+				 * \brief Create a new aead_context.
+				 */
+				aead_context();
+
+				/**
+				 * \brief Destroy an aead_context.
+				 *
+				 * Calls EVP_CIPHER_CTX_cleanup() on the internal EVP_CIPHER_CTX.
+				 */
+				~aead_context();
+
+				/**
+				 * \brief Initialize the aead_context.
+				 * \param algorithm The AEAD cipher algorithm to use.
+				 * \param direction The direction of the aead_context. If a previous call to initialize() was done, you may specify cipher_context::unchanged to keep the same direction value.
+				 * \param key The key to use. Cannot be NULL.
+				 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param iv_len The length of the IVs that will be used with this context. If iv_len is 0, algorithm.iv_length() is used.
+				 * \param tag_len The length of the authentication tags.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 *
+				 * No IV is set by this call: use set_iv() before each message, or seal() and open().
+				 */
+				void initialize(const cipher_algorithm& algorithm, cipher_context::cipher_direction direction, const void* key, size_t key_len, size_t iv_len = 0, size_t tag_len = default_tag_length, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Set the IV for the next message, keeping the current key.
+				 * \param iv The IV. Cannot be NULL.
+				 * \param iv_len The length of iv. Must match iv_length() or a std::runtime_error is thrown.
+				 */
+				void set_iv(const void* iv, size_t iv_len);
+
+				/**
+				 * \brief Set the total length of the next message.
+				 * \param len The length of the message.
+				 *
+				 * This call is only required by CCM ciphers, and must be done after set_iv() and before any call to update_aad() or update().
+				 */
+				void set_message_length(size_t len);
+
+				/**
+				 * \brief Feed some additional authenticated data to the aead_context.
+				 * \param aad The additional authenticated data.
+				 * \param aad_len The length of aad.
+				 *
+				 * All the additional authenticated data must be given before the first call to update().
+				 */
+				void update_aad(const void* aad, size_t aad_len);
+
+				/**
+				 * \brief Update the aead_context with some data.
+				 * \param out The output buffer. Should be at least in_len bytes long. Cannot be NULL.
+				 * \param out_len The length of the out buffer.
+				 * \param in The input buffer.
+				 * \param in_len The length of the in buffer.
+				 * \return The count of bytes written.
+				 */
+				size_t update(void* out, size_t out_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Finalize an encryption aead_context.
+				 * \param out The output buffer. Cannot be NULL.
+				 * \param out_len The length of the out buffer.
+				 * \return The count of bytes written. For the currently supported AEAD ciphers, this is always 0.
+				 * \see get_tag
+				 */
+				size_t finalize(void* out, size_t out_len);
+
+				/**
+				 * \brief Finalize a decryption aead_context and verify the authentication tag.
+				 * \param out The output buffer. Cannot be NULL.
+				 * \param out_len The length of the out buffer.
+				 * \return true if the tag set by set_tag() matches the authenticated data, false otherwise.
+				 * \see set_tag
+				 */
+				bool verify_finalize(void* out, size_t out_len);
+
+				/**
+				 * \brief Get the authentication tag of the last encrypted message.
+				 * \param tag The output buffer. Cannot be NULL.
+				 * \param tag_len The length of tag. Must be tag_length().
+				 *
+				 * Must be called after finalize().
+				 */
+				void get_tag(void* tag, size_t tag_len);
+
+				/**
+				 * \brief Set the expected authentication tag of the message to decrypt.
+				 * \param tag The expected tag. Cannot be NULL.
+				 * \param tag_len The length of tag. Must be tag_length().
+				 *
+				 * Must be called before verify_finalize(). For CCM ciphers, it must be called before update().
+				 */
+				void set_tag(const void* tag, size_t tag_len);
+
+				/**
+				 * \brief Encrypt and authenticate a complete message in a single call.
+				 * \param out The output buffer. Must be at least in_len + tag_length() bytes long. Cannot be NULL.
+				 * \param out_len The length of the out buffer.
+				 * \param iv The IV to use. Cannot be NULL.
+				 * \param iv_len The length of iv. Must match iv_length().
+				 * \param aad The additional authenticated data. May be NULL if aad_len is 0.
+				 * \param aad_len The length of aad.
+				 * \param in The plaintext.
+				 * \param in_len The length of in.
+				 * \return The count of bytes written, that is in_len + tag_length().
+				 *
+				 * The ciphertext is written to out, immediately followed by the authentication tag.
+				 *
+				 * The aead_context must have been initialized for encryption.
+				 */
+				size_t seal(void* out, size_t out_len, const void* iv, size_t iv_len, const void* aad, size_t aad_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Decrypt and verify a complete message in a single call.
+				 * \param out The output buffer. Must be at least in_len - tag_length() bytes long. Cannot be NULL.
+				 * \param out_len The length of the out buffer.
+				 * \param iv The IV to use. Cannot be NULL.
+				 * \param iv_len The length of iv. Must match iv_length().
+				 * \param aad The additional authenticated data. May be NULL if aad_len is 0.
+				 * \param aad_len The length of aad.
+				 * \param in The ciphertext, immediately followed by the authentication tag, as produced by seal().
+				 * \param in_len The length of in. Must be at least tag_length().
+				 * \return true if the message is authentic, false otherwise. On success, in_len - tag_length() bytes were written to out. On failure, out is cleared.
+				 *
+				 * The aead_context must have been initialized for decryption.
+				 */
+				bool open(void* out, size_t out_len, const void* iv, size_t iv_len, const void* aad, size_t aad_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Get the IV length.
+				 * \return The IV length.
+				 */
+				size_t iv_length() const;
+
+				/**
+				 * \brief Get the tag length.
+				 * \return The tag length.
+				 */
+				size_t tag_length() const;
+
+				/**
+				 * \brief Get the underlying context.
+				 * \return The underlying context.
+				 * \warning This method is provided for compatibility issues only. Its use is greatly discouraged.
+				 */
+				EVP_CIPHER_CTX& raw();
+
+				/**
+				 * \brief Get the associated cipher algorithm.
+				 * \return The associated cipher algorithm. If no call to initialize was done, the behavior is undefined.
+				 */
+				cipher_algorithm algorithm() const;
+
+			private:
+
+				bool is_ccm() const;
+
+				EVP_CIPHER_CTX m_ctx;
+				size_t m_iv_len;
+				size_t m_tag_len;
+		};
+
+		inline aead_context::aead_context() :
+			m_iv_len(0),
+			m_tag_len(default_tag_length)
+		{
+			EVP_CIPHER_CTX_init(&m_ctx);
+		}
+
+		inline aead_context::~aead_context()
+		{
+			EVP_CIPHER_CTX_cleanup(&m_ctx);
+		}
+
+		inline void aead_context::set_iv(const void* iv, size_t iv_len)
+		{
+			if (iv_len != m_iv_len)
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			error::throw_error_if_not(EVP_CipherInit_ex(&m_ctx, NULL, NULL, NULL, static_cast<const unsigned char*>(iv), -1) != 0);
+		}
+
+		inline void aead_context::set_message_length(size_t len)
+		{
+			int outl = 0;
+
+			error::throw_error_if_not(EVP_CipherUpdate(&m_ctx, NULL, &outl, NULL, static_cast<int>(len)) != 0);
+		}
+
+		inline void aead_context::update_aad(const void* aad, size_t aad_len)
+		{
+			int outl = 0;
+
+			error::throw_error_if_not(EVP_CipherUpdate(&m_ctx, NULL, &outl, static_cast<const unsigned char*>(aad), static_cast<int>(aad_len)) != 0);
+		}
+
+		inline size_t aead_context::iv_length() const
+		{
+			return m_iv_len;
+		}
+
+		inline size_t aead_context::tag_length() const
+		{
+			return m_tag_len;
+		}
+
+		inline EVP_CIPHER_CTX& aead_context::raw()
+		{
+			return m_ctx;
+		}
+
+		inline cipher_algorithm aead_context::algorithm() const
+		{
+			return cipher_algorithm(EVP_CIPHER_CTX_cipher(&m_ctx));
+		}
+
+		inline bool aead_context::is_ccm() const
+		{
+			return (EVP_CIPHER_CTX_mode(&m_ctx) == EVP_CIPH_CCM_MODE);
+		}
+	}
+}
+
+#endif
+
+#endif /* CRYPTOPLUS_CIPHER_AEAD_CONTEXT_HPP */
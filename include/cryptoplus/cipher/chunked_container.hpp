@@ -0,0 +1,266 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file chunked_container.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A seekable, chunked, authenticated encryption container format.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_CHUNKED_CONTAINER_HPP
+#define CRYPTOPLUS_CIPHER_CHUNKED_CONTAINER_HPP
+
+#include "cipher_algorithm.hpp"
+#include "aead_context.hpp"
+#include "nonce_source.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/function.hpp>
+#include <boost/cstdint.hpp>
+
+#include <vector>
+#include <cstddef>
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief The chunked container format constants.
+		 *
+		 * A chunked container is made of a header followed by fixed-size sealed chunks:
+		 *
+		 * - The header (header_size bytes) holds a magic, a version, the chunk size, the plaintext size and the algorithm type.
+		 * - Each chunk holds a unique nonce (nonce_size bytes), up to chunk_size bytes of ciphertext and a tag (tag_size bytes). Only the last chunk may be shorter.
+		 *
+		 * Every chunk is authenticated along with the header and its own index, so chunks cannot be reordered, truncated or moved to another container. Since all the chunks but the last one have the same size, the position of any chunk can be computed and the container needs no explicit index.
+		 *
+		 * An empty plaintext still gets one empty chunk, so that the header is always authenticated.
+		 */
+		struct chunked_container
+		{
+			static const size_t header_size = 32; /**< \brief The header size. */
+			static const size_t nonce_size = 12; /**< \brief The nonce size of each chunk. */
+			static const size_t tag_size = 16; /**< \brief The tag size of each chunk. */
+			static const size_t default_chunk_size = 64 * 1024; /**< \brief The default chunk size. */
+			static const size_t max_chunk_size = 16 * 1024 * 1024; /**< \brief The maximum chunk size. */
+
+			/**
+			 * \brief Get the count of chunks for a given plaintext size.
+			 * \param chunk_size The chunk size.
+			 * \param plaintext_size The plaintext size.
+			 * \return The count of chunks.
+			 */
+			static boost::uint64_t chunks_count(size_t chunk_size, boost::uint64_t plaintext_size);
+
+			/**
+			 * \brief Get the container size for a given plaintext size.
+			 * \param chunk_size The chunk size.
+			 * \param plaintext_size The plaintext size.
+			 * \return The container size.
+			 */
+			static boost::uint64_t container_size(size_t chunk_size, boost::uint64_t plaintext_size);
+		};
+
+		/**
+		 * \brief A chunked container writer.
+		 *
+		 * The chunks are sealed in parallel. The algorithm must be an AEAD cipher that accepts 12 bytes nonces, such as AES-GCM or ChaCha20-Poly1305.
+		 *
+		 * The nonces are random, from a nonce_source in random mode: unlike counter-based nonces, they remain unique in a child process created by fork(), which shares the writer of its parent. As for any random 96 bits nonce, do not seal more than 2^32 chunks with the same key (NIST SP 800-38D, section 8.3).
+		 *
+		 * \see chunked_container
+		 */
+		class chunked_writer : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief Create a new chunked_writer.
+				 * \param algorithm The AEAD algorithm.
+				 * \param key The key. Cannot be NULL.
+				 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param chunk_size The chunk size. Must be between 1 and chunked_container::max_chunk_size or a std::runtime_error is thrown.
+				 */
+				chunked_writer(const cipher_algorithm& algorithm, const void* key, size_t key_len, size_t chunk_size = chunked_container::default_chunk_size);
+
+				/**
+				 * \brief Get the container size for a given plaintext size.
+				 * \param plaintext_size The plaintext size.
+				 * \return The container size.
+				 */
+				size_t sealed_size(size_t plaintext_size) const;
+
+				/**
+				 * \brief Seal a plaintext into a container.
+				 * \param out The output buffer. Must be at least sealed_size(in_len) bytes long.
+				 * \param out_len The length of out.
+				 * \param in The plaintext.
+				 * \param in_len The length of in.
+				 * \param thread_count The maximum count of threads to use, including the calling thread. 0, the default, means one thread per hardware thread.
+				 * \return The count of bytes written to out.
+				 *
+				 * With OpenSSL versions prior to 1.1.0, a threading_initializer must exist while this method runs.
+				 */
+				size_t seal(void* out, size_t out_len, const void* in, size_t in_len, unsigned int thread_count = 0) const;
+
+				/**
+				 * \brief Seal a plaintext into a container.
+				 * \param in The plaintext.
+				 * \param in_len The length of in.
+				 * \param thread_count The maximum count of threads to use, including the calling thread.
+				 * \return The container.
+				 */
+				template <typename T>
+				std::vector<T> seal(const void* in, size_t in_len, unsigned int thread_count = 0) const;
+
+			private:
+
+				cipher_algorithm m_algorithm;
+				std::vector<unsigned char> m_key;
+				size_t m_chunk_size;
+				nonce_source m_nonces;
+		};
+
+		/**
+		 * \brief A chunked container reader.
+		 *
+		 * The reader only fetches and decrypts the chunks that a read touches. The last decrypted chunk is cached, so that small sequential reads do not decrypt the same chunk twice.
+		 *
+		 * chunked_reader is not thread-safe: use one reader per thread.
+		 *
+		 * \see chunked_container
+		 */
+		class chunked_reader : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief A source type.
+				 *
+				 * A source is called with an offset, a buffer and a length and must fill the buffer with the container bytes at that offset, or throw.
+				 */
+				typedef boost::function<void (boost::uint64_t, void*, size_t)> source_type;
+
+				/**
+				 * \brief Create a new chunked_reader over a source.
+				 * \param algorithm The AEAD algorithm.
+				 * \param key The key. Cannot be NULL.
+				 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param source The container source.
+				 *
+				 * The header is read and checked immediately. It is only authenticated when the first chunk is read.
+				 */
+				chunked_reader(const cipher_algorithm& algorithm, const void* key, size_t key_len, const source_type& source);
+
+				/**
+				 * \brief Create a new chunked_reader over a memory buffer.
+				 * \param algorithm The AEAD algorithm.
+				 * \param key The key. Cannot be NULL.
+				 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param buf The container. Must remain valid during the lifetime of the reader.
+				 * \param buf_len The length of buf.
+				 */
+				chunked_reader(const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* buf, size_t buf_len);
+
+				/**
+				 * \brief Get the plaintext size.
+				 * \return The plaintext size.
+				 */
+				boost::uint64_t size() const;
+
+				/**
+				 * \brief Get the chunk size.
+				 * \return The chunk size.
+				 */
+				size_t chunk_size() const;
+
+				/**
+				 * \brief Read and decrypt a range of the plaintext.
+				 * \param out The output buffer. Must be at least len bytes long.
+				 * \param len The count of bytes to read.
+				 * \param offset The plaintext offset to read from.
+				 * \return The count of bytes read, which is only lower than len at the end of the plaintext.
+				 *
+				 * If a touched chunk fails authentication, a std::runtime_error is thrown and out is cleared.
+				 */
+				size_t read_at(void* out, size_t len, boost::uint64_t offset);
+
+			private:
+
+				void read_header();
+				const std::vector<unsigned char>& get_chunk(boost::uint64_t index);
+
+				aead_context m_ctx;
+				source_type m_source;
+				unsigned char m_header[chunked_container::header_size];
+				size_t m_chunk_size;
+				boost::uint64_t m_size;
+				std::vector<unsigned char> m_sealed_chunk;
+				std::vector<unsigned char> m_chunk;
+				boost::uint64_t m_chunk_index;
+				bool m_chunk_valid;
+		};
+
+		template <typename T>
+		inline std::vector<T> chunked_writer::seal(const void* in, size_t in_len, unsigned int thread_count) const
+		{
+			std::vector<T> result(sealed_size(in_len));
+
+			seal(&result[0], result.size(), in, in_len, thread_count);
+
+			return result;
+		}
+
+		inline boost::uint64_t chunked_reader::size() const
+		{
+			return m_size;
+		}
+
+		inline size_t chunked_reader::chunk_size() const
+		{
+			return m_chunk_size;
+		}
+	}
+}
+
+#endif
+
+#endif /* CRYPTOPLUS_CIPHER_CHUNKED_CONTAINER_HPP */
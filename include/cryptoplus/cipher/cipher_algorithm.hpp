@@ -80,6 +80,8 @@ namespace cryptoplus
 				 * \brief Create a new cipher_algorithm from its type (NID).
 				 * \param type The type of the cipher_algorithm to create.
 				 * \warning If no such type is found, a std::invalid_argument is thrown.
+				 *
+				 * Once an algorithms_initializer exists, the lookup does not call into OpenSSL.
 				 */
 				explicit cipher_algorithm(int type);
 
@@ -87,6 +89,8 @@ namespace cryptoplus
 				 * \brief Create a new cipher_algorithm from its name.
 				 * \param name The name of the cipher_algorithm to create.
 				 * \warning If no such name is found, a std::invalid_argument is thrown.
+				 *
+				 * Once an algorithms_initializer exists, the lookup does not call into OpenSSL.
 				 */
 				explicit cipher_algorithm(const std::string& name);
 
@@ -140,12 +144,17 @@ namespace cryptoplus
 
 			private:
 
+				void set_cipher(const EVP_CIPHER* cipher);
+
 				const EVP_CIPHER* m_cipher;
+				size_t m_block_size;
+				size_t m_key_length;
+				size_t m_iv_length;
 		};
 
-		inline cipher_algorithm::cipher_algorithm(const EVP_CIPHER* cipher) :
-			m_cipher(cipher)
+		inline cipher_algorithm::cipher_algorithm(const EVP_CIPHER* cipher)
 		{
+			set_cipher(cipher);
 		}
 
 		inline const EVP_CIPHER* cipher_algorithm::raw() const
@@ -165,17 +174,17 @@ namespace cryptoplus
 
 		inline size_t cipher_algorithm::block_size() const
 		{
-			return EVP_CIPHER_block_size(m_cipher);
+			return m_block_size;
 		}
 
 		inline size_t cipher_algorithm::key_length() const
 		{
-			return EVP_CIPHER_key_length(m_cipher);
+			return m_key_length;
 		}
 
 		inline size_t cipher_algorithm::iv_length() const
 		{
-			return EVP_CIPHER_iv_length(m_cipher);
+			return m_iv_length;
 		}
 
 		inline unsigned long cipher_algorithm::flags() const
@@ -187,6 +196,24 @@ namespace cryptoplus
 		{
 			return EVP_CIPHER_mode(m_cipher);
 		}
+
+		inline void cipher_algorithm::set_cipher(const EVP_CIPHER* cipher)
+		{
+			m_cipher = cipher;
+
+			if (m_cipher)
+			{
+				m_block_size = EVP_CIPHER_block_size(m_cipher);
+				m_key_length = EVP_CIPHER_key_length(m_cipher);
+				m_iv_length = EVP_CIPHER_iv_length(m_cipher);
+			}
+			else
+			{
+				m_block_size = 0;
+				m_key_length = 0;
+				m_iv_length = 0;
+			}
+		}
 	}
 }
 
@@ -0,0 +1,191 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file cipher_batch.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A batch cipher class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_CIPHER_BATCH_HPP
+#define CRYPTOPLUS_CIPHER_CIPHER_BATCH_HPP
+
+#include "cipher_algorithm.hpp"
+#include "cipher_context.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief A batch cipher class.
+		 *
+		 * The cipher_batch class encrypts or decrypts many small independent messages that share the same key, using a single key schedule.
+		 *
+		 * For counter mode (CTR) ciphers, the keystream blocks of several messages are computed together in a single ECB call: this lets OpenSSL pipeline the blocks of different messages (for instance using AES-NI) instead of processing a handful of blocks per call.
+		 *
+		 * For the other modes, each message only resets the IV of an already keyed context: the key schedule is never recomputed.
+		 *
+		 * cipher_batch is noncopyable by design.
+		 */
+		class cipher_batch : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief A message descriptor.
+				 */
+				struct message
+				{
+					/**
+					 * \brief The IV. Must be algorithm().iv_length() bytes long. Can be NULL if the algorithm does not need one.
+					 */
+					const void* iv;
+
+					/**
+					 * \brief The input buffer.
+					 */
+					const void* in;
+
+					/**
+					 * \brief The length of in.
+					 */
+					size_t in_len;
+
+					/**
+					 * \brief The output buffer. Should be at least in_len + algorithm().block_size() bytes long. Cannot be NULL.
+					 */
+					void* out;
+
+					/**
+					 * \brief The length of out.
+					 */
+					size_t out_len;
+
+					/**
+					 * \brief The count of bytes written to out. Set by process().
+					 */
+					size_t result;
+				};
+
+				/**
+				 * \brief Create a new cipher_batch.
+				 */
+				cipher_batch();
+
+				/**
+				 * \brief Initialize the cipher_batch.
+				 * \param algorithm The cipher algorithm to use.
+				 * \param direction The direction of the cipher_batch.
+				 * \param key The key to use. Cannot be NULL.
+				 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 *
+				 * The key schedule is computed once, here.
+				 */
+				void initialize(const cipher_algorithm& algorithm, cipher_context::cipher_direction direction, const void* key, size_t key_len, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Set PKCS padding state.
+				 * \param enabled If enabled is true, PKCS padding will be enabled.
+				 *
+				 * The padding state applies to every message. It has no effect on stream modes such as CTR.
+				 */
+				void set_padding(bool enabled);
+
+				/**
+				 * \brief Process a batch of messages.
+				 * \param messages The messages. The result member of each message is updated.
+				 * \param messages_count The count of messages.
+				 */
+				void process(message* messages, size_t messages_count);
+
+				/**
+				 * \brief Process a batch of messages.
+				 * \param messages The messages. The result member of each message is updated.
+				 */
+				void process(std::vector<message>& messages);
+
+				/**
+				 * \brief Get the associated cipher algorithm.
+				 * \return The associated cipher algorithm. If no call to initialize was done, the behavior is undefined.
+				 */
+				cipher_algorithm algorithm() const;
+
+			private:
+
+				void process_ctr(message* messages, size_t messages_count);
+
+				cipher_context m_ctx;
+				cipher_context m_keystream_ctx;
+				bool m_use_keystream;
+				std::vector<unsigned char> m_counters;
+				std::vector<unsigned char> m_keystream;
+		};
+
+		inline cipher_batch::cipher_batch() :
+			m_use_keystream(false)
+		{
+		}
+
+		inline void cipher_batch::set_padding(bool enabled)
+		{
+			m_ctx.set_padding(enabled);
+		}
+
+		inline void cipher_batch::process(std::vector<message>& messages)
+		{
+			if (!messages.empty())
+			{
+				process(&messages[0], messages.size());
+			}
+		}
+
+		inline cipher_algorithm cipher_batch::algorithm() const
+		{
+			return m_ctx.algorithm();
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_CIPHER_BATCH_HPP */
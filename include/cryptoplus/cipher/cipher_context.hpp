@@ -50,7 +50,7 @@
 
 #include <openssl/evp.h>
 
-#include <boost/noncopyable.hpp>
+#include <boost/move/move.hpp>
 
 #include <vector>
 #include <cstring>
@@ -71,10 +71,12 @@ namespace cryptoplus
 		 *
 		 * The list of the available cipher methods depends on the version of OpenSSL and can be found on the man page of EVP_EncryptInit().
 		 *
-		 * cipher_context is noncopyable by design.
+		 * cipher_context is noncopyable by design but is movable, using Boost.Move: the OpenSSL state, including the key schedule, is transferred and not recomputed. A moved-from cipher_context is left uninitialized. In C++03, move-only types can be stored in a boost::container::vector.
 		 */
-		class cipher_context : public boost::noncopyable
+		class cipher_context
 		{
+			BOOST_MOVABLE_BUT_NOT_COPYABLE(cipher_context)
+
 			public:
 
 				/**
@@ -99,6 +101,19 @@ namespace cryptoplus
 				 */
 				~cipher_context();
 
+				/**
+				 * \brief Move constructor.
+				 * \param other The cipher_context to move from. It is left uninitialized.
+				 */
+				cipher_context(BOOST_RV_REF(cipher_context) other);
+
+				/**
+				 * \brief Move assignment operator.
+				 * \param other The cipher_context to move from. It is left uninitialized.
+				 * \return *this.
+				 */
+				cipher_context& operator=(BOOST_RV_REF(cipher_context) other);
+
 				/**
 				 * \brief Initialize the cipher_context.
 				 * \param algorithm The cipher algorithm to use.
@@ -142,6 +157,35 @@ namespace cryptoplus
 				 */
 				std::vector<unsigned char> seal_initialize(const cipher_algorithm& algorithm, void* iv, size_t iv_len, pkey::pkey pkey);
 
+				/**
+				 * \brief Initialize the cipher_context for envelope sealing, wrapping the shared secret key for several recipients concurrently.
+				 * \param algorithm The cipher algorithm to use.
+				 * \param iv The iv that was generated (if one is needed for the specified algorithm, NULL otherwise).
+				 * \param iv_len The length of iv. Must match algorithm.iv_length() or a std::runtime_error is thrown.
+				 * \param pkeys The public pkeys to use.
+				 * \param pkeys_count The count of public pkeys.
+				 * \param ek The buffer that receives all the public encrypted shared secret keys. The key for pkeys[i] is written at the offset seal_arena_size(pkeys, i). Must be at least seal_arena_size(pkeys, pkeys_count) bytes long.
+				 * \param ek_len The length of ek.
+				 * \param ekl An array of pkeys_count values that receives the length of each public encrypted shared secret key.
+				 * \param thread_count The maximum count of threads to use, including the calling thread. 0, the default, means one thread per hardware thread.
+				 * \see seal_arena_size
+				 * \see seal_update
+				 * \see seal_finalize
+				 *
+				 * The envelope is the same as with the other seal_initialize() overloads, but nothing is allocated per recipient and the public key operations run in parallel.
+				 *
+				 * With OpenSSL versions prior to 1.1.0, a threading_initializer must exist while this method runs.
+				 */
+				void seal_initialize(const cipher_algorithm& algorithm, void* iv, size_t iv_len, const pkey::pkey* pkeys, size_t pkeys_count, void* ek, size_t ek_len, size_t* ekl, unsigned int thread_count = 0);
+
+				/**
+				 * \brief Get the buffer size needed to hold the public encrypted shared secret keys for the specified public pkeys.
+				 * \param pkeys The public pkeys.
+				 * \param pkeys_count The count of public pkeys.
+				 * \return The buffer size.
+				 */
+				static size_t seal_arena_size(const pkey::pkey* pkeys, size_t pkeys_count);
+
 				/**
 				 * \brief Initialize the cipher_context for envelope opening.
 				 * \param algorithm The cipher algorithm to use.
@@ -155,6 +199,23 @@ namespace cryptoplus
 				 */
 				void open_initialize(const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, pkey::pkey pkey);
 
+				/**
+				 * \brief Make this cipher_context a copy of another one.
+				 * \param other The cipher_context to copy. Must have been initialized.
+				 *
+				 * The key schedule is copied as well: this is much cheaper than calling initialize() again with the same key.
+				 */
+				void copy(const cipher_context& other);
+
+				/**
+				 * \brief Set a new IV, keeping the current algorithm, direction and key.
+				 * \param iv The new IV. Cannot be NULL.
+				 * \param iv_len The length of iv. Must match algorithm().iv_length() or a std::runtime_error is thrown.
+				 *
+				 * The key schedule is not recomputed.
+				 */
+				void set_iv(const void* iv, size_t iv_len);
+
 				/**
 				 * \brief Set PKCS padding state.
 				 * \param enabled If enabled is true, PKCS padding will be enabled.
@@ -177,6 +238,8 @@ namespace cryptoplus
 				 * \param buf_len The length of buf.
 				 * \param max_buf_len The maximum length of buf. Should be at least ((buf_len / algorithm().block_size()) + 1) * algorithm().block_size().
 				 * \return The new size of the buffer.
+				 *
+				 * The random bytes are taken from random::get_buffered_random_bytes().
 				 */
 				size_t add_iso_10126_padding(void* buf, size_t buf_len, size_t max_buf_len) const;
 
@@ -189,11 +252,26 @@ namespace cryptoplus
 				template <typename T>
 				std::vector<T> get_iso_10126_padded_buffer(const void* buf, size_t buf_len) const;
 
+				/**
+				 * \brief Pad several buffers using the ISO 10126 padding.
+				 * \param bufs The buffers.
+				 * \param buf_lens The lengths of the buffers.
+				 * \param max_buf_lens The maximum lengths of the buffers. See add_iso_10126_padding().
+				 * \param results An array of count values that receives the new size of each buffer.
+				 * \param count The count of buffers.
+				 *
+				 * All the sizes are checked before any buffer is modified. The random bytes for all the buffers are drawn at once.
+				 */
+				void add_iso_10126_padding(void* const* bufs, const size_t* buf_lens, const size_t* max_buf_lens, size_t* results, size_t count) const;
+
 				/**
 				 * \brief Verify the given buffer and check if it matches ISO 10126 padding.
 				 * \param buf The buffer.
 				 * \param buf_len The length of buf, including its padding. Should be a multiple of algorithm().block_size().
 				 * \return The size of the data, without any padding.
+				 * \see verify_padding
+				 *
+				 * To verify many buffers in constant time and without exceptions, use verify_padding() instead.
 				 */
 				size_t verify_iso_10126_padding(const void* buf, size_t buf_len) const;
 
@@ -317,6 +395,25 @@ namespace cryptoplus
 			EVP_CIPHER_CTX_cleanup(&m_ctx);
 		}
 
+		inline cipher_context::cipher_context(BOOST_RV_REF(cipher_context) other)
+		{
+			// The OpenSSL context only points to heap-allocated state: a bitwise copy transfers it.
+			std::memcpy(&m_ctx, &other.m_ctx, sizeof(m_ctx));
+			EVP_CIPHER_CTX_init(&other.m_ctx);
+		}
+
+		inline cipher_context& cipher_context::operator=(BOOST_RV_REF(cipher_context) other)
+		{
+			if (this != &other)
+			{
+				EVP_CIPHER_CTX_cleanup(&m_ctx);
+				std::memcpy(&m_ctx, &other.m_ctx, sizeof(m_ctx));
+				EVP_CIPHER_CTX_init(&other.m_ctx);
+			}
+
+			return *this;
+		}
+
 		template <typename T>
 		inline std::vector<std::vector<unsigned char> > cipher_context::seal_initialize(const cipher_algorithm& _algorithm, void* iv, size_t iv_len, T pkeys_begin, T pkeys_end)
 		{
@@ -46,6 +46,11 @@
 #define CRYPTOPLUS_CIPHER_CIPHER_STREAM_HPP
 
 #include "cipher_context.hpp"
+#include "../bio/bio_ptr.hpp"
+#include "../file.hpp"
+
+#include <boost/shared_array.hpp>
+#include <boost/function.hpp>
 
 #include <vector>
 #include <cstring>
@@ -59,7 +64,11 @@ namespace cryptoplus
 		 *
 		 * The cipher_stream class ease the computation of a cipher, using a stream oriented interface.
 		 *
-		 * To work with cipher_stream, call the initialize() method like you would do on a cipher_context, call append() or operator<<() as long as you have data to cipher then call finalize(). The resulting ciphered buffer can be get by calling result().
+		 * To work with cipher_stream, call the initialize() method like you would do on a cipher_context, call append() or operator<<() as long as you have data to cipher then call finalize(). The ciphered data is then read with buffers().
+		 *
+		 * The output is kept in a chain of segments that are never zero-filled nor moved: when a segment is full, a new one, twice as big as the biggest one so far, is allocated. buffers() lists these segments without copying them. result() is a convenience that copies the whole output into a single contiguous buffer.
+		 *
+		 * Alternatively, a sink can be set with set_sink(): the output is then pushed to the sink as soon as it is produced, using a fixed-size scratch buffer, and the stream memory usage does not depend on the input size anymore.
 		 *
 		 * The list of the available cipher methods depends on the version of OpenSSL and can be found on the man page of EVP_EncryptInit().
 		 *
@@ -81,6 +90,32 @@ namespace cryptoplus
 				using cipher_context::ctrl_set;
 				using cipher_context::algorithm;
 
+				/**
+				 * \brief A read-only buffer.
+				 */
+				struct const_buffer
+				{
+					const unsigned char* data; /**< \brief The data. */
+					size_t size; /**< \brief The size of data. */
+				};
+
+				/**
+				 * \brief The minimum size of the segments allocated when the stream grows.
+				 */
+				static const size_t min_segment_size = 64 * 1024;
+
+				/**
+				 * \brief The default scratch buffer size, in sink mode.
+				 */
+				static const size_t default_scratch_size = 16 * 1024;
+
+				/**
+				 * \brief A sink type.
+				 *
+				 * A sink is called with every produced output range. It should throw on failure.
+				 */
+				typedef boost::function<void (const void*, size_t)> sink_type;
+
 				/**
 				 * \brief Create a new cipher stream.
 				 * \param alloc The minimum number of bytes to pre-allocate. A good value here is the count of bytes to cipher + cipher algorithm block size.
@@ -90,6 +125,30 @@ namespace cryptoplus
 				 */
 				explicit cipher_stream(size_t alloc);
 
+				/**
+				 * \brief Push the output to a sink instead of buffering it.
+				 * \param sink The sink. If sink is empty, the stream goes back to buffering its output.
+				 * \param scratch_size The size of the scratch buffer. The input is ciphered by chunks of at most scratch_size bytes.
+				 * \warning Avoid changing the sink while a encrypt/decrypt sequence is pending.
+				 *
+				 * In sink mode, buffers() and result() are always empty. The sink gets at most scratch_size + EVP_MAX_BLOCK_LENGTH bytes at once. If the sink throws, append() or finalize() throws too and the pending sequence is lost: initialize() must be called again.
+				 */
+				void set_sink(const sink_type& sink, size_t scratch_size = default_scratch_size);
+
+				/**
+				 * \brief Push the output to a BIO instead of buffering it.
+				 * \param bio The BIO to write to. A cryptographic_exception is thrown if a write fails.
+				 * \param scratch_size The size of the scratch buffer.
+				 */
+				void set_sink(bio::bio_ptr bio, size_t scratch_size = default_scratch_size);
+
+				/**
+				 * \brief Push the output to a file instead of buffering it.
+				 * \param f The file to write to. A std::runtime_error is thrown if a write fails.
+				 * \param scratch_size The size of the scratch buffer.
+				 */
+				void set_sink(file f, size_t scratch_size = default_scratch_size);
+
 				/**
 				 * \brief Append data to the stream.
 				 * \param buf The data to append to the stream.
@@ -119,27 +178,65 @@ namespace cryptoplus
 				void finalize();
 
 				/**
-				 * \brief Reallocate the internal buffer.
+				 * \brief Reserve some output space.
 				 * \param alloc The minimum number of bytes to pre-allocate. A good value here is the count of bytes to cipher + cipher algorithm block size.
-				 * \warning Avoid reallocations while a encrypt/decrypt sequence is pending. At any time, if the streams needs more output space, it will automatically reallocate() the underlying buffer.
+				 *
+				 * The already written data is never moved. At any time, if the streams needs more output space, it will automatically allocate a new segment.
 				 */
 				void reallocate(size_t alloc);
 
 				/**
-				 * \brief Get the result buffer.
+				 * \brief Get the result, as a list of buffers.
+				 * \return The result buffers, in order. The buffers remain valid until the next call to append() following a finalize(), or until the cipher_stream is destroyed.
+				 * \warning Be sure to call finalize() before calling this method.
+				 * \see finalize()
+				 *
+				 * This is the way to read the result: the buffers point to the output segments, which are not copied.
+				 */
+				std::vector<const_buffer> buffers() const;
+
+				/**
+				 * \brief Get the size of the result.
+				 * \return The total size of the result buffers.
+				 */
+				size_t size() const;
+
+				/**
+				 * \brief Get a copy of the result, as a single buffer.
 				 * \return The result buffer.
 				 * \warning Be sure to call finalize() before calling this method.
 				 * \see finalize()
+				 * \see buffers()
+				 *
+				 * The output segments are copied into a single buffer, which is kept until the stream changes. This copy doubles the memory used by the output: prefer buffers() for large outputs.
 				 */
 				const std::vector<unsigned char>& result() const;
 
 			private:
 
+				struct segment
+				{
+					boost::shared_array<unsigned char> data;
+					size_t capacity;
+					size_t size;
+				};
+
 				using cipher_context::update;
 				using cipher_context::finalize;
 
-				std::vector<unsigned char> m_buffer;
-				size_t m_offset;
+				void reset();
+				segment& output_segment(size_t len, size_t capacity);
+				void sink_append(const unsigned char* buf, size_t buf_len);
+				size_t growth_capacity() const;
+
+				std::vector<segment> m_segments;
+				size_t m_current;
+				size_t m_max_capacity;
+				bool m_finalized;
+				mutable std::vector<unsigned char> m_result;
+				mutable bool m_result_valid;
+				sink_type m_sink;
+				std::vector<unsigned char> m_scratch;
 		};
 
 		/**
@@ -152,8 +249,9 @@ namespace cryptoplus
 		cipher_stream& operator<<(cipher_stream& cs, const T& value);
 
 		inline cipher_stream::cipher_stream(size_t alloc) :
-			m_buffer(alloc), m_offset(0)
+			m_current(0), m_max_capacity(0), m_finalized(false), m_result_valid(false)
 		{
+			reallocate(alloc);
 		}
 
 		inline cipher_stream& cipher_stream::append(const char* cstr)
@@ -168,12 +266,10 @@ namespace cryptoplus
 
 		inline void cipher_stream::reallocate(size_t alloc)
 		{
-			m_buffer.resize(alloc);
-		}
-
-		inline const std::vector<unsigned char>& cipher_stream::result() const
-		{
-			return m_buffer;
+			if (alloc > 0)
+			{
+				output_segment(alloc, alloc);
+			}
 		}
 
 		template <typename T>
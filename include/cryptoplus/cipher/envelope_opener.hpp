@@ -0,0 +1,153 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file envelope_opener.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An envelope opener class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_ENVELOPE_OPENER_HPP
+#define CRYPTOPLUS_CIPHER_ENVELOPE_OPENER_HPP
+
+#include "envelope_session.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief Open messages sealed by an envelope_session.
+		 *
+		 * Each wrapped data key is unwrapped once, by add_key(), and kept until remove_key() is called. Opening a message only involves symmetric operations.
+		 *
+		 * open() can be called concurrently from different threads, as long as no key is added or removed at the same time.
+		 */
+		class envelope_opener : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The key identifier type.
+				 */
+				typedef envelope_session::key_id_type key_id_type;
+
+				/**
+				 * \brief Create a new envelope_opener.
+				 * \param algorithm The cipher algorithm to use. Must match the one of the envelope_session.
+				 */
+				explicit envelope_opener(const cipher_algorithm& algorithm);
+
+				/**
+				 * \brief Unwrap a data key and register it.
+				 * \param key_id The identifier of the data key.
+				 * \param wrapped_key The wrapped data key.
+				 * \param wrapped_key_len The length of wrapped_key.
+				 * \param pkey The private key of the recipient.
+				 *
+				 * If a data key with the same identifier is already registered, it is replaced.
+				 */
+				void add_key(const key_id_type& key_id, const void* wrapped_key, size_t wrapped_key_len, const pkey::pkey& pkey);
+
+				/**
+				 * \brief Check if a data key is registered.
+				 * \param key_id The identifier of the data key.
+				 * \return true if the data key is registered.
+				 */
+				bool has_key(const key_id_type& key_id) const;
+
+				/**
+				 * \brief Forget a data key.
+				 * \param key_id The identifier of the data key.
+				 */
+				void remove_key(const key_id_type& key_id);
+
+				/**
+				 * \brief Open a message.
+				 * \param out The output buffer. Must be at least in_len bytes long.
+				 * \param out_len The length of out.
+				 * \param in The sealed message.
+				 * \param in_len The length of in.
+				 * \return The count of bytes written to out.
+				 *
+				 * If the message references an unknown data key, a std::runtime_error is thrown.
+				 */
+				size_t open(void* out, size_t out_len, const void* in, size_t in_len) const;
+
+				/**
+				 * \brief Get the associated cipher algorithm.
+				 * \return The associated cipher algorithm.
+				 */
+				cipher_algorithm algorithm() const;
+
+			private:
+
+				typedef std::map<key_id_type, boost::shared_ptr<keyed_cipher> > cipher_map;
+
+				cipher_algorithm m_algorithm;
+				cipher_map m_ciphers;
+		};
+
+		inline envelope_opener::envelope_opener(const cipher_algorithm& _algorithm) :
+			m_algorithm(_algorithm)
+		{
+		}
+
+		inline bool envelope_opener::has_key(const key_id_type& key_id) const
+		{
+			return (m_ciphers.find(key_id) != m_ciphers.end());
+		}
+
+		inline void envelope_opener::remove_key(const key_id_type& key_id)
+		{
+			m_ciphers.erase(key_id);
+		}
+
+		inline cipher_algorithm envelope_opener::algorithm() const
+		{
+			return m_algorithm;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_ENVELOPE_OPENER_HPP */
@@ -0,0 +1,267 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file envelope_session.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An envelope encryption session class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_ENVELOPE_SESSION_HPP
+#define CRYPTOPLUS_CIPHER_ENVELOPE_SESSION_HPP
+
+#include "cipher_algorithm.hpp"
+#include "keyed_cipher.hpp"
+#include "../pkey/pkey.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/array.hpp>
+#include <boost/cstdint.hpp>
+
+#include <vector>
+#include <ctime>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief An envelope encryption session.
+		 *
+		 * An envelope_session generates a random data key and wraps it once for a set of recipients. The data key is then reused to seal many messages, each one with a fresh random IV, until either max_messages messages were sealed or max_age seconds elapsed. At that point, a new data key is generated and wrapped.
+		 *
+		 * A sealed message is: key_id() || IV || ciphertext. The wrapped keys are not part of the messages: they must be sent to the recipients once per key, for instance from the rotation handler. Recipients use an envelope_opener to open the messages.
+		 *
+		 * The wrapped keys are compatible with the ones produced by cipher_context::seal_initialize().
+		 *
+		 * AEAD algorithms are not supported.
+		 *
+		 * An envelope_session is not thread-safe.
+		 */
+		class envelope_session : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The key identifier length.
+				 */
+				static const size_t key_id_length = 16;
+
+				/**
+				 * \brief The key identifier type.
+				 */
+				typedef boost::array<unsigned char, key_id_length> key_id_type;
+
+				/**
+				 * \brief The rotation handler type.
+				 */
+				typedef boost::function<void (const envelope_session&)> rotation_handler_type;
+
+				/**
+				 * \brief The default maximum count of messages sealed with the same data key.
+				 */
+				static const boost::uint64_t default_max_messages = 1 << 20;
+
+				/**
+				 * \brief The default maximum age of a data key, in seconds.
+				 */
+				static const unsigned int default_max_age = 3600;
+
+				/**
+				 * \brief Create a new envelope_session.
+				 * \param algorithm The cipher algorithm to use.
+				 * \param pkeys The public keys of the recipients. Cannot be NULL.
+				 * \param pkeys_count The count of public keys. Cannot be 0.
+				 * \param max_messages The maximum count of messages to seal with the same data key. 0 means no limit.
+				 * \param max_age The maximum age of a data key, in seconds. 0 means no limit.
+				 * \param thread_count The maximum count of threads to use to wrap the data keys. 0 means one per hardware thread.
+				 * \param handler The rotation handler. May be empty.
+				 *
+				 * A first data key is generated and wrapped by the constructor, which calls handler for it: a handler set later with set_rotation_handler() does not see the first data key.
+				 */
+				envelope_session(const cipher_algorithm& algorithm, const pkey::pkey* pkeys, size_t pkeys_count, boost::uint64_t max_messages = default_max_messages, unsigned int max_age = default_max_age, unsigned int thread_count = 0, rotation_handler_type handler = rotation_handler_type());
+
+				/**
+				 * \brief Set the rotation handler.
+				 * \param handler The handler to call whenever a new data key is generated. May be empty.
+				 */
+				void set_rotation_handler(rotation_handler_type handler);
+
+				/**
+				 * \brief Generate and wrap a new data key.
+				 *
+				 * If the new data key cannot be generated or wrapped, an exception is thrown and the session keeps its current data key. The rotation handler is called once the new data key is in use.
+				 */
+				void rotate();
+
+				/**
+				 * \brief Check if the current data key is expired.
+				 * \return true if the next call to seal() will generate a new data key.
+				 */
+				bool needs_rotation() const;
+
+				/**
+				 * \brief Seal a message.
+				 * \param out The output buffer. Must be at least max_sealed_size(in_len) bytes long.
+				 * \param out_len The length of out.
+				 * \param in The message. May be NULL if in_len is 0.
+				 * \param in_len The length of in.
+				 * \return The count of bytes written to out.
+				 *
+				 * If the current data key is expired, rotate() is called first.
+				 */
+				size_t seal(void* out, size_t out_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Get the maximum size of a sealed message.
+				 * \param in_len The length of the message.
+				 * \return The maximum size of the sealed message.
+				 */
+				size_t max_sealed_size(size_t in_len) const;
+
+				/**
+				 * \brief Get the size of the header that precedes each ciphertext.
+				 * \return The size of the header.
+				 */
+				size_t header_size() const;
+
+				/**
+				 * \brief Get the associated cipher algorithm.
+				 * \return The associated cipher algorithm.
+				 */
+				cipher_algorithm algorithm() const;
+
+				/**
+				 * \brief Get the identifier of the current data key.
+				 * \return The identifier of the current data key.
+				 */
+				const key_id_type& key_id() const;
+
+				/**
+				 * \brief Get the count of recipients.
+				 * \return The count of recipients.
+				 */
+				size_t recipients_count() const;
+
+				/**
+				 * \brief Get the current data key, wrapped for a recipient.
+				 * \param index The index of the recipient, in the order given to the constructor.
+				 * \return The wrapped data key.
+				 */
+				const void* wrapped_key(size_t index) const;
+
+				/**
+				 * \brief Get the length of the current data key, wrapped for a recipient.
+				 * \param index The index of the recipient, in the order given to the constructor.
+				 * \return The length of the wrapped data key.
+				 */
+				size_t wrapped_key_length(size_t index) const;
+
+				/**
+				 * \brief Get the count of messages sealed with the current data key.
+				 * \return The count of messages sealed with the current data key.
+				 */
+				boost::uint64_t messages_count() const;
+
+			private:
+
+				cipher_algorithm m_algorithm;
+				std::vector<pkey::pkey> m_pkeys;
+				boost::uint64_t m_max_messages;
+				unsigned int m_max_age;
+				unsigned int m_thread_count;
+				rotation_handler_type m_rotation_handler;
+				boost::scoped_ptr<keyed_cipher> m_cipher;
+				key_id_type m_key_id;
+				std::vector<unsigned char> m_wrapped_keys;
+				std::vector<size_t> m_wrapped_key_offsets;
+				std::vector<size_t> m_wrapped_key_lengths;
+				boost::uint64_t m_messages_count;
+				std::time_t m_creation_time;
+		};
+
+		inline void envelope_session::set_rotation_handler(rotation_handler_type handler)
+		{
+			m_rotation_handler = handler;
+		}
+
+		inline size_t envelope_session::max_sealed_size(size_t in_len) const
+		{
+			return header_size() + in_len + m_algorithm.block_size();
+		}
+
+		inline size_t envelope_session::header_size() const
+		{
+			return key_id_length + m_algorithm.iv_length();
+		}
+
+		inline cipher_algorithm envelope_session::algorithm() const
+		{
+			return m_algorithm;
+		}
+
+		inline const envelope_session::key_id_type& envelope_session::key_id() const
+		{
+			return m_key_id;
+		}
+
+		inline size_t envelope_session::recipients_count() const
+		{
+			return m_pkeys.size();
+		}
+
+		inline const void* envelope_session::wrapped_key(size_t index) const
+		{
+			return &m_wrapped_keys[m_wrapped_key_offsets[index]];
+		}
+
+		inline size_t envelope_session::wrapped_key_length(size_t index) const
+		{
+			return m_wrapped_key_lengths[index];
+		}
+
+		inline boost::uint64_t envelope_session::messages_count() const
+		{
+			return m_messages_count;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_ENVELOPE_SESSION_HPP */
@@ -0,0 +1,190 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file etm_context.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An encrypt-then-MAC context class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_ETM_CONTEXT_HPP
+#define CRYPTOPLUS_CIPHER_ETM_CONTEXT_HPP
+
+#include "cipher_algorithm.hpp"
+#include "cipher_context.hpp"
+#include "../hash/message_digest_algorithm.hpp"
+#include "../hash/hmac_context.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief An encrypt-then-MAC context class.
+		 *
+		 * The etm_context class combines a cipher (typically AES-CBC or AES-CTR) and a HMAC (typically HMAC-SHA1 or HMAC-SHA256) into an authenticated encryption scheme.
+		 *
+		 * The authentication tag is computed as in draft-mcgrew-aead-aes-cbc-hmac-sha2: HMAC(AAD || IV || ciphertext || AL), where AL is the bit length of AAD as a 64-bit big-endian integer, truncated to tag_length() bytes.
+		 *
+		 * The data is processed in a single pass, by tiles small enough to stay in the CPU caches: each tile is ciphered and immediately fed to the HMAC while it is still hot.
+		 *
+		 * The cipher key schedule and the HMAC key are set once by initialize().
+		 *
+		 * OpenSSL's stitched AES-CBC-HMAC ciphers are not used: they implement the TLS MAC-then-encrypt construction.
+		 *
+		 * etm_context is noncopyable by design.
+		 */
+		class etm_context : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The size of the tiles.
+				 */
+				static const size_t tile_size = 16 * 1024;
+
+				/**
+				 * \brief Create a new etm_context.
+				 */
+				etm_context();
+
+				/**
+				 * \brief Initialize the etm_context.
+				 * \param algorithm The cipher algorithm to use. PKCS padding is enabled for block modes.
+				 * \param direction The direction of the etm_context.
+				 * \param key The cipher key to use. Cannot be NULL.
+				 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param mac_algorithm The message digest algorithm to use for the HMAC.
+				 * \param mac_key The HMAC key to use. Cannot be NULL.
+				 * \param mac_key_len The length of mac_key.
+				 * \param tag_len The length of the authentication tags. If tag_len is 0, mac_algorithm.result_size() is used. Cannot exceed mac_algorithm.result_size().
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				void initialize(const cipher_algorithm& algorithm, cipher_context::cipher_direction direction, const void* key, size_t key_len, const hash::message_digest_algorithm& mac_algorithm, const void* mac_key, size_t mac_key_len, size_t tag_len = 0, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Get the maximum size of a sealed message.
+				 * \param in_len The length of the plaintext.
+				 * \return The maximum size of the sealed message.
+				 */
+				size_t max_sealed_size(size_t in_len) const;
+
+				/**
+				 * \brief Encrypt and authenticate a complete message.
+				 * \param out The output buffer. Must be at least max_sealed_size(in_len) bytes long. Cannot be NULL.
+				 * \param out_len The length of the out buffer.
+				 * \param iv The IV to use. Cannot be NULL.
+				 * \param iv_len The length of iv. Must match algorithm().iv_length().
+				 * \param aad The additional authenticated data. May be NULL if aad_len is 0.
+				 * \param aad_len The length of aad.
+				 * \param in The plaintext.
+				 * \param in_len The length of in.
+				 * \return The count of bytes written.
+				 *
+				 * The ciphertext is written to out, immediately followed by the authentication tag.
+				 *
+				 * The etm_context must have been initialized for encryption.
+				 */
+				size_t seal(void* out, size_t out_len, const void* iv, size_t iv_len, const void* aad, size_t aad_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Verify and decrypt a complete message.
+				 * \param out The output buffer. Must be at least in_len - tag_length() + algorithm().block_size() bytes long. Cannot be NULL.
+				 * \param out_len The length of the out buffer.
+				 * \param iv The IV to use. Cannot be NULL.
+				 * \param iv_len The length of iv. Must match algorithm().iv_length().
+				 * \param aad The additional authenticated data. May be NULL if aad_len is 0.
+				 * \param aad_len The length of aad.
+				 * \param in The ciphertext, immediately followed by the authentication tag, as produced by seal().
+				 * \param in_len The length of in. Must be at least tag_length().
+				 * \param result The count of bytes written to out, on success.
+				 * \return true if the message is authentic, false otherwise. On failure, out is erased.
+				 *
+				 * The etm_context must have been initialized for decryption.
+				 */
+				bool open(void* out, size_t out_len, const void* iv, size_t iv_len, const void* aad, size_t aad_len, const void* in, size_t in_len, size_t& result);
+
+				/**
+				 * \brief Get the tag length.
+				 * \return The tag length.
+				 */
+				size_t tag_length() const;
+
+				/**
+				 * \brief Get the associated cipher algorithm.
+				 * \return The associated cipher algorithm. If no call to initialize was done, the behavior is undefined.
+				 */
+				cipher_algorithm algorithm() const;
+
+			private:
+
+				void start(const void* iv, size_t iv_len, const void* aad, size_t aad_len);
+				void finish_mac(size_t aad_len, unsigned char* tag);
+
+				cipher_context m_cipher_ctx;
+				hash::hmac_context m_mac_ctx;
+				size_t m_tag_len;
+		};
+
+		inline etm_context::etm_context() :
+			m_tag_len(0)
+		{
+		}
+
+		inline size_t etm_context::max_sealed_size(size_t in_len) const
+		{
+			return in_len + algorithm().block_size() + m_tag_len;
+		}
+
+		inline size_t etm_context::tag_length() const
+		{
+			return m_tag_len;
+		}
+
+		inline cipher_algorithm etm_context::algorithm() const
+		{
+			return m_cipher_ctx.algorithm();
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_ETM_CONTEXT_HPP */
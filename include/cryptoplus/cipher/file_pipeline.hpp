@@ -0,0 +1,111 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file file_pipeline.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A file cipher pipeline class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_FILE_PIPELINE_HPP
+#define CRYPTOPLUS_CIPHER_FILE_PIPELINE_HPP
+
+#include "cipher_context.hpp"
+#include "../file.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
+
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief A file cipher pipeline class.
+		 *
+		 * A file_pipeline ciphers a whole file into another one, overlapping the reads, the cipher computation and the writes: a reader thread keeps several input buffers filled ahead while a writer thread flushes the output buffers, and the calling thread only runs the cipher.
+		 *
+		 * The design has the following limits:
+		 * - The cipher runs on the calling thread only. The cipher_context carries a sequential state (CBC chaining, a CTR counter, a pending partial block) so its updates cannot be split between threads: the throughput is bounded by what one core ciphers. To cipher seekable data on several cores, use parallel_cipher.hpp, xts_sector_cipher or chunked_writer instead.
+		 * - The reads and writes go through stdio, sequentially, one request at a time on each file: storage that needs many concurrent requests to reach its full bandwidth is not saturated, and stdio buffering may add a copy. In exchange, pipes and other non-seekable files are supported.
+		 *
+		 * file_pipeline is noncopyable by design.
+		 */
+		class file_pipeline : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The default buffer size.
+				 */
+				static const size_t default_buffer_size = 1024 * 1024;
+
+				/**
+				 * \brief The default count of buffers in flight, in each direction.
+				 */
+				static const size_t default_buffer_count = 4;
+
+				/**
+				 * \brief Create a new file_pipeline.
+				 * \param buffer_size The size of each buffer. Cannot be 0.
+				 * \param buffer_count The count of buffers in flight, in each direction. Cannot be 0.
+				 */
+				explicit file_pipeline(size_t buffer_size = default_buffer_size, size_t buffer_count = default_buffer_count);
+
+				/**
+				 * \brief Cipher a file.
+				 * \param ctx The cipher context. Must have been initialized. It is finalized once the whole input was read.
+				 * \param in The input file. It is read until its end.
+				 * \param out The output file.
+				 * \return The count of bytes written to out.
+				 *
+				 * If reading, writing or ciphering fails, the pipeline is stopped and the error is thrown: out must then be discarded.
+				 */
+				boost::uint64_t run(cipher_context& ctx, file in, file out);
+
+			private:
+
+				size_t m_buffer_size;
+				size_t m_buffer_count;
+		};
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_FILE_PIPELINE_HPP */
@@ -0,0 +1,235 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file key_wrap.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An AES key wrap class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_KEY_WRAP_HPP
+#define CRYPTOPLUS_CIPHER_KEY_WRAP_HPP
+
+#include "cipher_context.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief An AES key wrap class.
+		 *
+		 * The key_wrap class implements the AES key wrap (AES-KW, RFC 3394) and the AES key wrap with padding (AES-KWP, RFC 5649) algorithms on top of AES in ECB mode.
+		 *
+		 * The KEK schedule is computed once, at construction time. The batch methods process the keys in lockstep: the AES blocks of all the keys for a given wrapping step are ciphered in a single ECB call, which lets OpenSSL pipeline them (for instance using AES-NI).
+		 *
+		 * key_wrap is noncopyable by design and is not thread-safe.
+		 */
+		class key_wrap : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The key wrap variants.
+				 */
+				enum wrap_mode
+				{
+					rfc3394, /**< \brief AES-KW: the keys must be a multiple of 8 bytes long, and at least 16 bytes long. */
+					rfc5649 /**< \brief AES-KWP: the keys can have any non-zero length. */
+				};
+
+				/**
+				 * \brief A key descriptor.
+				 */
+				struct message
+				{
+					/**
+					 * \brief The input buffer: the key to wrap or the wrapped key.
+					 */
+					const void* in;
+
+					/**
+					 * \brief The length of in.
+					 */
+					size_t in_len;
+
+					/**
+					 * \brief The output buffer. When wrapping, must be at least wrapped_length(in_len) bytes long. When unwrapping, must be at least in_len - 8 bytes long. Cannot be NULL.
+					 */
+					void* out;
+
+					/**
+					 * \brief The length of out.
+					 */
+					size_t out_len;
+
+					/**
+					 * \brief The count of bytes written to out. Set by wrap() or unwrap(). When unwrapping, 0 indicates that the integrity check failed.
+					 */
+					size_t result;
+				};
+
+				/**
+				 * \brief Create a new key_wrap.
+				 * \param kek The key encryption key. Cannot be NULL.
+				 * \param kek_len The length of kek. Must be 16, 24 or 32 or a std::runtime_error is thrown.
+				 * \param mode The key wrap variant.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				key_wrap(const void* kek, size_t kek_len, wrap_mode mode = rfc3394, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Get the key wrap variant.
+				 * \return The key wrap variant.
+				 */
+				wrap_mode mode() const;
+
+				/**
+				 * \brief Get the length of a wrapped key.
+				 * \param key_len The length of the key.
+				 * \return The length of the wrapped key.
+				 */
+				size_t wrapped_length(size_t key_len) const;
+
+				/**
+				 * \brief Wrap a key.
+				 * \param out The output buffer. Must be at least wrapped_length(key_len) bytes long.
+				 * \param out_len The length of out.
+				 * \param key The key to wrap.
+				 * \param key_len The length of key. If key_len is invalid for mode(), a std::runtime_error is thrown.
+				 * \return The count of bytes written to out.
+				 */
+				size_t wrap(void* out, size_t out_len, const void* key, size_t key_len);
+
+				/**
+				 * \brief Unwrap a key.
+				 * \param out The output buffer. Must be at least in_len - 8 bytes long.
+				 * \param out_len The length of out.
+				 * \param in The wrapped key.
+				 * \param in_len The length of in.
+				 * \return The count of bytes written to out, or 0 if the integrity check failed.
+				 */
+				size_t unwrap(void* out, size_t out_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Wrap a batch of keys.
+				 * \param messages The keys. The result member of each message is updated.
+				 * \param messages_count The count of keys.
+				 *
+				 * All the lengths are checked before any key is wrapped.
+				 */
+				void wrap(message* messages, size_t messages_count);
+
+				/**
+				 * \brief Wrap a batch of keys.
+				 * \param messages The keys. The result member of each message is updated.
+				 */
+				void wrap(std::vector<message>& messages);
+
+				/**
+				 * \brief Unwrap a batch of keys.
+				 * \param messages The wrapped keys. The result member of each message is updated.
+				 * \param messages_count The count of wrapped keys.
+				 * \return The count of keys whose integrity check failed.
+				 *
+				 * All the lengths are checked before any key is unwrapped.
+				 */
+				size_t unwrap(message* messages, size_t messages_count);
+
+				/**
+				 * \brief Unwrap a batch of keys.
+				 * \param messages The wrapped keys. The result member of each message is updated.
+				 * \return The count of keys whose integrity check failed.
+				 */
+				size_t unwrap(std::vector<message>& messages);
+
+			private:
+
+				struct lane
+				{
+					unsigned char* a;
+					unsigned char* r;
+					size_t n;
+				};
+
+				void run(cipher_context& ctx, bool encrypt, lane* lanes, size_t lanes_count);
+
+				wrap_mode m_mode;
+				cipher_context m_encrypt_ctx;
+				cipher_context m_decrypt_ctx;
+				std::vector<unsigned char> m_state;
+				std::vector<unsigned char> m_blocks;
+				std::vector<lane> m_lanes;
+		};
+
+		inline key_wrap::wrap_mode key_wrap::mode() const
+		{
+			return m_mode;
+		}
+
+		inline size_t key_wrap::wrapped_length(size_t key_len) const
+		{
+			return ((key_len + 7) / 8) * 8 + 8;
+		}
+
+		inline void key_wrap::wrap(std::vector<message>& messages)
+		{
+			if (!messages.empty())
+			{
+				wrap(&messages[0], messages.size());
+			}
+		}
+
+		inline size_t key_wrap::unwrap(std::vector<message>& messages)
+		{
+			if (!messages.empty())
+			{
+				return unwrap(&messages[0], messages.size());
+			}
+
+			return 0;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_KEY_WRAP_HPP */
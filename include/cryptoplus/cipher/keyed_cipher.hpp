@@ -0,0 +1,121 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file keyed_cipher.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A pre-keyed cipher class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_KEYED_CIPHER_HPP
+#define CRYPTOPLUS_CIPHER_KEYED_CIPHER_HPP
+
+#include "cipher_algorithm.hpp"
+#include "cipher_context.hpp"
+
+#include <boost/noncopyable.hpp>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief A pre-keyed cipher class.
+		 *
+		 * A keyed_cipher expands its key once, at construction time, and is immutable afterwards: it can be shared across threads.
+		 *
+		 * Each message is then processed using a cipher_context obtained from create_context(), which copies the expanded key and only sets the IV. This avoids recomputing the key schedule for every message.
+		 *
+		 * keyed_cipher is noncopyable by design.
+		 */
+		class keyed_cipher : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief Create a new keyed_cipher.
+				 * \param algorithm The cipher algorithm to use.
+				 * \param direction The cipher direction.
+				 * \param key The key to use. Cannot be NULL.
+				 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param padding If padding is false, the created contexts have PKCS padding disabled.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				keyed_cipher(const cipher_algorithm& algorithm, cipher_context::cipher_direction direction, const void* key, size_t key_len, bool padding = true, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Initialize a cipher_context for a new message.
+				 * \param ctx The cipher_context to initialize. Its previous state, if any, is discarded.
+				 * \param iv The IV of the message. May be NULL if the algorithm does not use an IV.
+				 * \param iv_len The length of iv. Must match algorithm().iv_length() or a std::runtime_error is thrown.
+				 *
+				 * This method can be called concurrently from different threads, as long as each thread uses its own cipher_context.
+				 */
+				void create_context(cipher_context& ctx, const void* iv, size_t iv_len) const;
+
+				/**
+				 * \brief Get the associated cipher algorithm.
+				 * \return The associated cipher algorithm.
+				 */
+				cipher_algorithm algorithm() const;
+
+				/**
+				 * \brief Get the cipher direction.
+				 * \return The cipher direction.
+				 */
+				cipher_context::cipher_direction direction() const;
+
+			private:
+
+				cipher_context m_ctx;
+				cipher_context::cipher_direction m_direction;
+		};
+
+		inline cipher_algorithm keyed_cipher::algorithm() const
+		{
+			return m_ctx.algorithm();
+		}
+
+		inline cipher_context::cipher_direction keyed_cipher::direction() const
+		{
+			return m_direction;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_KEYED_CIPHER_HPP */
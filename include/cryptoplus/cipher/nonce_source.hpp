@@ -0,0 +1,207 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file nonce_source.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A nonce generator class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_NONCE_SOURCE_HPP
+#define CRYPTOPLUS_CIPHER_NONCE_SOURCE_HPP
+
+#include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief A nonce generator class.
+		 *
+		 * A nonce_source hands out unique nonces (or IVs) to any number of threads, without sharing any state between them on the hot path.
+		 *
+		 * In deterministic mode, each nonce is made of a fixed field followed by a big-endian invocation counter of counter_length bytes, as described in NIST SP 800-38D, section 8.2.1. Each thread reserves counter_block_size consecutive counter values at once, under a lock, then increments its own copy: until reseed() is called, two nonces handed out by the same nonce_source are always different. The fixed field and the first counter value are random unless the fixed field is specified. Deterministic nonces are predictable: they suit counter-based modes such as GCM, CCM, CTR or ChaCha20-Poly1305, but not CBC.
+		 *
+		 * In random mode, the nonces are taken from random::get_buffered_random_bytes(), which keeps a random buffer per thread and refills it after fork().
+		 *
+		 * nonce_source is noncopyable by design. Its methods are thread-safe.
+		 */
+		class nonce_source : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The nonce construction.
+				 */
+				enum nonce_mode
+				{
+					deterministic_nonce, /**< \brief A fixed field followed by an invocation counter. */
+					random_nonce /**< \brief Random nonces. */
+				};
+
+				/**
+				 * \brief The length of the invocation counter, in deterministic mode.
+				 */
+				static const size_t counter_length;
+
+				/**
+				 * \brief The default nonce length, suitable for GCM.
+				 */
+				static const size_t default_nonce_length;
+
+				/**
+				 * \brief The count of counter values a thread reserves at once, in deterministic mode.
+				 */
+				static const boost::uint64_t counter_block_size;
+
+				/**
+				 * \brief Create a new nonce_source.
+				 * \param mode The nonce construction.
+				 * \param nonce_len The nonce length. In deterministic mode, must be at least counter_length or a std::runtime_error is thrown.
+				 *
+				 * In deterministic mode, the fixed field is the first nonce_len - counter_length bytes and is random.
+				 */
+				explicit nonce_source(nonce_mode mode = deterministic_nonce, size_t nonce_len = default_nonce_length);
+
+				/**
+				 * \brief Create a new deterministic nonce_source.
+				 * \param fixed The fixed field. It must be unique among all the nonce sources that are used with the same key. Cannot be NULL unless fixed_len is 0.
+				 * \param fixed_len The length of fixed. The nonces are fixed_len + counter_length bytes long.
+				 */
+				nonce_source(const void* fixed, size_t fixed_len);
+
+				/**
+				 * \brief Get the nonce construction.
+				 * \return The nonce construction.
+				 */
+				nonce_mode mode() const;
+
+				/**
+				 * \brief Get the nonce length.
+				 * \return The nonce length.
+				 */
+				size_t nonce_length() const;
+
+				/**
+				 * \brief Generate a nonce.
+				 * \param nonce The output buffer. Cannot be NULL.
+				 * \param nonce_len The length of nonce. Must be nonce_length() or a std::runtime_error is thrown.
+				 *
+				 * In deterministic mode, if all the counter values were used, a std::runtime_error is thrown.
+				 */
+				void generate(void* nonce, size_t nonce_len) const;
+
+				/**
+				 * \brief Generate several nonces.
+				 * \param nonces The output buffer, which receives count contiguous nonces. Must be at least nonce_len * count bytes long.
+				 * \param nonce_len The length of each nonce. Must be nonce_length() or a std::runtime_error is thrown.
+				 * \param count The count of nonces to generate.
+				 *
+				 * In deterministic mode, if all the counter values were used, a std::runtime_error is thrown.
+				 */
+				void generate(void* nonces, size_t nonce_len, size_t count) const;
+
+				/**
+				 * \brief Generate a nonce.
+				 * \return The nonce.
+				 */
+				template <typename T>
+				std::vector<T> generate() const;
+
+				/**
+				 * \brief Forget the counter values reserved by the calling thread and draw a new random first counter value.
+				 *
+				 * In deterministic mode, call this method in a child process after fork(): otherwise, the child and its parent would hand out the same nonces. The new counter range is not checked against the values already handed out: with n values handed out before and n after, the probability that two nonces collide is about 2n / 2^64. In random mode, this calls random::discard_buffered_random_bytes(), which is not needed after fork().
+				 */
+				void reseed() const;
+
+			private:
+
+				struct counter_block
+				{
+					boost::uint64_t next;
+					boost::uint64_t end;
+				};
+
+				counter_block& get_counter_block() const;
+				void reserve_counter_block(counter_block& block) const;
+
+				nonce_mode m_mode;
+				size_t m_nonce_len;
+				std::vector<unsigned char> m_fixed;
+				mutable boost::mutex m_mutex;
+				mutable boost::uint64_t m_next_counter;
+				mutable boost::uint64_t m_reserved_blocks;
+				mutable boost::thread_specific_ptr<counter_block> m_counter_block;
+		};
+
+		inline nonce_source::nonce_mode nonce_source::mode() const
+		{
+			return m_mode;
+		}
+
+		inline size_t nonce_source::nonce_length() const
+		{
+			return m_nonce_len;
+		}
+
+		inline void nonce_source::generate(void* nonce, size_t nonce_len) const
+		{
+			generate(nonce, nonce_len, 1);
+		}
+
+		template <typename T>
+		inline std::vector<T> nonce_source::generate() const
+		{
+			std::vector<T> result(m_nonce_len);
+
+			generate(&result[0], result.size());
+
+			return result;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_NONCE_SOURCE_HPP */
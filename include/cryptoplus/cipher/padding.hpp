@@ -0,0 +1,86 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file padding.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Batch padding verification functions.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_PADDING_HPP
+#define CRYPTOPLUS_CIPHER_PADDING_HPP
+
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief The padding schemes.
+		 */
+		enum padding_scheme
+		{
+			pkcs7_padding, /**< \brief PKCS#7 padding: every padding byte holds the padding length. */
+			iso_10126_padding /**< \brief ISO 10126 padding: the padding bytes are random, except the last one which holds the padding length. */
+		};
+
+		/**
+		 * \brief The value stored in the results of verify_padding() for an invalid record.
+		 */
+		const size_t invalid_padding = static_cast<size_t>(-1);
+
+		/**
+		 * \brief Verify and strip the padding of several decrypted records.
+		 * \param scheme The padding scheme.
+		 * \param block_size The block size of the cipher algorithm. Cannot exceed EVP_MAX_BLOCK_LENGTH.
+		 * \param bufs The decrypted records.
+		 * \param buf_lens The lengths of the records, including their padding.
+		 * \param results An array of count values that receives the length of each record without its padding, or invalid_padding if the padding of the record is invalid.
+		 * \param count The count of records.
+		 * \return The count of records with an invalid padding.
+		 *
+		 * Unlike cipher_context::verify_iso_10126_padding(), no exception is thrown on invalid padding and the time spent on a record does not depend on its content. It only depends on its length, which is not considered secret.
+		 *
+		 * When available, SSE2 is used for 16 bytes blocks.
+		 */
+		size_t verify_padding(padding_scheme scheme, size_t block_size, const void* const* bufs, const size_t* buf_lens, size_t* results, size_t count);
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_PADDING_HPP */
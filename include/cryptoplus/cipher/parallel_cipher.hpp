@@ -0,0 +1,153 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file parallel_cipher.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Multi-threaded cipher helper functions.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_PARALLEL_CIPHER_HPP
+#define CRYPTOPLUS_CIPHER_PARALLEL_CIPHER_HPP
+
+#include "cipher_algorithm.hpp"
+
+#include <openssl/opensslv.h>
+
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief Encrypt or decrypt a buffer with a counter mode (CTR) cipher, using several threads.
+		 * \param out The output buffer. Must be at least in_len bytes long. Can be the same as in.
+		 * \param out_len The length of out.
+		 * \param in The input buffer.
+		 * \param in_len The length of in.
+		 * \param algorithm The cipher algorithm to use. Must be a CTR cipher or a std::runtime_error is thrown.
+		 * \param key The key to use. Cannot be NULL.
+		 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+		 * \param iv The initial counter block. Cannot be NULL.
+		 * \param iv_len The length of iv. Must match algorithm.iv_length() or a std::runtime_error is thrown.
+		 * \param thread_count The maximum count of threads to use, including the calling thread. 0, the default, means one thread per hardware thread.
+		 * \return The count of bytes written, that is in_len.
+		 *
+		 * The buffer is split into counter-aligned chunks and each chunk starts its own keystream at the matching counter value: the result is exactly the same as with a single cipher_context.
+		 *
+		 * With OpenSSL versions prior to 1.1.0, a threading_initializer must exist while this function runs.
+		 */
+		size_t parallel_ctr_update(void* out, size_t out_len, const void* in, size_t in_len, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, unsigned int thread_count = 0);
+
+		/**
+		 * \brief Decrypt a buffer with a CBC cipher, using several threads.
+		 * \param out The output buffer. Must be at least in_len bytes long. Can be the same as in.
+		 * \param out_len The length of out.
+		 * \param in The ciphertext.
+		 * \param in_len The length of in. Must be a multiple of algorithm.block_size() or a std::runtime_error is thrown.
+		 * \param algorithm The cipher algorithm to use. Must be a CBC cipher.
+		 * \param key The key to use. Cannot be NULL.
+		 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+		 * \param iv The IV. Cannot be NULL.
+		 * \param iv_len The length of iv. Must match algorithm.iv_length() or a std::runtime_error is thrown.
+		 * \param padding If padding is true, the PKCS padding is verified and removed, as cipher_context::finalize() does.
+		 * \param thread_count The maximum count of threads to use, including the calling thread. 0, the default, means one thread per hardware thread.
+		 * \return The count of bytes written to out, without the padding.
+		 *
+		 * Unlike encryption, CBC decryption of a block only depends on the previous ciphertext block: the buffer is split into block-aligned chunks, each one seeded by the last ciphertext block of the chunk before it. Only the last chunk handles the padding.
+		 *
+		 * If the data was padded using the ISO 10126 padding, use padding = false then call cipher_context::verify_iso_10126_padding() on the result.
+		 *
+		 * With OpenSSL versions prior to 1.1.0, a threading_initializer must exist while this function runs.
+		 */
+		size_t parallel_cbc_decrypt(void* out, size_t out_len, const void* in, size_t in_len, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, bool padding = true, unsigned int thread_count = 0);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+		/**
+		 * \brief Encrypt and authenticate a buffer with a GCM cipher, using several threads.
+		 * \param out The output buffer. Must be at least in_len + tag_len bytes long. Can be the same as in.
+		 * \param out_len The length of out.
+		 * \param in The plaintext.
+		 * \param in_len The length of in.
+		 * \param aad The additional authenticated data. May be NULL if aad_len is 0.
+		 * \param aad_len The length of aad.
+		 * \param algorithm The cipher algorithm to use. Must be a GCM cipher.
+		 * \param key The key to use. Cannot be NULL.
+		 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+		 * \param iv The IV. Cannot be NULL.
+		 * \param iv_len The length of iv.
+		 * \param tag_len The length of the authentication tag. Must be between 4 and 16 or a std::runtime_error is thrown.
+		 * \param thread_count The maximum count of threads to use, including the calling thread. 0, the default, means one thread per hardware thread.
+		 * \return The count of bytes written, that is in_len + tag_len.
+		 *
+		 * The ciphertext is written to out, immediately followed by the authentication tag: the result is the same as aead_context::seal().
+		 *
+		 * Each thread encrypts its own chunk and computes the GHASH of its ciphertext; the partial GHASH values are then combined into the final tag.
+		 *
+		 * With OpenSSL versions prior to 1.1.0, a threading_initializer must exist while this function runs.
+		 */
+		size_t parallel_gcm_seal(void* out, size_t out_len, const void* in, size_t in_len, const void* aad, size_t aad_len, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, size_t tag_len = 16, unsigned int thread_count = 0);
+
+		/**
+		 * \brief Decrypt and verify a buffer with a GCM cipher, using several threads.
+		 * \param out The output buffer. Must be at least in_len - tag_len bytes long. Can be the same as in.
+		 * \param out_len The length of out.
+		 * \param in The ciphertext, immediately followed by the authentication tag, as produced by parallel_gcm_seal().
+		 * \param in_len The length of in.
+		 * \param aad The additional authenticated data. May be NULL if aad_len is 0.
+		 * \param aad_len The length of aad.
+		 * \param algorithm The cipher algorithm to use. Must be a GCM cipher.
+		 * \param key The key to use. Cannot be NULL.
+		 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+		 * \param iv The IV. Cannot be NULL.
+		 * \param iv_len The length of iv.
+		 * \param tag_len The length of the authentication tag. Must be between 4 and 16 or a std::runtime_error is thrown.
+		 * \param thread_count The maximum count of threads to use, including the calling thread. 0, the default, means one thread per hardware thread.
+		 * \return true if the message is authentic, false otherwise. On success, in_len - tag_len bytes were written to out. On failure, out is cleared.
+		 *
+		 * With OpenSSL versions prior to 1.1.0, a threading_initializer must exist while this function runs.
+		 */
+		bool parallel_gcm_open(void* out, size_t out_len, const void* in, size_t in_len, const void* aad, size_t aad_len, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, size_t tag_len = 16, unsigned int thread_count = 0);
+
+#endif
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_PARALLEL_CIPHER_HPP */
@@ -0,0 +1,438 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file typed_cipher.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Compile-time typed cipher classes.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_TYPED_CIPHER_HPP
+#define CRYPTOPLUS_CIPHER_TYPED_CIPHER_HPP
+
+#include "cipher_context.hpp"
+#include "aead_context.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/array.hpp>
+
+#include <cstddef>
+#include <cassert>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief The AES-128-CBC cipher tag.
+		 *
+		 * A cipher tag describes a cipher algorithm at compile time: its sizes are integral constant expressions and cipher() returns the matching OpenSSL cipher.
+		 */
+		struct aes_128_cbc
+		{
+			static const bool aead = false; /**< \brief Whether the cipher is an AEAD cipher. */
+			static const size_t key_length = 16; /**< \brief The key length. */
+			static const size_t iv_length = 16; /**< \brief The IV length. */
+			static const size_t block_size = 16; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL cipher.
+			 * \return The OpenSSL cipher.
+			 */
+			static const EVP_CIPHER* cipher() { return EVP_aes_128_cbc(); }
+		};
+
+		/**
+		 * \brief The AES-256-CBC cipher tag.
+		 */
+		struct aes_256_cbc
+		{
+			static const bool aead = false; /**< \brief Whether the cipher is an AEAD cipher. */
+			static const size_t key_length = 32; /**< \brief The key length. */
+			static const size_t iv_length = 16; /**< \brief The IV length. */
+			static const size_t block_size = 16; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL cipher.
+			 * \return The OpenSSL cipher.
+			 */
+			static const EVP_CIPHER* cipher() { return EVP_aes_256_cbc(); }
+		};
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+		/**
+		 * \brief The AES-128-CTR cipher tag.
+		 */
+		struct aes_128_ctr
+		{
+			static const bool aead = false; /**< \brief Whether the cipher is an AEAD cipher. */
+			static const size_t key_length = 16; /**< \brief The key length. */
+			static const size_t iv_length = 16; /**< \brief The IV length. */
+			static const size_t block_size = 1; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL cipher.
+			 * \return The OpenSSL cipher.
+			 */
+			static const EVP_CIPHER* cipher() { return EVP_aes_128_ctr(); }
+		};
+
+		/**
+		 * \brief The AES-256-CTR cipher tag.
+		 */
+		struct aes_256_ctr
+		{
+			static const bool aead = false; /**< \brief Whether the cipher is an AEAD cipher. */
+			static const size_t key_length = 32; /**< \brief The key length. */
+			static const size_t iv_length = 16; /**< \brief The IV length. */
+			static const size_t block_size = 1; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL cipher.
+			 * \return The OpenSSL cipher.
+			 */
+			static const EVP_CIPHER* cipher() { return EVP_aes_256_ctr(); }
+		};
+
+		/**
+		 * \brief The AES-128-GCM cipher tag.
+		 */
+		struct aes_128_gcm
+		{
+			static const bool aead = true; /**< \brief Whether the cipher is an AEAD cipher. */
+			static const size_t key_length = 16; /**< \brief The key length. */
+			static const size_t iv_length = 12; /**< \brief The IV length. */
+			static const size_t block_size = 1; /**< \brief The block size. */
+			static const size_t tag_length = 16; /**< \brief The authentication tag length. */
+
+			/**
+			 * \brief Get the OpenSSL cipher.
+			 * \return The OpenSSL cipher.
+			 */
+			static const EVP_CIPHER* cipher() { return EVP_aes_128_gcm(); }
+		};
+
+		/**
+		 * \brief The AES-256-GCM cipher tag.
+		 */
+		struct aes_256_gcm
+		{
+			static const bool aead = true; /**< \brief Whether the cipher is an AEAD cipher. */
+			static const size_t key_length = 32; /**< \brief The key length. */
+			static const size_t iv_length = 12; /**< \brief The IV length. */
+			static const size_t block_size = 1; /**< \brief The block size. */
+			static const size_t tag_length = 16; /**< \brief The authentication tag length. */
+
+			/**
+			 * \brief Get the OpenSSL cipher.
+			 * \return The OpenSSL cipher.
+			 */
+			static const EVP_CIPHER* cipher() { return EVP_aes_256_gcm(); }
+		};
+#endif
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000
+		/**
+		 * \brief The ChaCha20-Poly1305 cipher tag.
+		 */
+		struct chacha20_poly1305
+		{
+			static const bool aead = true; /**< \brief Whether the cipher is an AEAD cipher. */
+			static const size_t key_length = 32; /**< \brief The key length. */
+			static const size_t iv_length = 12; /**< \brief The IV length. */
+			static const size_t block_size = 1; /**< \brief The block size. */
+			static const size_t tag_length = 16; /**< \brief The authentication tag length. */
+
+			/**
+			 * \brief Get the OpenSSL cipher.
+			 * \return The OpenSSL cipher.
+			 */
+			static const EVP_CIPHER* cipher() { return EVP_chacha20_poly1305(); }
+		};
+#endif
+
+		/**
+		 * \brief A compile-time typed cipher.
+		 *
+		 * Algorithm is a cipher tag, such as aes_256_cbc or aes_256_gcm. The key, IV and tag types are fixed-size arrays: passing a buffer of the wrong size does not compile and no size is checked at runtime.
+		 *
+		 * typed_cipher is a thin front-end to cipher_context, for regular ciphers, or to aead_context, for AEAD ciphers, which remain the generic, runtime-dispatched layer.
+		 *
+		 * typed_cipher is noncopyable by design.
+		 */
+		template <typename Algorithm, bool Aead = Algorithm::aead>
+		class typed_cipher;
+
+		/**
+		 * \brief A compile-time typed regular cipher.
+		 */
+		template <typename Algorithm>
+		class typed_cipher<Algorithm, false> : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The cipher tag.
+				 */
+				typedef Algorithm algorithm_type;
+
+				static const size_t key_length = Algorithm::key_length; /**< \brief The key length. */
+				static const size_t iv_length = Algorithm::iv_length; /**< \brief The IV length. */
+				static const size_t block_size = Algorithm::block_size; /**< \brief The block size. */
+
+				/**
+				 * \brief The key type.
+				 */
+				typedef boost::array<unsigned char, key_length> key_type;
+
+				/**
+				 * \brief The IV type.
+				 */
+				typedef boost::array<unsigned char, iv_length> iv_type;
+
+				/**
+				 * \brief Create a new typed_cipher.
+				 * \param direction The cipher direction.
+				 * \param key The key.
+				 * \param iv The IV.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				typed_cipher(cipher_context::cipher_direction direction, const key_type& key, const iv_type& iv, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Start a new message with another IV, keeping the key schedule.
+				 * \param iv The IV.
+				 */
+				void set_iv(const iv_type& iv);
+
+				/**
+				 * \brief Update the cipher with some data.
+				 * \param out The output buffer. Must be at least in_len + block_size bytes long.
+				 * \param out_len The length of out.
+				 * \param in The input buffer.
+				 * \param in_len The length of in.
+				 * \return The count of bytes written to out.
+				 */
+				size_t update(void* out, size_t out_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Finalize the current message.
+				 * \param out The output buffer. Must be at least block_size bytes long.
+				 * \param out_len The length of out.
+				 * \return The count of bytes written to out.
+				 */
+				size_t finalize(void* out, size_t out_len);
+
+				/**
+				 * \brief Get the underlying cipher context.
+				 * \return The underlying cipher context.
+				 */
+				cipher_context& context();
+
+			private:
+
+				cipher_context m_ctx;
+		};
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+		/**
+		 * \brief A compile-time typed AEAD cipher.
+		 */
+		template <typename Algorithm>
+		class typed_cipher<Algorithm, true> : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The cipher tag.
+				 */
+				typedef Algorithm algorithm_type;
+
+				static const size_t key_length = Algorithm::key_length; /**< \brief The key length. */
+				static const size_t iv_length = Algorithm::iv_length; /**< \brief The IV length. */
+				static const size_t tag_length = Algorithm::tag_length; /**< \brief The authentication tag length. */
+
+				/**
+				 * \brief The key type.
+				 */
+				typedef boost::array<unsigned char, key_length> key_type;
+
+				/**
+				 * \brief The IV type.
+				 */
+				typedef boost::array<unsigned char, iv_length> iv_type;
+
+				/**
+				 * \brief The authentication tag type.
+				 */
+				typedef boost::array<unsigned char, tag_length> tag_type;
+
+				/**
+				 * \brief Create a new typed_cipher.
+				 * \param direction The cipher direction.
+				 * \param key The key.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				typed_cipher(cipher_context::cipher_direction direction, const key_type& key, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Encrypt and authenticate a complete message.
+				 * \param out The output buffer. Must be at least in_len + tag_length bytes long.
+				 * \param out_len The length of out.
+				 * \param iv The IV.
+				 * \param aad The additional authenticated data. May be NULL if aad_len is 0.
+				 * \param aad_len The length of aad.
+				 * \param in The plaintext.
+				 * \param in_len The length of in.
+				 * \return The count of bytes written, that is in_len + tag_length.
+				 * \see aead_context::seal
+				 */
+				size_t seal(void* out, size_t out_len, const iv_type& iv, const void* aad, size_t aad_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Decrypt and verify a complete message.
+				 * \param out The output buffer. Must be at least in_len - tag_length bytes long.
+				 * \param out_len The length of out.
+				 * \param iv The IV.
+				 * \param aad The additional authenticated data. May be NULL if aad_len is 0.
+				 * \param aad_len The length of aad.
+				 * \param in The ciphertext followed by the tag, as produced by seal().
+				 * \param in_len The length of in.
+				 * \return true if the message is authentic.
+				 * \see aead_context::open
+				 */
+				bool open(void* out, size_t out_len, const iv_type& iv, const void* aad, size_t aad_len, const void* in, size_t in_len);
+
+				/**
+				 * \brief Get the underlying AEAD context.
+				 * \return The underlying AEAD context.
+				 */
+				aead_context& context();
+
+			private:
+
+				aead_context m_ctx;
+		};
+#endif
+
+		template <typename Algorithm>
+		const size_t typed_cipher<Algorithm, false>::key_length;
+
+		template <typename Algorithm>
+		const size_t typed_cipher<Algorithm, false>::iv_length;
+
+		template <typename Algorithm>
+		const size_t typed_cipher<Algorithm, false>::block_size;
+
+		template <typename Algorithm>
+		inline typed_cipher<Algorithm, false>::typed_cipher(cipher_context::cipher_direction direction, const key_type& key, const iv_type& iv, ENGINE* impl)
+		{
+			const cipher_algorithm algorithm(Algorithm::cipher());
+
+			assert(algorithm.key_length() == key_length);
+			assert(algorithm.iv_length() == iv_length);
+
+			m_ctx.initialize(algorithm, direction, key.data(), key.size(), iv.data(), iv.size(), impl);
+		}
+
+		template <typename Algorithm>
+		inline void typed_cipher<Algorithm, false>::set_iv(const iv_type& iv)
+		{
+			m_ctx.set_iv(iv.data(), iv.size());
+		}
+
+		template <typename Algorithm>
+		inline size_t typed_cipher<Algorithm, false>::update(void* out, size_t out_len, const void* in, size_t in_len)
+		{
+			return m_ctx.update(out, out_len, in, in_len);
+		}
+
+		template <typename Algorithm>
+		inline size_t typed_cipher<Algorithm, false>::finalize(void* out, size_t out_len)
+		{
+			return m_ctx.finalize(out, out_len);
+		}
+
+		template <typename Algorithm>
+		inline cipher_context& typed_cipher<Algorithm, false>::context()
+		{
+			return m_ctx;
+		}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+		template <typename Algorithm>
+		const size_t typed_cipher<Algorithm, true>::key_length;
+
+		template <typename Algorithm>
+		const size_t typed_cipher<Algorithm, true>::iv_length;
+
+		template <typename Algorithm>
+		const size_t typed_cipher<Algorithm, true>::tag_length;
+
+		template <typename Algorithm>
+		inline typed_cipher<Algorithm, true>::typed_cipher(cipher_context::cipher_direction direction, const key_type& key, ENGINE* impl)
+		{
+			const cipher_algorithm algorithm(Algorithm::cipher());
+
+			assert(algorithm.key_length() == key_length);
+
+			m_ctx.initialize(algorithm, direction, key.data(), key.size(), iv_length, tag_length, impl);
+		}
+
+		template <typename Algorithm>
+		inline size_t typed_cipher<Algorithm, true>::seal(void* out, size_t out_len, const iv_type& iv, const void* aad, size_t aad_len, const void* in, size_t in_len)
+		{
+			return m_ctx.seal(out, out_len, iv.data(), iv.size(), aad, aad_len, in, in_len);
+		}
+
+		template <typename Algorithm>
+		inline bool typed_cipher<Algorithm, true>::open(void* out, size_t out_len, const iv_type& iv, const void* aad, size_t aad_len, const void* in, size_t in_len)
+		{
+			return m_ctx.open(out, out_len, iv.data(), iv.size(), aad, aad_len, in, in_len);
+		}
+
+		template <typename Algorithm>
+		inline aead_context& typed_cipher<Algorithm, true>::context()
+		{
+			return m_ctx;
+		}
+#endif
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_TYPED_CIPHER_HPP */
@@ -0,0 +1,193 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file xts_sector_cipher.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An XTS sector cipher class.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_XTS_SECTOR_CIPHER_HPP
+#define CRYPTOPLUS_CIPHER_XTS_SECTOR_CIPHER_HPP
+
+#include "cipher_algorithm.hpp"
+#include "cipher_context.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		/**
+		 * \brief An XTS sector cipher class.
+		 *
+		 * The xts_sector_cipher class encrypts or decrypts fixed-size sectors in place, using an XTS algorithm (such as AES-256-XTS). The tweak of a sector is its number, encoded as a 128-bit little-endian integer (IEEE P1619, "plain64" in dm-crypt).
+		 *
+		 * Both XTS key schedules are computed once, at construction time, for both directions. Each call only copies them into per-thread contexts and sets the tweak of every sector. Large requests are spread across several threads.
+		 *
+		 * The methods of a xts_sector_cipher can be called concurrently from different threads.
+		 */
+		class xts_sector_cipher : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief A sector descriptor.
+				 */
+				struct sector
+				{
+					/**
+					 * \brief The sector number.
+					 */
+					boost::uint64_t number;
+
+					/**
+					 * \brief The sector data, which is ciphered in place. Must be sector_size() bytes long.
+					 */
+					void* data;
+				};
+
+				/**
+				 * \brief The default sector size.
+				 */
+				static const size_t default_sector_size = 4096;
+
+				/**
+				 * \brief Create a new xts_sector_cipher.
+				 * \param algorithm The cipher algorithm to use. Must be an XTS algorithm or a std::runtime_error is thrown.
+				 * \param key The key to use: both XTS keys, concatenated. Cannot be NULL.
+				 * \param key_len The length of key. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param sector_size The sector size. Must be at least algorithm.iv_length() bytes long.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				xts_sector_cipher(const cipher_algorithm& algorithm, const void* key, size_t key_len, size_t sector_size = default_sector_size, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Encrypt sectors in place.
+				 * \param sectors The sectors.
+				 * \param sectors_count The count of sectors.
+				 * \param thread_count The maximum count of threads to use. 0 means one per hardware thread.
+				 */
+				void encrypt(const sector* sectors, size_t sectors_count, unsigned int thread_count = 0) const;
+
+				/**
+				 * \brief Decrypt sectors in place.
+				 * \param sectors The sectors.
+				 * \param sectors_count The count of sectors.
+				 * \param thread_count The maximum count of threads to use. 0 means one per hardware thread.
+				 */
+				void decrypt(const sector* sectors, size_t sectors_count, unsigned int thread_count = 0) const;
+
+				/**
+				 * \brief Encrypt consecutive sectors in place.
+				 * \param first_sector The number of the first sector.
+				 * \param buf The sectors.
+				 * \param buf_len The length of buf. Must be a multiple of sector_size() or a std::logic_error is thrown.
+				 * \param thread_count The maximum count of threads to use. 0 means one per hardware thread.
+				 */
+				void encrypt(boost::uint64_t first_sector, void* buf, size_t buf_len, unsigned int thread_count = 0) const;
+
+				/**
+				 * \brief Decrypt consecutive sectors in place.
+				 * \param first_sector The number of the first sector.
+				 * \param buf The sectors.
+				 * \param buf_len The length of buf. Must be a multiple of sector_size() or a std::logic_error is thrown.
+				 * \param thread_count The maximum count of threads to use. 0 means one per hardware thread.
+				 */
+				void decrypt(boost::uint64_t first_sector, void* buf, size_t buf_len, unsigned int thread_count = 0) const;
+
+				/**
+				 * \brief Get the associated cipher algorithm.
+				 * \return The associated cipher algorithm.
+				 */
+				cipher_algorithm algorithm() const;
+
+				/**
+				 * \brief Get the sector size.
+				 * \return The sector size.
+				 */
+				size_t sector_size() const;
+
+			private:
+
+				void process(const cipher_context& ctx, const sector* sectors, size_t sectors_count, unsigned int thread_count) const;
+				void process(const cipher_context& ctx, boost::uint64_t first_sector, void* buf, size_t buf_len, unsigned int thread_count) const;
+
+				cipher_context m_encrypt_ctx;
+				cipher_context m_decrypt_ctx;
+				size_t m_sector_size;
+		};
+
+		inline void xts_sector_cipher::encrypt(const sector* sectors, size_t sectors_count, unsigned int thread_count) const
+		{
+			process(m_encrypt_ctx, sectors, sectors_count, thread_count);
+		}
+
+		inline void xts_sector_cipher::decrypt(const sector* sectors, size_t sectors_count, unsigned int thread_count) const
+		{
+			process(m_decrypt_ctx, sectors, sectors_count, thread_count);
+		}
+
+		inline void xts_sector_cipher::encrypt(boost::uint64_t first_sector, void* buf, size_t buf_len, unsigned int thread_count) const
+		{
+			process(m_encrypt_ctx, first_sector, buf, buf_len, thread_count);
+		}
+
+		inline void xts_sector_cipher::decrypt(boost::uint64_t first_sector, void* buf, size_t buf_len, unsigned int thread_count) const
+		{
+			process(m_decrypt_ctx, first_sector, buf, buf_len, thread_count);
+		}
+
+		inline cipher_algorithm xts_sector_cipher::algorithm() const
+		{
+			return m_encrypt_ctx.algorithm();
+		}
+
+		inline size_t xts_sector_cipher::sector_size() const
+		{
+			return m_sector_size;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_XTS_SECTOR_CIPHER_HPP */
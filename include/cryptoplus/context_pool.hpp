@@ -0,0 +1,270 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file context_pool.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A thread-local context pool template.
+ */
+
+#ifndef CRYPTOPLUS_CONTEXT_POOL_HPP
+#define CRYPTOPLUS_CONTEXT_POOL_HPP
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/move/move.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	/**
+	 * \brief The context_pool traits template.
+	 *
+	 * The default reset() move-assigns a new context over the given one, which cleans up its whole OpenSSL state: T must then be movable, using Boost.Move. Context types that can erase their state while keeping it allocated specialize this template.
+	 */
+	template <typename T>
+	struct context_pool_traits
+	{
+		/**
+		 * \brief Erase the state of a context that is given back to a pool.
+		 * \param context The context.
+		 */
+		static void reset(T& context)
+		{
+			T empty_context;
+			context = boost::move(empty_context);
+		}
+	};
+
+	/**
+	 * \brief A thread-local context pool template.
+	 *
+	 * A context_pool keeps, for each thread, a free list of context objects (such as cipher::cipher_context or hash::message_digest_context) so that they can be reused instead of being created and cleaned up for every operation.
+	 *
+	 * Contexts are obtained through a lease, which gives the context back to the calling thread's free list when destroyed. A context is reset by context_pool_traits<T>::reset() when it is given back, so that no key material stays in the free list. The leased context must still be initialized before use.
+	 */
+	template <typename T>
+	class context_pool : public boost::noncopyable
+	{
+		public:
+
+			/**
+			 * \brief The default maximum count of free contexts per thread.
+			 */
+			static const size_t default_max_size = 8;
+
+			/**
+			 * \brief A context lease.
+			 *
+			 * The leased context is given back to the pool when the lease is destroyed.
+			 */
+			class lease : public boost::noncopyable
+			{
+				public:
+
+					/**
+					 * \brief Lease a context from the specified pool.
+					 * \param pool The pool.
+					 */
+					explicit lease(context_pool& pool);
+
+					/**
+					 * \brief Give the context back to the pool.
+					 */
+					~lease();
+
+					/**
+					 * \brief Get the leased context.
+					 * \return The leased context.
+					 */
+					T& get() const;
+
+					/**
+					 * \brief Get the leased context.
+					 * \return The leased context.
+					 */
+					T& operator*() const;
+
+					/**
+					 * \brief Get the leased context.
+					 * \return The leased context.
+					 */
+					T* operator->() const;
+
+				private:
+
+					context_pool& m_pool;
+					T* m_context;
+			};
+
+			/**
+			 * \brief Create a new context_pool.
+			 * \param max_size The maximum count of free contexts kept per thread.
+			 */
+			explicit context_pool(size_t max_size = default_max_size);
+
+			/**
+			 * \brief Destroy all the free contexts of the calling thread.
+			 */
+			void clear();
+
+		private:
+
+			typedef std::vector<T*> free_list_type;
+
+			static void cleanup(free_list_type* free_list);
+
+			free_list_type& free_list();
+			T* acquire();
+			void release(T* context);
+
+			size_t m_max_size;
+			boost::thread_specific_ptr<free_list_type> m_free_list;
+	};
+
+	template <typename T>
+	const size_t context_pool<T>::default_max_size;
+
+	template <typename T>
+	inline context_pool<T>::lease::lease(context_pool& pool) :
+		m_pool(pool),
+		m_context(pool.acquire())
+	{
+	}
+
+	template <typename T>
+	inline context_pool<T>::lease::~lease()
+	{
+		m_pool.release(m_context);
+	}
+
+	template <typename T>
+	inline T& context_pool<T>::lease::get() const
+	{
+		return *m_context;
+	}
+
+	template <typename T>
+	inline T& context_pool<T>::lease::operator*() const
+	{
+		return *m_context;
+	}
+
+	template <typename T>
+	inline T* context_pool<T>::lease::operator->() const
+	{
+		return m_context;
+	}
+
+	template <typename T>
+	inline context_pool<T>::context_pool(size_t max_size) :
+		m_max_size(max_size),
+		m_free_list(&context_pool<T>::cleanup)
+	{
+	}
+
+	template <typename T>
+	inline void context_pool<T>::clear()
+	{
+		m_free_list.reset();
+	}
+
+	template <typename T>
+	inline void context_pool<T>::cleanup(free_list_type* _free_list)
+	{
+		for (typename free_list_type::iterator context = _free_list->begin(); context != _free_list->end(); ++context)
+		{
+			delete *context;
+		}
+
+		delete _free_list;
+	}
+
+	template <typename T>
+	inline typename context_pool<T>::free_list_type& context_pool<T>::free_list()
+	{
+		free_list_type* result = m_free_list.get();
+
+		if (!result)
+		{
+			result = new free_list_type();
+			result->reserve(m_max_size);
+			m_free_list.reset(result);
+		}
+
+		return *result;
+	}
+
+	template <typename T>
+	inline T* context_pool<T>::acquire()
+	{
+		free_list_type& _free_list = free_list();
+
+		if (_free_list.empty())
+		{
+			return new T();
+		}
+
+		T* result = _free_list.back();
+		_free_list.pop_back();
+
+		return result;
+	}
+
+	template <typename T>
+	inline void context_pool<T>::release(T* context)
+	{
+		free_list_type& _free_list = free_list();
+
+		if (_free_list.size() < m_max_size)
+		{
+			// Erase the previous state (and its key material) now rather than when the context is reused.
+			context_pool_traits<T>::reset(*context);
+
+			_free_list.push_back(context);
+		}
+		else
+		{
+			delete context;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CONTEXT_POOL_HPP */
@@ -69,12 +69,36 @@ namespace cryptoplus
 		}
 	}
 
+	/**
+	 * \brief Load all the algorithms and fill the algorithm registry.
+	 */
+	void _algorithms_initialize();
+
+	/**
+	 * \brief Empty the algorithm registry and unload all the algorithms.
+	 */
+	void _algorithms_cleanup();
+
+	/**
+	 * \brief Install the OpenSSL locking callbacks.
+	 *
+	 * Does nothing with OpenSSL 1.1.0 and later, which handle locking internally.
+	 */
+	void _threading_initialize();
+
+	/**
+	 * \brief Remove the OpenSSL locking callbacks.
+	 */
+	void _threading_cleanup();
+
 	/**
 	 * \brief The algorithms initializer.
 	 *
 	 * Only one instance of this class should be created. When an instance exists, the library can proceed to name resolutions.
+	 *
+	 * The names and types of all the cipher and message digest algorithms are looked up once, when the instance is created, so that creating a cipher::cipher_algorithm or a hash::message_digest_algorithm from a name or a type does not call into OpenSSL anymore. The instance should be created before any other thread uses the library.
 	 */
-	typedef initializer<_OpenSSL_add_all_algorithms, EVP_cleanup> algorithms_initializer;
+	typedef initializer<_algorithms_initialize, _algorithms_cleanup> algorithms_initializer;
 
 	/**
 	 * \brief The crypto initializer.
@@ -82,6 +106,15 @@ namespace cryptoplus
 	 * Only one instance of this class should be created. When an instance exists, it will prevent memory leaks related to the libcrypto's internals.
 	 */
 	typedef initializer<_null_function, CRYPTO_cleanup_all_ex_data> crypto_initializer;
+
+	/**
+	 * \brief The threading initializer.
+	 *
+	 * Only one instance of this class should be created. When an instance exists, OpenSSL can be safely used from several threads at once.
+	 *
+	 * With OpenSSL versions prior to 1.1.0, an instance must exist before any multi-threaded function of the library is called.
+	 */
+	typedef initializer<_threading_initialize, _threading_cleanup> threading_initializer;
 }
 
 #endif /* CRYPTOPLUS_CRYPTOPLUS_HPP */
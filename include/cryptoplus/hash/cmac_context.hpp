@@ -0,0 +1,256 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file cmac_context.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A CMAC context class.
+ */
+
+#ifndef CRYPTOPLUS_HASH_CMAC_CONTEXT_HPP
+#define CRYPTOPLUS_HASH_CMAC_CONTEXT_HPP
+
+#include "../error/cryptographic_exception.hpp"
+#include "../cipher/cipher_algorithm.hpp"
+
+#include <openssl/opensslv.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+#include <cstddef>
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+#include <openssl/cmac.h>
+
+namespace cryptoplus
+{
+	namespace hash
+	{
+		/**
+		 * \brief A CMAC context class.
+		 *
+		 * The cmac_context class computes CMACs (NIST SP 800-38B, RFC 4493 for AES-CMAC) using a block cipher.
+		 *
+		 * The key is set once by initialize(). reset() starts a new message and keeps the expanded key and the CMAC subkeys, so that each message only costs its block cipher operations.
+		 *
+		 * A cmac_context is non-copyable by design.
+		 */
+		class cmac_context : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief A message descriptor, for batch computations.
+				 */
+				struct message
+				{
+					/**
+					 * \brief The data to authenticate.
+					 */
+					const void* data;
+
+					/**
+					 * \brief The length of data.
+					 */
+					size_t data_len;
+
+					/**
+					 * \brief The output buffer. Should be at least result_size() bytes long. Cannot be NULL.
+					 */
+					void* mac;
+
+					/**
+					 * \brief The length of mac.
+					 */
+					size_t mac_len;
+
+					/**
+					 * \brief The count of bytes written to mac. Set by compute().
+					 */
+					size_t result;
+				};
+
+				/**
+				 * \brief Create a new cmac_context.
+				 */
+				cmac_context();
+
+				/**
+				 * \brief Destroy a cmac_context.
+				 *
+				 * Calls CMAC_CTX_free() on the internal CMAC_CTX.
+				 */
+				~cmac_context();
+
+				/**
+				 * \brief Initialize the cmac_context.
+				 * \param key The key to use. Cannot be NULL.
+				 * \param key_len The key length. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param algorithm The block cipher algorithm to use, in CBC mode (for instance AES-128-CBC).
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				void initialize(const void* key, size_t key_len, const cipher::cipher_algorithm& algorithm, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Start a new message, keeping the current key.
+				 */
+				void reset();
+
+				/**
+				 * \brief Update the cmac_context with some data.
+				 * \param data The data buffer.
+				 * \param len The data length.
+				 */
+				void update(const void* data, size_t len);
+
+				/**
+				 * \brief Finalize the cmac_context and get the resulting MAC.
+				 * \param mac The resulting buffer. Cannot be NULL.
+				 * \param len The length of mac. Should be at least result_size().
+				 * \return The number of bytes written.
+				 *
+				 * After a call to finalize() no more call to update() can be made unless reset() or initialize() is called again first.
+				 */
+				size_t finalize(void* mac, size_t len);
+
+				/**
+				 * \brief Finalize the cmac_context and get the resulting MAC.
+				 * \return The resulting MAC.
+				 */
+				template <typename T>
+				std::vector<T> finalize();
+
+				/**
+				 * \brief Compute the MAC of a complete message, keeping the current key.
+				 * \param mac The resulting buffer. Cannot be NULL.
+				 * \param mac_len The length of mac. Should be at least result_size().
+				 * \param data The data to authenticate.
+				 * \param data_len The length of data.
+				 * \return The number of bytes written.
+				 */
+				size_t compute(void* mac, size_t mac_len, const void* data, size_t data_len);
+
+				/**
+				 * \brief Compute the MACs of a batch of messages, keeping the current key.
+				 * \param messages The messages. The result member of each message is updated.
+				 * \param messages_count The count of messages.
+				 */
+				void compute(message* messages, size_t messages_count);
+
+				/**
+				 * \brief Compute the MACs of a batch of messages, keeping the current key.
+				 * \param messages The messages. The result member of each message is updated.
+				 */
+				void compute(std::vector<message>& messages);
+
+				/**
+				 * \brief Get the size of the MACs.
+				 * \return The size of the MACs, that is the block size of the cipher algorithm. If no call to initialize() was done, the behavior is undefined.
+				 */
+				size_t result_size() const;
+
+				/**
+				 * \brief Get the underlying context.
+				 * \return The underlying context.
+				 * \warning This method is provided for compatibility issues only. Its use is greatly discouraged.
+				 */
+				CMAC_CTX* raw();
+
+			private:
+
+				CMAC_CTX* m_ctx;
+				size_t m_result_size;
+		};
+
+		inline cmac_context::cmac_context() :
+			m_ctx(CMAC_CTX_new()),
+			m_result_size(0)
+		{
+			error::throw_error_if_not(m_ctx);
+		}
+
+		inline cmac_context::~cmac_context()
+		{
+			CMAC_CTX_free(m_ctx);
+		}
+
+		inline void cmac_context::reset()
+		{
+			error::throw_error_if_not(CMAC_Init(m_ctx, NULL, 0, NULL, NULL) != 0);
+		}
+
+		inline void cmac_context::update(const void* data, size_t len)
+		{
+			error::throw_error_if_not(CMAC_Update(m_ctx, data, len) != 0);
+		}
+
+		template <typename T>
+		inline std::vector<T> cmac_context::finalize()
+		{
+			std::vector<T> result(result_size());
+
+			finalize(&result[0], result.size());
+
+			return result;
+		}
+
+		inline void cmac_context::compute(std::vector<message>& messages)
+		{
+			if (!messages.empty())
+			{
+				compute(&messages[0], messages.size());
+			}
+		}
+
+		inline size_t cmac_context::result_size() const
+		{
+			return m_result_size;
+		}
+
+		inline CMAC_CTX* cmac_context::raw()
+		{
+			return m_ctx;
+		}
+	}
+}
+
+#endif
+
+#endif /* CRYPTOPLUS_HASH_CMAC_CONTEXT_HPP */
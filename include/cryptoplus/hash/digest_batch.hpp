@@ -0,0 +1,175 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file digest_batch.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A batch message digest class.
+ */
+
+#ifndef CRYPTOPLUS_HASH_DIGEST_BATCH_HPP
+#define CRYPTOPLUS_HASH_DIGEST_BATCH_HPP
+
+#include "message_digest_algorithm.hpp"
+#include "message_digest_context.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace hash
+	{
+		/**
+		 * \brief A batch message digest class.
+		 *
+		 * The digest_batch class hashes many independent messages in a single call.
+		 *
+		 * For SHA-256, the messages are hashed several at a time by a multi-buffer kernel: each SIMD lane holds the state of a different message, and a lane is refilled with the next message as soon as its current one is done. The kernel uses 4 lanes with SSE2, or 8 lanes if the library was built with AVX2 support and the CPU has AVX2. When the CPU has the SHA-NI instructions, OpenSSL's single-buffer implementation is faster and is used instead.
+		 *
+		 * The other algorithms, and every algorithm when an engine is specified, are hashed one message at a time with a message_digest_context.
+		 *
+		 * digest_batch is noncopyable by design.
+		 */
+		class digest_batch : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief A message descriptor.
+				 */
+				struct message
+				{
+					/**
+					 * \brief The data to hash. Can be NULL if data_len is 0.
+					 */
+					const void* data;
+
+					/**
+					 * \brief The length of data.
+					 */
+					size_t data_len;
+
+					/**
+					 * \brief The output buffer. Cannot be NULL.
+					 */
+					void* md;
+
+					/**
+					 * \brief The length of md. Must be at least algorithm().result_size().
+					 */
+					size_t md_len;
+
+					/**
+					 * \brief The count of bytes written to md. Set by compute().
+					 */
+					size_t result;
+				};
+
+				/**
+				 * \brief Create a new digest_batch.
+				 * \param algorithm The message digest algorithm to use.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 *
+				 * The kernel is selected once, here.
+				 */
+				explicit digest_batch(const message_digest_algorithm& algorithm, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Hash a batch of messages.
+				 * \param messages The messages. The result member of each message is updated.
+				 * \param messages_count The count of messages.
+				 *
+				 * If the md buffer of any message is too small, a std::logic_error is thrown and no message is hashed.
+				 */
+				void compute(message* messages, size_t messages_count);
+
+				/**
+				 * \brief Hash a batch of messages.
+				 * \param messages The messages. The result member of each message is updated.
+				 *
+				 * If the md buffer of any message is too small, a std::logic_error is thrown and no message is hashed.
+				 */
+				void compute(std::vector<message>& messages);
+
+				/**
+				 * \brief Get the count of messages hashed at once.
+				 * \return The count of SIMD lanes of the selected kernel, or 1 if the messages are hashed one at a time.
+				 */
+				size_t lanes() const;
+
+				/**
+				 * \brief Get the associated message digest algorithm.
+				 * \return The associated message digest algorithm.
+				 */
+				message_digest_algorithm algorithm() const;
+
+			private:
+
+				typedef void (*kernel_type)(message*, size_t);
+
+				message_digest_algorithm m_algorithm;
+				ENGINE* m_impl;
+				kernel_type m_kernel;
+				size_t m_lanes;
+				message_digest_context m_ctx;
+		};
+
+		inline void digest_batch::compute(std::vector<message>& messages)
+		{
+			if (!messages.empty())
+			{
+				compute(&messages[0], messages.size());
+			}
+		}
+
+		inline size_t digest_batch::lanes() const
+		{
+			return m_lanes;
+		}
+
+		inline message_digest_algorithm digest_batch::algorithm() const
+		{
+			return m_algorithm;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_HASH_DIGEST_BATCH_HPP */
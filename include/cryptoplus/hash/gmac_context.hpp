@@ -0,0 +1,242 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file gmac_context.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A GMAC context class.
+ */
+
+#ifndef CRYPTOPLUS_HASH_GMAC_CONTEXT_HPP
+#define CRYPTOPLUS_HASH_GMAC_CONTEXT_HPP
+
+#include "../cipher/aead_context.hpp"
+
+#include <openssl/opensslv.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+#include <cstddef>
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+namespace cryptoplus
+{
+	namespace hash
+	{
+		/**
+		 * \brief A GMAC context class.
+		 *
+		 * The gmac_context class computes GMACs (NIST SP 800-38D): GCM authentication tags over data that is only authenticated, not encrypted.
+		 *
+		 * The key is set once by initialize(). Each message then needs its own IV, given to reset(): an IV must never be reused with the same key.
+		 *
+		 * A gmac_context is non-copyable by design.
+		 */
+		class gmac_context : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief A message descriptor, for batch computations.
+				 */
+				struct message
+				{
+					/**
+					 * \brief The IV. Must be iv_length() bytes long.
+					 */
+					const void* iv;
+
+					/**
+					 * \brief The data to authenticate.
+					 */
+					const void* data;
+
+					/**
+					 * \brief The length of data.
+					 */
+					size_t data_len;
+
+					/**
+					 * \brief The output buffer. Should be at least result_size() bytes long. Cannot be NULL.
+					 */
+					void* mac;
+
+					/**
+					 * \brief The length of mac.
+					 */
+					size_t mac_len;
+
+					/**
+					 * \brief The count of bytes written to mac. Set by compute().
+					 */
+					size_t result;
+				};
+
+				/**
+				 * \brief Initialize the gmac_context.
+				 * \param key The key to use. Cannot be NULL.
+				 * \param key_len The key length. Must match algorithm.key_length() or a std::runtime_error is thrown.
+				 * \param algorithm The GCM cipher algorithm to use (for instance AES-128-GCM).
+				 * \param iv_len The length of the IVs. If iv_len is 0, algorithm.iv_length() is used.
+				 * \param mac_len The length of the MACs.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				void initialize(const void* key, size_t key_len, const cipher::cipher_algorithm& algorithm, size_t iv_len = 0, size_t mac_len = cipher::aead_context::default_tag_length, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Start a new message, keeping the current key.
+				 * \param iv The IV of the message. Cannot be NULL.
+				 * \param iv_len The length of iv. Must match iv_length() or a std::runtime_error is thrown.
+				 */
+				void reset(const void* iv, size_t iv_len);
+
+				/**
+				 * \brief Update the gmac_context with some data.
+				 * \param data The data buffer.
+				 * \param len The data length.
+				 */
+				void update(const void* data, size_t len);
+
+				/**
+				 * \brief Finalize the gmac_context and get the resulting MAC.
+				 * \param mac The resulting buffer. Cannot be NULL.
+				 * \param len The length of mac. Should be at least result_size().
+				 * \return The number of bytes written.
+				 *
+				 * After a call to finalize() no more call to update() can be made unless reset() is called again first.
+				 */
+				size_t finalize(void* mac, size_t len);
+
+				/**
+				 * \brief Finalize the gmac_context and get the resulting MAC.
+				 * \return The resulting MAC.
+				 */
+				template <typename T>
+				std::vector<T> finalize();
+
+				/**
+				 * \brief Compute the MAC of a complete message, keeping the current key.
+				 * \param mac The resulting buffer. Cannot be NULL.
+				 * \param mac_len The length of mac. Should be at least result_size().
+				 * \param iv The IV of the message. Cannot be NULL.
+				 * \param iv_len The length of iv. Must match iv_length().
+				 * \param data The data to authenticate.
+				 * \param data_len The length of data.
+				 * \return The number of bytes written.
+				 */
+				size_t compute(void* mac, size_t mac_len, const void* iv, size_t iv_len, const void* data, size_t data_len);
+
+				/**
+				 * \brief Compute the MACs of a batch of messages, keeping the current key.
+				 * \param messages The messages. The result member of each message is updated.
+				 * \param messages_count The count of messages.
+				 */
+				void compute(message* messages, size_t messages_count);
+
+				/**
+				 * \brief Compute the MACs of a batch of messages, keeping the current key.
+				 * \param messages The messages. The result member of each message is updated.
+				 */
+				void compute(std::vector<message>& messages);
+
+				/**
+				 * \brief Get the IV length.
+				 * \return The IV length.
+				 */
+				size_t iv_length() const;
+
+				/**
+				 * \brief Get the size of the MACs.
+				 * \return The size of the MACs.
+				 */
+				size_t result_size() const;
+
+			private:
+
+				cipher::aead_context m_ctx;
+		};
+
+		inline void gmac_context::reset(const void* iv, size_t iv_len)
+		{
+			m_ctx.set_iv(iv, iv_len);
+		}
+
+		inline void gmac_context::update(const void* data, size_t len)
+		{
+			// Feeding no data to a GCM context would finalize it.
+			if (len > 0)
+			{
+				m_ctx.update_aad(data, len);
+			}
+		}
+
+		template <typename T>
+		inline std::vector<T> gmac_context::finalize()
+		{
+			std::vector<T> result(result_size());
+
+			finalize(&result[0], result.size());
+
+			return result;
+		}
+
+		inline void gmac_context::compute(std::vector<message>& messages)
+		{
+			if (!messages.empty())
+			{
+				compute(&messages[0], messages.size());
+			}
+		}
+
+		inline size_t gmac_context::iv_length() const
+		{
+			return m_ctx.iv_length();
+		}
+
+		inline size_t gmac_context::result_size() const
+		{
+			return m_ctx.tag_length();
+		}
+	}
+}
+
+#endif
+
+#endif /* CRYPTOPLUS_HASH_GMAC_CONTEXT_HPP */
@@ -46,14 +46,16 @@
 #define CRYPTOPLUS_HASH_HMAC_CONTEXT_HPP
 
 #include "../error/cryptographic_exception.hpp"
+#include "../context_pool.hpp"
 #include "message_digest_algorithm.hpp"
 
 #include <openssl/opensslv.h>
 #include <openssl/hmac.h>
 
-#include <boost/noncopyable.hpp>
+#include <boost/move/move.hpp>
 
 #include <vector>
+#include <cstring>
 
 namespace cryptoplus
 {
@@ -66,10 +68,12 @@ namespace cryptoplus
 		 *
 		 * The list of the available hash methods depends on the version of OpenSSL and can be found on the man page of EVP_DigestInit().
 		 *
-		 * A hmac_context is non-copyable by design.
+		 * A hmac_context is non-copyable by design but is movable, using Boost.Move: the OpenSSL state, including the padded keys, is transferred and not recomputed. A moved-from hmac_context is left uninitialized.
 		 */
-		class hmac_context : public boost::noncopyable
+		class hmac_context
 		{
+			BOOST_MOVABLE_BUT_NOT_COPYABLE(hmac_context)
+
 			public:
 
 				/**
@@ -84,6 +88,19 @@ namespace cryptoplus
 				 */
 				~hmac_context();
 
+				/**
+				 * \brief Move constructor.
+				 * \param other The hmac_context to move from. It is left uninitialized.
+				 */
+				hmac_context(BOOST_RV_REF(hmac_context) other);
+
+				/**
+				 * \brief Move assignment operator.
+				 * \param other The hmac_context to move from. It is left uninitialized.
+				 * \return *this.
+				 */
+				hmac_context& operator=(BOOST_RV_REF(hmac_context) other);
+
 				/**
 				 * \brief Initialize the hmac_context.
 				 * \param key The key to use. If key is NULL, the previously used key is taken.
@@ -147,6 +164,25 @@ namespace cryptoplus
 			HMAC_CTX_cleanup(&m_ctx);
 		}
 
+		inline hmac_context::hmac_context(BOOST_RV_REF(hmac_context) other)
+		{
+			// The OpenSSL context only points to heap-allocated state: a bitwise copy transfers it.
+			std::memcpy(&m_ctx, &other.m_ctx, sizeof(m_ctx));
+			HMAC_CTX_init(&other.m_ctx);
+		}
+
+		inline hmac_context& hmac_context::operator=(BOOST_RV_REF(hmac_context) other)
+		{
+			if (this != &other)
+			{
+				HMAC_CTX_cleanup(&m_ctx);
+				std::memcpy(&m_ctx, &other.m_ctx, sizeof(m_ctx));
+				HMAC_CTX_init(&other.m_ctx);
+			}
+
+			return *this;
+		}
+
 		inline void hmac_context::update(const void* data, size_t len)
 		{
 #if OPENSSL_VERSION_NUMBER < 0x01000000
@@ -177,6 +213,21 @@ namespace cryptoplus
 			return message_digest_algorithm(m_ctx.md);
 		}
 	}
+
+	/**
+	 * \brief The context_pool traits of hmac_context.
+	 */
+	template <>
+	struct context_pool_traits<hash::hmac_context>
+	{
+		/**
+		 * \brief Erase the key and the keyed digest states of a hmac_context.
+		 * \param context The context.
+		 *
+		 * The digest states stay allocated, so that the next initialization with the same algorithm allocates nothing. The context must be initialized with a key before its next use.
+		 */
+		static void reset(hash::hmac_context& context);
+	};
 }
 
 #endif /* CRYPTOPLUS_HASH_HMAC_CONTEXT_HPP */
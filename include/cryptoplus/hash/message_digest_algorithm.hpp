@@ -70,6 +70,8 @@ namespace cryptoplus
 				 * \brief Create a new message_digest_algorithm from its type (NID).
 				 * \param type The type of the message_digest_algorithm to create.
 				 * \warning If no such type is found, a std::invalid_argument is thrown.
+				 *
+				 * Once an algorithms_initializer exists, the lookup does not call into OpenSSL.
 				 */
 				explicit message_digest_algorithm(int type);
 
@@ -77,6 +79,8 @@ namespace cryptoplus
 				 * \brief Create a new message_digest_algorithm from its name.
 				 * \param name The name of the message_digest_algorithm to create.
 				 * \warning If no such name is found, a std::invalid_argument is thrown.
+				 *
+				 * Once an algorithms_initializer exists, the lookup does not call into OpenSSL.
 				 */
 				explicit message_digest_algorithm(const std::string& name);
 
@@ -112,12 +116,16 @@ namespace cryptoplus
 
 			private:
 
+				void set_md(const EVP_MD* md);
+
 				const EVP_MD* m_md;
+				size_t m_result_size;
+				size_t m_block_size;
 		};
 
-		inline message_digest_algorithm::message_digest_algorithm(const EVP_MD* md) :
-			m_md(md)
+		inline message_digest_algorithm::message_digest_algorithm(const EVP_MD* md)
 		{
+			set_md(md);
 		}
 
 		inline const EVP_MD* message_digest_algorithm::raw() const
@@ -137,12 +145,28 @@ namespace cryptoplus
 
 		inline size_t message_digest_algorithm::result_size() const
 		{
-			return EVP_MD_size(m_md);
+			return m_result_size;
 		}
 
 		inline size_t message_digest_algorithm::block_size() const
 		{
-			return EVP_MD_block_size(m_md);
+			return m_block_size;
+		}
+
+		inline void message_digest_algorithm::set_md(const EVP_MD* md)
+		{
+			m_md = md;
+
+			if (m_md)
+			{
+				m_result_size = EVP_MD_size(m_md);
+				m_block_size = EVP_MD_block_size(m_md);
+			}
+			else
+			{
+				m_result_size = 0;
+				m_block_size = 0;
+			}
 		}
 	}
 }
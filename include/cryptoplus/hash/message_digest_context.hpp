@@ -46,14 +46,16 @@
 #define CRYPTOPLUS_HASH_MESSAGE_DIGEST_CONTEXT_HPP
 
 #include "../error/cryptographic_exception.hpp"
+#include "../context_pool.hpp"
 #include "message_digest_algorithm.hpp"
 #include "../pkey/pkey.hpp"
 
 #include <openssl/evp.h>
 
-#include <boost/noncopyable.hpp>
+#include <boost/move/move.hpp>
 
 #include <vector>
+#include <cstring>
 
 namespace cryptoplus
 {
@@ -67,9 +69,13 @@ namespace cryptoplus
 		 * The list of the available hash methods depends on the version of OpenSSL and can be found on the man page of EVP_DigestInit().
 		 *
 		 * message_digest_context is noncopyable by design, however you may copy an existing message_digest_context using copy(). This is useful when you have to compute the hash of several values that differ only in their last bytes.
+		 *
+		 * message_digest_context is movable, using Boost.Move: the OpenSSL state is transferred and not recomputed. A moved-from message_digest_context is left uninitialized.
 		 */
-		class message_digest_context : public boost::noncopyable
+		class message_digest_context
 		{
+			BOOST_MOVABLE_BUT_NOT_COPYABLE(message_digest_context)
+
 			public:
 
 				/**
@@ -84,6 +90,19 @@ namespace cryptoplus
 				 */
 				~message_digest_context();
 
+				/**
+				 * \brief Move constructor.
+				 * \param other The message_digest_context to move from. It is left uninitialized.
+				 */
+				message_digest_context(BOOST_RV_REF(message_digest_context) other);
+
+				/**
+				 * \brief Move assignment operator.
+				 * \param other The message_digest_context to move from. It is left uninitialized.
+				 * \return *this.
+				 */
+				message_digest_context& operator=(BOOST_RV_REF(message_digest_context) other);
+
 				/**
 				 * \brief Initialize the message_digest_context.
 				 * \param algorithm The message digest algorithm to use.
@@ -219,6 +238,25 @@ namespace cryptoplus
 			EVP_MD_CTX_cleanup(&m_ctx);
 		}
 
+		inline message_digest_context::message_digest_context(BOOST_RV_REF(message_digest_context) other)
+		{
+			// The OpenSSL context only points to heap-allocated state: a bitwise copy transfers it.
+			std::memcpy(&m_ctx, &other.m_ctx, sizeof(m_ctx));
+			EVP_MD_CTX_init(&other.m_ctx);
+		}
+
+		inline message_digest_context& message_digest_context::operator=(BOOST_RV_REF(message_digest_context) other)
+		{
+			if (this != &other)
+			{
+				EVP_MD_CTX_cleanup(&m_ctx);
+				std::memcpy(&m_ctx, &other.m_ctx, sizeof(m_ctx));
+				EVP_MD_CTX_init(&other.m_ctx);
+			}
+
+			return *this;
+		}
+
 		inline void message_digest_context::initialize(const message_digest_algorithm& _algorithm, ENGINE* impl)
 		{
 			error::throw_error_if_not(EVP_DigestInit_ex(&m_ctx, _algorithm.raw(), impl) != 0);
@@ -284,6 +322,21 @@ namespace cryptoplus
 			return message_digest_algorithm(EVP_MD_CTX_md(&m_ctx));
 		}
 	}
+
+	/**
+	 * \brief The context_pool traits of message_digest_context.
+	 */
+	template <>
+	struct context_pool_traits<hash::message_digest_context>
+	{
+		/**
+		 * \brief Erase the digest state of a message_digest_context.
+		 * \param context The context.
+		 *
+		 * The digest state stays allocated, so that the next initialization with the same algorithm allocates nothing.
+		 */
+		static void reset(hash::message_digest_context& context);
+	};
 }
 
 #endif /* CRYPTOPLUS_HASH_MESSAGE_DIGEST_CONTEXT_HPP */
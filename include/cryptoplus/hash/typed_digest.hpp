@@ -0,0 +1,273 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file typed_digest.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Compile-time typed message digest classes.
+ */
+
+#ifndef CRYPTOPLUS_HASH_TYPED_DIGEST_HPP
+#define CRYPTOPLUS_HASH_TYPED_DIGEST_HPP
+
+#include "message_digest.hpp"
+#include "message_digest_context.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/array.hpp>
+
+#include <cstddef>
+#include <cassert>
+
+namespace cryptoplus
+{
+	namespace hash
+	{
+		/**
+		 * \brief The SHA-1 message digest tag.
+		 *
+		 * A message digest tag describes a message digest algorithm at compile time: its sizes are integral constant expressions and md() returns the matching OpenSSL message digest.
+		 */
+		struct sha1
+		{
+			static const size_t result_size = 20; /**< \brief The digest size. */
+			static const size_t block_size = 64; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL message digest.
+			 * \return The OpenSSL message digest.
+			 */
+			static const EVP_MD* md() { return EVP_sha1(); }
+		};
+
+		/**
+		 * \brief The SHA-224 message digest tag.
+		 */
+		struct sha224
+		{
+			static const size_t result_size = 28; /**< \brief The digest size. */
+			static const size_t block_size = 64; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL message digest.
+			 * \return The OpenSSL message digest.
+			 */
+			static const EVP_MD* md() { return EVP_sha224(); }
+		};
+
+		/**
+		 * \brief The SHA-256 message digest tag.
+		 */
+		struct sha256
+		{
+			static const size_t result_size = 32; /**< \brief The digest size. */
+			static const size_t block_size = 64; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL message digest.
+			 * \return The OpenSSL message digest.
+			 */
+			static const EVP_MD* md() { return EVP_sha256(); }
+		};
+
+		/**
+		 * \brief The SHA-384 message digest tag.
+		 */
+		struct sha384
+		{
+			static const size_t result_size = 48; /**< \brief The digest size. */
+			static const size_t block_size = 128; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL message digest.
+			 * \return The OpenSSL message digest.
+			 */
+			static const EVP_MD* md() { return EVP_sha384(); }
+		};
+
+		/**
+		 * \brief The SHA-512 message digest tag.
+		 */
+		struct sha512
+		{
+			static const size_t result_size = 64; /**< \brief The digest size. */
+			static const size_t block_size = 128; /**< \brief The block size. */
+
+			/**
+			 * \brief Get the OpenSSL message digest.
+			 * \return The OpenSSL message digest.
+			 */
+			static const EVP_MD* md() { return EVP_sha512(); }
+		};
+
+		/**
+		 * \brief A compile-time typed message digest.
+		 *
+		 * Algorithm is a message digest tag, such as sha256. The digest is returned as a fixed-size array, which does not allocate.
+		 *
+		 * typed_digest is a thin front-end to message_digest_context, which remains the generic, runtime-dispatched layer.
+		 *
+		 * typed_digest is noncopyable by design.
+		 */
+		template <typename Algorithm>
+		class typed_digest : public boost::noncopyable
+		{
+			public:
+
+				/**
+				 * \brief The message digest tag.
+				 */
+				typedef Algorithm algorithm_type;
+
+				static const size_t result_size = Algorithm::result_size; /**< \brief The digest size. */
+				static const size_t block_size = Algorithm::block_size; /**< \brief The block size. */
+
+				/**
+				 * \brief The digest type.
+				 */
+				typedef boost::array<unsigned char, result_size> result_type;
+
+				/**
+				 * \brief Compute the digest of a buffer.
+				 * \param data The buffer.
+				 * \param len The length of data.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 * \return The digest.
+				 */
+				static result_type compute(const void* data, size_t len, ENGINE* impl = NULL);
+
+				/**
+				 * \brief Create a new typed_digest, ready for a first message.
+				 * \param impl The engine to use. Default is NULL which indicates that no engine should be used.
+				 */
+				explicit typed_digest(ENGINE* impl = NULL);
+
+				/**
+				 * \brief Update the digest with some data.
+				 * \param data The data.
+				 * \param len The length of data.
+				 */
+				void update(const void* data, size_t len);
+
+				/**
+				 * \brief Finalize the digest of the current message.
+				 * \param result The digest.
+				 *
+				 * The typed_digest is then ready for a new message.
+				 */
+				void finalize(result_type& result);
+
+				/**
+				 * \brief Finalize the digest of the current message.
+				 * \return The digest.
+				 *
+				 * The typed_digest is then ready for a new message.
+				 */
+				result_type finalize();
+
+				/**
+				 * \brief Get the underlying message digest context.
+				 * \return The underlying message digest context.
+				 */
+				message_digest_context& context();
+
+			private:
+
+				message_digest_context m_ctx;
+				ENGINE* m_impl;
+		};
+
+		template <typename Algorithm>
+		const size_t typed_digest<Algorithm>::result_size;
+
+		template <typename Algorithm>
+		const size_t typed_digest<Algorithm>::block_size;
+
+		template <typename Algorithm>
+		inline typename typed_digest<Algorithm>::result_type typed_digest<Algorithm>::compute(const void* data, size_t len, ENGINE* impl)
+		{
+			result_type result;
+
+			message_digest(result.data(), result.size(), data, len, message_digest_algorithm(Algorithm::md()), impl);
+
+			return result;
+		}
+
+		template <typename Algorithm>
+		inline typed_digest<Algorithm>::typed_digest(ENGINE* impl) :
+			m_impl(impl)
+		{
+			const message_digest_algorithm algorithm(Algorithm::md());
+
+			assert(algorithm.result_size() == result_size);
+
+			m_ctx.initialize(algorithm, m_impl);
+		}
+
+		template <typename Algorithm>
+		inline void typed_digest<Algorithm>::update(const void* data, size_t len)
+		{
+			m_ctx.update(data, len);
+		}
+
+		template <typename Algorithm>
+		inline void typed_digest<Algorithm>::finalize(result_type& result)
+		{
+			m_ctx.finalize(result.data(), result.size());
+			m_ctx.initialize(message_digest_algorithm(Algorithm::md()), m_impl);
+		}
+
+		template <typename Algorithm>
+		inline typename typed_digest<Algorithm>::result_type typed_digest<Algorithm>::finalize()
+		{
+			result_type result;
+
+			finalize(result);
+
+			return result;
+		}
+
+		template <typename Algorithm>
+		inline message_digest_context& typed_digest<Algorithm>::context()
+		{
+			return m_ctx;
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_HASH_TYPED_DIGEST_HPP */
@@ -87,6 +87,36 @@ namespace cryptoplus
 		template <typename T>
 		std::vector<T> get_random_bytes(size_t cnt);
 
+		/**
+		 * \brief Get truly random bytes from a per-thread buffer.
+		 * \param buf The buffer to fill with the random bytes.
+		 * \param buf_len The number of random bytes to request. buf must be big enough to hold the data.
+		 * \see get_random_bytes
+		 * \see discard_buffered_random_bytes
+		 *
+		 * Each thread keeps a buffer of random_buffer_size bytes which is filled in one call to get_random_bytes() and refilled once exhausted. This is much cheaper than get_random_bytes() when many small requests are made. The served bytes are erased from the buffer.
+		 *
+		 * Requests larger than random_buffer_size are served by get_random_bytes() directly.
+		 *
+		 * On Unix, a child process created by fork() never serves the bytes buffered by its parent: the buffer is discarded on its first use in the child.
+		 *
+		 * If the PRNG was not seeded with enough randomness, the call fails and a cryptographic_exception is thrown.
+		 */
+		void get_buffered_random_bytes(void* buf, size_t buf_len);
+
+		/**
+		 * \brief Erase the random bytes buffered for the calling thread.
+		 * \see get_buffered_random_bytes
+		 *
+		 * The buffer is discarded automatically after fork(): this function is only needed to erase the buffered bytes early.
+		 */
+		void discard_buffered_random_bytes();
+
+		/**
+		 * \brief The size of the per-thread random buffer.
+		 */
+		const size_t random_buffer_size = 4096;
+
 		/**
 		 * \brief Get pseudo random bytes.
 		 * \param buf The buffer to fill with the random bytes. Its content will be mixed in the enthropy pool unless disabled at OpenSSL compile time.
@@ -136,6 +136,13 @@ class Environment(SConsEnvironment):
 
         return self.Program(sample, source, **kw)
 
+    def BoostLibraries(self, names):
+        """Get the platform-specific names of the specified boost libraries."""
+        if sys.platform == 'win32':
+            return ['boost_%s-%s-%s' % (name, self['boost_lib_suffix'], self['boost_version']) for name in names]
+        else:
+            return ['boost_%s' % name for name in names]
+
     def Documentation(self, **kw):
         doxygen = self.Doxygen('doxyfile', **kw)
         AlwaysBuild(doxygen)
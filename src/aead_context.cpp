@@ -0,0 +1,296 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file aead_context.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An AEAD cipher context class.
+ */
+
+#include "cipher/aead_context.hpp"
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+
+#include <cassert>
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			// The unauthenticated plaintext must not be left in the output buffer, nor the tag mismatch in the error queue.
+			bool reject_message(unsigned char* out, size_t len)
+			{
+				OPENSSL_cleanse(out, len);
+				ERR_clear_error();
+
+				return false;
+			}
+		}
+
+		const size_t aead_context::default_tag_length = 16;
+
+		void aead_context::initialize(const cipher_algorithm& _algorithm, cipher_context::cipher_direction direction, const void* key, size_t key_len, size_t iv_len, size_t tag_len, ENGINE* impl)
+		{
+			assert(key);
+
+			if (key_len != _algorithm.key_length())
+			{
+				throw std::runtime_error("key_len");
+			}
+
+			if (iv_len == 0)
+			{
+				iv_len = _algorithm.iv_length();
+			}
+
+			error::throw_error_if_not(EVP_CipherInit_ex(&m_ctx, _algorithm.raw(), impl, NULL, NULL, static_cast<int>(direction)) != 0);
+
+			if (iv_len != _algorithm.iv_length())
+			{
+				error::throw_error_if_not(EVP_CIPHER_CTX_ctrl(&m_ctx, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(iv_len), NULL) != 0);
+			}
+
+			if (is_ccm())
+			{
+				// CCM needs the tag length before the key is set.
+				error::throw_error_if_not(EVP_CIPHER_CTX_ctrl(&m_ctx, EVP_CTRL_CCM_SET_TAG, static_cast<int>(tag_len), NULL) != 0);
+			}
+
+			error::throw_error_if_not(EVP_CipherInit_ex(&m_ctx, NULL, NULL, static_cast<const unsigned char*>(key), NULL, -1) != 0);
+
+			m_iv_len = iv_len;
+			m_tag_len = tag_len;
+		}
+
+		size_t aead_context::update(void* out, size_t out_len, const void* in, size_t in_len)
+		{
+			assert(out);
+			assert(in);
+			assert(out_len >= in_len);
+
+			int iout_len = static_cast<int>(out_len);
+
+			error::throw_error_if_not(EVP_CipherUpdate(&m_ctx, static_cast<unsigned char*>(out), &iout_len, static_cast<const unsigned char*>(in), static_cast<int>(in_len)) != 0);
+
+			return iout_len;
+		}
+
+		size_t aead_context::finalize(void* out, size_t out_len)
+		{
+			assert(out);
+
+			int iout_len = static_cast<int>(out_len);
+
+			error::throw_error_if_not(EVP_CipherFinal_ex(&m_ctx, static_cast<unsigned char*>(out), &iout_len) != 0);
+
+			return iout_len;
+		}
+
+		bool aead_context::verify_finalize(void* out, size_t out_len)
+		{
+			assert(out);
+
+			if (is_ccm())
+			{
+				// CCM verifies the tag during update(): reaching this point means the tag matched.
+				return true;
+			}
+
+			int iout_len = static_cast<int>(out_len);
+
+			return (EVP_CipherFinal_ex(&m_ctx, static_cast<unsigned char*>(out), &iout_len) > 0);
+		}
+
+		void aead_context::get_tag(void* tag, size_t tag_len)
+		{
+			assert(tag);
+
+			if (tag_len != m_tag_len)
+			{
+				throw std::runtime_error("tag_len");
+			}
+
+			error::throw_error_if_not(EVP_CIPHER_CTX_ctrl(&m_ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(tag_len), tag) != 0);
+		}
+
+		void aead_context::set_tag(const void* tag, size_t tag_len)
+		{
+			assert(tag);
+
+			if (tag_len != m_tag_len)
+			{
+				throw std::runtime_error("tag_len");
+			}
+
+			// The tag is only read by OpenSSL, so the const_cast<> is safe.
+			error::throw_error_if_not(EVP_CIPHER_CTX_ctrl(&m_ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(tag_len), const_cast<void*>(tag)) != 0);
+		}
+
+		size_t aead_context::seal(void* out, size_t out_len, const void* iv, size_t iv_len, const void* aad, size_t aad_len, const void* in, size_t in_len)
+		{
+			assert(out);
+			assert(iv);
+			assert(in || (in_len == 0));
+
+			if (iv_len != m_iv_len)
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			if (out_len < in_len + m_tag_len)
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			unsigned char* cout = static_cast<unsigned char*>(out);
+			int len = 0;
+			int final_len = 0;
+
+			// All the calls are chained so that the error queue is checked only once per message.
+			bool success = (EVP_CipherInit_ex(&m_ctx, NULL, NULL, NULL, static_cast<const unsigned char*>(iv), -1) != 0);
+
+			if (success && is_ccm())
+			{
+				success = (EVP_CipherUpdate(&m_ctx, NULL, &len, NULL, static_cast<int>(in_len)) != 0);
+			}
+
+			if (success && (aad_len > 0))
+			{
+				success = (EVP_CipherUpdate(&m_ctx, NULL, &len, static_cast<const unsigned char*>(aad), static_cast<int>(aad_len)) != 0);
+			}
+
+			len = 0;
+
+			if (success && ((in_len > 0) || is_ccm()))
+			{
+				success = (EVP_CipherUpdate(&m_ctx, cout, &len, static_cast<const unsigned char*>(in), static_cast<int>(in_len)) != 0);
+			}
+
+			success = success && (EVP_CipherFinal_ex(&m_ctx, cout + len, &final_len) != 0);
+			success = success && (EVP_CIPHER_CTX_ctrl(&m_ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(m_tag_len), cout + len + final_len) != 0);
+
+			error::throw_error_if_not(success);
+
+			return len + final_len + m_tag_len;
+		}
+
+		bool aead_context::open(void* out, size_t out_len, const void* iv, size_t iv_len, const void* aad, size_t aad_len, const void* in, size_t in_len)
+		{
+			assert(out);
+			assert(iv);
+			assert(in);
+
+			if (iv_len != m_iv_len)
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			if (in_len < m_tag_len)
+			{
+				return false;
+			}
+
+			const size_t data_len = in_len - m_tag_len;
+
+			if (out_len < data_len)
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			unsigned char* cout = static_cast<unsigned char*>(out);
+			const unsigned char* cin = static_cast<const unsigned char*>(in);
+			unsigned char* tag = const_cast<unsigned char*>(cin + data_len);
+			int len = 0;
+
+			bool success = (EVP_CipherInit_ex(&m_ctx, NULL, NULL, NULL, static_cast<const unsigned char*>(iv), -1) != 0);
+
+			// The tag is only read by OpenSSL, so the const_cast<> is safe.
+			success = success && (EVP_CIPHER_CTX_ctrl(&m_ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(m_tag_len), tag) != 0);
+
+			if (is_ccm())
+			{
+				success = success && (EVP_CipherUpdate(&m_ctx, NULL, &len, NULL, static_cast<int>(data_len)) != 0);
+
+				if (success && (aad_len > 0))
+				{
+					success = (EVP_CipherUpdate(&m_ctx, NULL, &len, static_cast<const unsigned char*>(aad), static_cast<int>(aad_len)) != 0);
+				}
+
+				error::throw_error_if_not(success);
+
+				// For CCM, a tag mismatch is reported by the update call.
+				if (EVP_CipherUpdate(&m_ctx, cout, &len, cin, static_cast<int>(data_len)) <= 0)
+				{
+					return reject_message(cout, data_len);
+				}
+
+				return true;
+			}
+
+			if (success && (aad_len > 0))
+			{
+				success = (EVP_CipherUpdate(&m_ctx, NULL, &len, static_cast<const unsigned char*>(aad), static_cast<int>(aad_len)) != 0);
+			}
+
+			len = 0;
+
+			if (success && (data_len > 0))
+			{
+				success = (EVP_CipherUpdate(&m_ctx, cout, &len, cin, static_cast<int>(data_len)) != 0);
+			}
+
+			error::throw_error_if_not(success);
+
+			int final_len = 0;
+
+			if (EVP_CipherFinal_ex(&m_ctx, cout + len, &final_len) <= 0)
+			{
+				return reject_message(cout, data_len);
+			}
+
+			return true;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file algorithm_registry.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief The algorithm registry.
+ */
+
+#include "algorithm_registry.hpp"
+
+#include <boost/unordered_map.hpp>
+
+namespace cryptoplus
+{
+	namespace detail
+	{
+		namespace
+		{
+			typedef boost::unordered_map<std::string, cipher_entry> cipher_name_map;
+			typedef boost::unordered_map<int, cipher_entry> cipher_type_map;
+			typedef boost::unordered_map<std::string, digest_entry> digest_name_map;
+			typedef boost::unordered_map<int, digest_entry> digest_type_map;
+
+			cipher_name_map cipher_names;
+			cipher_type_map cipher_types;
+			digest_name_map digest_names;
+			digest_type_map digest_types;
+
+			cipher_entry make_cipher_entry(const EVP_CIPHER* cipher)
+			{
+				cipher_entry result = { cipher, static_cast<size_t>(EVP_CIPHER_block_size(cipher)), static_cast<size_t>(EVP_CIPHER_key_length(cipher)), static_cast<size_t>(EVP_CIPHER_iv_length(cipher)) };
+
+				return result;
+			}
+
+			digest_entry make_digest_entry(const EVP_MD* md)
+			{
+				digest_entry result = { md, static_cast<size_t>(EVP_MD_size(md)), static_cast<size_t>(EVP_MD_block_size(md)) };
+
+				return result;
+			}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10000000
+			void register_cipher(const EVP_CIPHER*, const char* from, const char*, void*)
+			{
+				// Aliases are given with a NULL cipher: resolving the name gives the aliased cipher.
+				const EVP_CIPHER* const cipher = EVP_get_cipherbyname(from);
+
+				if (cipher)
+				{
+					const cipher_entry entry = make_cipher_entry(cipher);
+
+					cipher_names[from] = entry;
+					cipher_types[EVP_CIPHER_nid(cipher)] = entry;
+				}
+			}
+
+			void register_digest(const EVP_MD*, const char* from, const char*, void*)
+			{
+				const EVP_MD* const md = EVP_get_digestbyname(from);
+
+				if (md)
+				{
+					const digest_entry entry = make_digest_entry(md);
+
+					digest_names[from] = entry;
+					digest_types[EVP_MD_type(md)] = entry;
+				}
+			}
+#endif
+
+			template <typename MapType>
+			const typename MapType::mapped_type* find(const MapType& map, const typename MapType::key_type& key)
+			{
+				const typename MapType::const_iterator it = map.find(key);
+
+				return (it != map.end()) ? &it->second : NULL;
+			}
+		}
+
+		void register_algorithms()
+		{
+#if OPENSSL_VERSION_NUMBER >= 0x10000000
+			EVP_CIPHER_do_all(register_cipher, NULL);
+			EVP_MD_do_all(register_digest, NULL);
+#endif
+		}
+
+		void unregister_algorithms()
+		{
+			cipher_names.clear();
+			cipher_types.clear();
+			digest_names.clear();
+			digest_types.clear();
+		}
+
+		const cipher_entry* find_cipher(const std::string& name)
+		{
+			return find(cipher_names, name);
+		}
+
+		const cipher_entry* find_cipher(int type)
+		{
+			return find(cipher_types, type);
+		}
+
+		const digest_entry* find_digest(const std::string& name)
+		{
+			return find(digest_names, name);
+		}
+
+		const digest_entry* find_digest(int type)
+		{
+			return find(digest_types, type);
+		}
+	}
+}
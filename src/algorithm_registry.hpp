@@ -0,0 +1,122 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file algorithm_registry.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief The algorithm registry.
+ *
+ * This header is private to the library and is not installed.
+ */
+
+#ifndef CRYPTOPLUS_ALGORITHM_REGISTRY_HPP
+#define CRYPTOPLUS_ALGORITHM_REGISTRY_HPP
+
+#include <openssl/evp.h>
+
+#include <string>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace detail
+	{
+		/**
+		 * \brief A registered cipher.
+		 */
+		struct cipher_entry
+		{
+			const EVP_CIPHER* cipher;
+			size_t block_size;
+			size_t key_length;
+			size_t iv_length;
+		};
+
+		/**
+		 * \brief A registered message digest.
+		 */
+		struct digest_entry
+		{
+			const EVP_MD* md;
+			size_t result_size;
+			size_t block_size;
+		};
+
+		/**
+		 * \brief Fill the registry with all the algorithms OpenSSL knows about.
+		 *
+		 * Called once, when the algorithms_initializer is created. The registry is read-only afterwards, so lookups do not need any lock.
+		 */
+		void register_algorithms();
+
+		/**
+		 * \brief Empty the registry.
+		 */
+		void unregister_algorithms();
+
+		/**
+		 * \brief Find a registered cipher by name.
+		 * \param name The name.
+		 * \return The cipher entry, or NULL if no such cipher was registered.
+		 */
+		const cipher_entry* find_cipher(const std::string& name);
+
+		/**
+		 * \brief Find a registered cipher by type (NID).
+		 * \param type The type.
+		 * \return The cipher entry, or NULL if no such cipher was registered.
+		 */
+		const cipher_entry* find_cipher(int type);
+
+		/**
+		 * \brief Find a registered message digest by name.
+		 * \param name The name.
+		 * \return The message digest entry, or NULL if no such message digest was registered.
+		 */
+		const digest_entry* find_digest(const std::string& name);
+
+		/**
+		 * \brief Find a registered message digest by type (NID).
+		 * \param type The type.
+		 * \return The message digest entry, or NULL if no such message digest was registered.
+		 */
+		const digest_entry* find_digest(int type);
+	}
+}
+
+#endif /* CRYPTOPLUS_ALGORITHM_REGISTRY_HPP */
@@ -0,0 +1,454 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file capabilities.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Host capabilities and fastest algorithm selection.
+ */
+
+#include "capabilities.hpp"
+
+#include "cipher/aead_context.hpp"
+#include "hash/message_digest.hpp"
+
+#include <openssl/crypto.h>
+#include <openssl/objects.h>
+
+#include <boost/thread/once.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define CRYPTOPLUS_X86
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+#endif
+
+namespace cryptoplus
+{
+	namespace
+	{
+		const unsigned int benchmark_rounds = 3;
+		const boost::posix_time::time_duration benchmark_round_duration = boost::posix_time::milliseconds(2);
+
+		unsigned int cpu_features = 0;
+		std::vector<aead_score> aead_ranking;
+		std::vector<hash_score> hash_ranking;
+
+		boost::once_flag cpu_features_flag = BOOST_ONCE_INIT;
+		boost::once_flag rankings_flag = BOOST_ONCE_INIT;
+
+#ifdef CRYPTOPLUS_X86
+		// The capability vector words: CPUID(1).EDX, CPUID(1).ECX and CPUID(7, 0).EBX.
+		void read_capability_vector(unsigned int cap[3])
+		{
+#if OPENSSL_VERSION_NUMBER < 0x30000000
+			// OpenSSL 1.0 declares the vector as unsigned long but stores it as unsigned int.
+			const unsigned int* const vector = reinterpret_cast<const unsigned int*>(OPENSSL_ia32cap_loc());
+
+			if (vector)
+			{
+				cap[0] = vector[0];
+				cap[1] = vector[1];
+#if OPENSSL_VERSION_NUMBER >= 0x10002000
+				cap[2] = vector[2];
+#endif
+			}
+#else
+			unsigned int regs[4] = { 0, 0, 0, 0 };
+			unsigned int max_leaf = 0;
+
+#ifdef _MSC_VER
+			int iregs[4];
+			__cpuid(iregs, 0);
+			max_leaf = iregs[0];
+			__cpuid(iregs, 1);
+			regs[2] = iregs[2];
+			regs[3] = iregs[3];
+#else
+			unsigned int dummy = 0;
+			__get_cpuid(0, &max_leaf, &dummy, &dummy, &dummy);
+			__get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+
+			cap[0] = regs[3];
+			cap[1] = regs[2];
+
+			if (max_leaf >= 7)
+			{
+#ifdef _MSC_VER
+				__cpuidex(iregs, 7, 0);
+				cap[2] = iregs[1];
+#else
+				__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+				cap[2] = regs[1];
+#endif
+			}
+
+			// The AVX state must be enabled by the operating system, as OpenSSL checks.
+			unsigned long long xcr0 = 0;
+
+			if (cap[1] & (1U << 27))
+			{
+#ifdef _MSC_VER
+				xcr0 = _xgetbv(0);
+#else
+				unsigned int eax = 0;
+				unsigned int edx = 0;
+				__asm__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+				xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+			}
+
+			if ((xcr0 & 0x06) != 0x06)
+			{
+				cap[1] &= ~(1U << 28);
+				cap[2] &= ~((1U << 5) | (1U << 16));
+			}
+			else if ((xcr0 & 0xe0) != 0xe0)
+			{
+				cap[2] &= ~(1U << 16);
+			}
+#endif
+		}
+#endif
+
+		void detect_cpu_features()
+		{
+#ifdef CRYPTOPLUS_X86
+			unsigned int cap[3] = { 0, 0, 0 };
+
+			read_capability_vector(cap);
+
+			const struct
+			{
+				unsigned int word;
+				unsigned int bit;
+				cpu_feature feature;
+			} bits[] =
+			{
+				{ 0, 26, cpu_sse2 },
+				{ 1, 9, cpu_ssse3 },
+				{ 1, 25, cpu_aes },
+				{ 1, 1, cpu_pclmulqdq },
+				{ 1, 28, cpu_avx },
+				{ 2, 5, cpu_avx2 },
+				{ 2, 29, cpu_sha },
+				{ 2, 16, cpu_avx512f }
+			};
+
+			for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); ++i)
+			{
+				if (cap[bits[i].word] & (1U << bits[i].bit))
+				{
+					cpu_features |= bits[i].feature;
+				}
+			}
+#endif
+		}
+
+		// Run the function for a round and return the number of calls per second.
+		template <typename Function>
+		double calls_per_second(Function function)
+		{
+			using boost::posix_time::microsec_clock;
+
+			const boost::posix_time::ptime start = microsec_clock::universal_time();
+			boost::posix_time::time_duration elapsed;
+			unsigned int calls = 0;
+
+			do
+			{
+				function();
+				++calls;
+
+				elapsed = microsec_clock::universal_time() - start;
+			}
+			while (elapsed < benchmark_round_duration);
+
+			return calls * 1000000.0 / static_cast<double>(elapsed.total_microseconds());
+		}
+
+		// Keep the best round, which is the least disturbed by the rest of the system.
+		template <typename Function>
+		double bytes_per_second(Function function)
+		{
+			double best = 0.0;
+
+			for (unsigned int round = 0; round < benchmark_rounds; ++round)
+			{
+				best = std::max(best, calls_per_second(function));
+			}
+
+			return best * capabilities_message_size;
+		}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+		class seal_function
+		{
+			public:
+
+				seal_function(cipher::aead_context& ctx, std::vector<unsigned char>& buf) :
+					m_ctx(ctx),
+					m_buf(buf)
+				{
+				}
+
+				void operator()() const
+				{
+					const unsigned char iv[EVP_MAX_IV_LENGTH] = {};
+
+					m_ctx.seal(&m_buf[0], m_buf.size(), iv, m_ctx.iv_length(), NULL, 0, &m_buf[0], capabilities_message_size);
+				}
+
+			private:
+
+				cipher::aead_context& m_ctx;
+				std::vector<unsigned char>& m_buf;
+		};
+#endif
+
+		class digest_function
+		{
+			public:
+
+				digest_function(const hash::message_digest_algorithm& algorithm, std::vector<unsigned char>& buf) :
+					m_algorithm(algorithm),
+					m_buf(buf)
+				{
+				}
+
+				void operator()() const
+				{
+					unsigned char result[EVP_MAX_MD_SIZE];
+
+					hash::message_digest(result, sizeof(result), &m_buf[0], capabilities_message_size, m_algorithm);
+				}
+
+			private:
+
+				hash::message_digest_algorithm m_algorithm;
+				std::vector<unsigned char>& m_buf;
+		};
+
+		bool is_constant_time(const cipher::cipher_algorithm& algorithm)
+		{
+#ifdef CRYPTOPLUS_X86
+			const int nid = algorithm.type();
+
+			if ((nid == NID_aes_128_gcm) || (nid == NID_aes_256_gcm))
+			{
+				// GHASH uses lookup tables unless PCLMULQDQ is available.
+				return ((cpu_features & cpu_pclmulqdq) != 0) && ((cpu_features & (cpu_aes | cpu_ssse3)) != 0);
+			}
+#else
+			static_cast<void>(algorithm);
+#endif
+
+			return true;
+		}
+
+		template <typename Score>
+		bool is_faster(const Score& lhs, const Score& rhs)
+		{
+			return (lhs.bytes_per_second > rhs.bytes_per_second);
+		}
+
+		void rank_aead_algorithms(std::vector<unsigned char>& buf)
+		{
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+			const int nids[] =
+			{
+				NID_aes_128_gcm,
+				NID_aes_256_gcm,
+#ifdef NID_chacha20_poly1305
+				NID_chacha20_poly1305,
+#endif
+			};
+
+			for (size_t i = 0; i < sizeof(nids) / sizeof(nids[0]); ++i)
+			{
+				const EVP_CIPHER* const cipher = EVP_get_cipherbynid(nids[i]);
+
+				if (cipher)
+				{
+					const cipher::cipher_algorithm algorithm(cipher);
+					const std::vector<unsigned char> key(algorithm.key_length());
+
+					cipher::aead_context ctx;
+					ctx.initialize(algorithm, cipher::cipher_context::encrypt, &key[0], key.size());
+
+					aead_ranking.push_back(aead_score(algorithm, bytes_per_second(seal_function(ctx, buf)), is_constant_time(algorithm)));
+				}
+			}
+
+			std::stable_sort(aead_ranking.begin(), aead_ranking.end(), is_faster<aead_score>);
+#else
+			static_cast<void>(buf);
+#endif
+		}
+
+		void rank_hash_algorithms(std::vector<unsigned char>& buf)
+		{
+			const int nids[] =
+			{
+				NID_sha256,
+				NID_sha512,
+#ifdef NID_sha512_256
+				NID_sha512_256,
+#endif
+#ifdef NID_sha3_256
+				NID_sha3_256,
+#endif
+#ifdef NID_blake2s256
+				NID_blake2s256,
+#endif
+#ifdef NID_blake2b512
+				NID_blake2b512,
+#endif
+			};
+
+			for (size_t i = 0; i < sizeof(nids) / sizeof(nids[0]); ++i)
+			{
+				const EVP_MD* const md = EVP_get_digestbynid(nids[i]);
+
+				if (md)
+				{
+					const hash::message_digest_algorithm algorithm(md);
+
+					hash_ranking.push_back(hash_score(algorithm, bytes_per_second(digest_function(algorithm, buf))));
+				}
+			}
+
+			std::stable_sort(hash_ranking.begin(), hash_ranking.end(), is_faster<hash_score>);
+		}
+
+		void rank_algorithms()
+		{
+			boost::call_once(detect_cpu_features, cpu_features_flag);
+
+			std::vector<unsigned char> buf(capabilities_message_size + EVP_MAX_BLOCK_LENGTH);
+
+			rank_aead_algorithms(buf);
+			rank_hash_algorithms(buf);
+		}
+	}
+
+	unsigned int get_cpu_features()
+	{
+		boost::call_once(detect_cpu_features, cpu_features_flag);
+
+		return cpu_features;
+	}
+
+	const std::vector<aead_score>& get_aead_ranking()
+	{
+		boost::call_once(rank_algorithms, rankings_flag);
+
+		return aead_ranking;
+	}
+
+	const std::vector<hash_score>& get_hash_ranking()
+	{
+		boost::call_once(rank_algorithms, rankings_flag);
+
+		return hash_ranking;
+	}
+
+	cipher::cipher_algorithm get_fastest_aead_algorithm(size_t min_key_length)
+	{
+		const std::vector<aead_score>& ranking = get_aead_ranking();
+		const aead_score* fastest = NULL;
+
+		for (std::vector<aead_score>::const_iterator score = ranking.begin(); score != ranking.end(); ++score)
+		{
+			if (score->algorithm.key_length() >= min_key_length)
+			{
+				if (score->constant_time)
+				{
+					return score->algorithm;
+				}
+
+				if (!fastest)
+				{
+					fastest = &*score;
+				}
+			}
+		}
+
+		if (!fastest)
+		{
+			throw std::runtime_error("No suitable AEAD algorithm");
+		}
+
+		return fastest->algorithm;
+	}
+
+	hash::message_digest_algorithm get_fastest_hash_algorithm(size_t min_result_size)
+	{
+		const std::vector<hash_score>& ranking = get_hash_ranking();
+
+		for (std::vector<hash_score>::const_iterator score = ranking.begin(); score != ranking.end(); ++score)
+		{
+			if (score->algorithm.result_size() >= min_result_size)
+			{
+				return score->algorithm;
+			}
+		}
+
+		throw std::runtime_error("No suitable message digest algorithm");
+	}
+
+	void _capabilities_initialize()
+	{
+		boost::call_once(rank_algorithms, rankings_flag);
+	}
+
+	void _capabilities_cleanup()
+	{
+	}
+}
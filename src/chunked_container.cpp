@@ -0,0 +1,389 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file chunked_container.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A seekable, chunked, authenticated encryption container format.
+ */
+
+#include "cipher/chunked_container.hpp"
+
+#include "parallel.hpp"
+
+#include <openssl/crypto.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			const unsigned char magic[4] = { 'C', 'P', 'C', 'C' };
+			const unsigned char version = 1;
+
+			// The header followed by the chunk index.
+			const size_t aad_size = chunked_container::header_size + 8;
+
+			void store_uint32(unsigned char* buf, boost::uint32_t value)
+			{
+				for (size_t i = 0; i < 4; ++i)
+				{
+					buf[i] = static_cast<unsigned char>(value >> (24 - 8 * i));
+				}
+			}
+
+			void store_uint64(unsigned char* buf, boost::uint64_t value)
+			{
+				for (size_t i = 0; i < 8; ++i)
+				{
+					buf[i] = static_cast<unsigned char>(value >> (56 - 8 * i));
+				}
+			}
+
+			boost::uint32_t load_uint32(const unsigned char* buf)
+			{
+				boost::uint32_t result = 0;
+
+				for (size_t i = 0; i < 4; ++i)
+				{
+					result = (result << 8) | buf[i];
+				}
+
+				return result;
+			}
+
+			boost::uint64_t load_uint64(const unsigned char* buf)
+			{
+				boost::uint64_t result = 0;
+
+				for (size_t i = 0; i < 8; ++i)
+				{
+					result = (result << 8) | buf[i];
+				}
+
+				return result;
+			}
+
+			void check_key(const cipher_algorithm& algorithm, const void* key, size_t key_len)
+			{
+				assert(key);
+
+				if (key_len != algorithm.key_length())
+				{
+					throw std::runtime_error("key_len");
+				}
+			}
+
+			void check_chunk_size(size_t chunk_size)
+			{
+				if ((chunk_size == 0) || (chunk_size > chunked_container::max_chunk_size))
+				{
+					throw std::runtime_error("chunk_size");
+				}
+			}
+
+			boost::uint64_t sealed_chunk_offset(size_t chunk_size, boost::uint64_t index)
+			{
+				return chunked_container::header_size + index * (chunked_container::nonce_size + chunk_size + chunked_container::tag_size);
+			}
+
+			class seal_task
+			{
+				public:
+
+					seal_task(unsigned char* out, const unsigned char* in, size_t in_len, size_t chunk_size, size_t chunks_count, size_t tasks_count, const unsigned char* header, const cipher_algorithm& algorithm, const std::vector<unsigned char>& key) :
+						m_out(out),
+						m_in(in),
+						m_in_len(in_len),
+						m_chunk_size(chunk_size),
+						m_chunks_count(chunks_count),
+						m_tasks_count(tasks_count),
+						m_header(header),
+						m_algorithm(algorithm),
+						m_key(key)
+					{
+					}
+
+					void operator()(size_t task)
+					{
+						// The key schedule is computed once for all the chunks of the task.
+						aead_context ctx;
+						ctx.initialize(m_algorithm, cipher_context::encrypt, &m_key[0], m_key.size(), chunked_container::nonce_size, chunked_container::tag_size);
+
+						unsigned char aad[aad_size];
+						std::memcpy(aad, m_header, chunked_container::header_size);
+
+						const size_t end = m_chunks_count * (task + 1) / m_tasks_count;
+
+						for (size_t index = m_chunks_count * task / m_tasks_count; index < end; ++index)
+						{
+							const size_t offset = index * m_chunk_size;
+							const size_t len = std::min(m_chunk_size, m_in_len - offset);
+
+							store_uint64(aad + chunked_container::header_size, index);
+
+							// The nonce was written beforehand, by the calling thread.
+							unsigned char* const sealed_chunk = m_out + sealed_chunk_offset(m_chunk_size, index);
+
+							ctx.seal(sealed_chunk + chunked_container::nonce_size, len + chunked_container::tag_size, sealed_chunk, chunked_container::nonce_size, aad, sizeof(aad), m_in + offset, len);
+						}
+					}
+
+				private:
+
+					unsigned char* m_out;
+					const unsigned char* m_in;
+					size_t m_in_len;
+					size_t m_chunk_size;
+					size_t m_chunks_count;
+					size_t m_tasks_count;
+					const unsigned char* m_header;
+					cipher_algorithm m_algorithm;
+					const std::vector<unsigned char>& m_key;
+			};
+
+			void read_from_memory(const unsigned char* buf, size_t buf_len, boost::uint64_t offset, void* out, size_t len)
+			{
+				if ((offset > buf_len) || (len > buf_len - offset))
+				{
+					throw std::runtime_error("offset");
+				}
+
+				std::memcpy(out, buf + offset, len);
+			}
+		}
+
+		const size_t chunked_container::header_size;
+		const size_t chunked_container::nonce_size;
+		const size_t chunked_container::tag_size;
+		const size_t chunked_container::default_chunk_size;
+		const size_t chunked_container::max_chunk_size;
+
+		boost::uint64_t chunked_container::chunks_count(size_t chunk_size, boost::uint64_t plaintext_size)
+		{
+			return std::max<boost::uint64_t>(1, (plaintext_size + chunk_size - 1) / chunk_size);
+		}
+
+		boost::uint64_t chunked_container::container_size(size_t chunk_size, boost::uint64_t plaintext_size)
+		{
+			return header_size + chunks_count(chunk_size, plaintext_size) * (nonce_size + tag_size) + plaintext_size;
+		}
+
+		chunked_writer::chunked_writer(const cipher_algorithm& algorithm, const void* key, size_t key_len, size_t chunk_size) :
+			m_algorithm(algorithm),
+			m_key(static_cast<const unsigned char*>(key), static_cast<const unsigned char*>(key) + key_len),
+			m_chunk_size(chunk_size),
+			m_nonces(nonce_source::random_nonce, chunked_container::nonce_size)
+		{
+			check_key(algorithm, key, key_len);
+			check_chunk_size(chunk_size);
+		}
+
+		size_t chunked_writer::sealed_size(size_t plaintext_size) const
+		{
+			return static_cast<size_t>(chunked_container::container_size(m_chunk_size, plaintext_size));
+		}
+
+		size_t chunked_writer::seal(void* out, size_t out_len, const void* in, size_t in_len, unsigned int thread_count) const
+		{
+			assert(out);
+			assert(in || (in_len == 0));
+
+			const size_t result = sealed_size(in_len);
+
+			if (out_len < result)
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			unsigned char* const cout = static_cast<unsigned char*>(out);
+
+			unsigned char* const header = cout;
+			std::memset(header, 0x00, chunked_container::header_size);
+			std::memcpy(header, magic, sizeof(magic));
+			header[4] = version;
+			store_uint32(header + 8, static_cast<boost::uint32_t>(m_chunk_size));
+			store_uint64(header + 12, in_len);
+			store_uint32(header + 20, static_cast<boost::uint32_t>(m_algorithm.type()));
+
+			const size_t chunks_count = static_cast<size_t>(chunked_container::chunks_count(m_chunk_size, in_len));
+
+			for (size_t index = 0; index < chunks_count; ++index)
+			{
+				m_nonces.generate(cout + sealed_chunk_offset(m_chunk_size, index), chunked_container::nonce_size);
+			}
+
+			const size_t tasks_count = detail::get_thread_count(thread_count, chunks_count);
+
+			seal_task task(cout, static_cast<const unsigned char*>(in), in_len, m_chunk_size, chunks_count, tasks_count, header, m_algorithm, m_key);
+
+			detail::parallel_for(tasks_count, static_cast<unsigned int>(tasks_count), task);
+
+			return result;
+		}
+
+		chunked_reader::chunked_reader(const cipher_algorithm& algorithm, const void* key, size_t key_len, const source_type& source) :
+			m_source(source),
+			m_chunk_index(0),
+			m_chunk_valid(false)
+		{
+			check_key(algorithm, key, key_len);
+
+			m_ctx.initialize(algorithm, cipher_context::decrypt, key, key_len, chunked_container::nonce_size, chunked_container::tag_size);
+
+			read_header();
+		}
+
+		chunked_reader::chunked_reader(const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* buf, size_t buf_len) :
+			m_source(boost::bind(&read_from_memory, static_cast<const unsigned char*>(buf), buf_len, _1, _2, _3)),
+			m_chunk_index(0),
+			m_chunk_valid(false)
+		{
+			check_key(algorithm, key, key_len);
+
+			m_ctx.initialize(algorithm, cipher_context::decrypt, key, key_len, chunked_container::nonce_size, chunked_container::tag_size);
+
+			read_header();
+		}
+
+		size_t chunked_reader::read_at(void* out, size_t len, boost::uint64_t offset)
+		{
+			assert(out || (len == 0));
+
+			if (offset >= m_size)
+			{
+				return 0;
+			}
+
+			len = static_cast<size_t>(std::min<boost::uint64_t>(len, m_size - offset));
+
+			unsigned char* cout = static_cast<unsigned char*>(out);
+
+			try
+			{
+				for (size_t done = 0; done < len;)
+				{
+					const boost::uint64_t position = offset + done;
+					const std::vector<unsigned char>& chunk = get_chunk(position / m_chunk_size);
+					const size_t chunk_offset = static_cast<size_t>(position % m_chunk_size);
+					const size_t chunk_len = std::min(len - done, chunk.size() - chunk_offset);
+
+					std::memcpy(cout + done, &chunk[chunk_offset], chunk_len);
+
+					done += chunk_len;
+				}
+			}
+			catch (...)
+			{
+				OPENSSL_cleanse(out, len);
+
+				throw;
+			}
+
+			return len;
+		}
+
+		void chunked_reader::read_header()
+		{
+			m_source(0, m_header, sizeof(m_header));
+
+			if ((std::memcmp(m_header, magic, sizeof(magic)) != 0) || (m_header[4] != version))
+			{
+				throw std::runtime_error("header");
+			}
+
+			m_chunk_size = load_uint32(m_header + 8);
+			m_size = load_uint64(m_header + 12);
+
+			check_chunk_size(m_chunk_size);
+
+			if (static_cast<int>(load_uint32(m_header + 20)) != m_ctx.algorithm().type())
+			{
+				throw std::runtime_error("algorithm");
+			}
+		}
+
+		const std::vector<unsigned char>& chunked_reader::get_chunk(boost::uint64_t index)
+		{
+			if (m_chunk_valid && (m_chunk_index == index))
+			{
+				return m_chunk;
+			}
+
+			m_chunk_valid = false;
+
+			const size_t len = static_cast<size_t>(std::min<boost::uint64_t>(m_chunk_size, m_size - index * m_chunk_size));
+
+			m_sealed_chunk.resize(chunked_container::nonce_size + len + chunked_container::tag_size);
+			m_chunk.resize(len);
+
+			m_source(sealed_chunk_offset(m_chunk_size, index), &m_sealed_chunk[0], m_sealed_chunk.size());
+
+			unsigned char aad[aad_size];
+			std::memcpy(aad, m_header, chunked_container::header_size);
+			store_uint64(aad + chunked_container::header_size, index);
+
+			// m_chunk may be empty: give open() a valid pointer anyway.
+			unsigned char empty;
+
+			if (!m_ctx.open(len ? &m_chunk[0] : &empty, len, &m_sealed_chunk[0], chunked_container::nonce_size, aad, sizeof(aad), &m_sealed_chunk[chunked_container::nonce_size], len + chunked_container::tag_size))
+			{
+				OPENSSL_cleanse(len ? &m_chunk[0] : &empty, len);
+
+				throw std::runtime_error("authentication failure");
+			}
+
+			m_chunk_index = index;
+			m_chunk_valid = true;
+
+			return m_chunk;
+		}
+	}
+}
+
+#endif
@@ -44,6 +44,8 @@
 
 #include "cipher/cipher_algorithm.hpp"
 
+#include "algorithm_registry.hpp"
+
 #include <stdexcept>
 #include <cassert>
 
@@ -54,21 +56,47 @@ namespace cryptoplus
 		const size_t cipher_algorithm::max_key_length = EVP_MAX_KEY_LENGTH;
 		const size_t cipher_algorithm::max_iv_length = EVP_MAX_IV_LENGTH;
 
-		cipher_algorithm::cipher_algorithm(int _type) :
-			m_cipher(EVP_get_cipherbynid(_type))
+		cipher_algorithm::cipher_algorithm(int _type)
 		{
-			if (!m_cipher)
+			const detail::cipher_entry* const entry = detail::find_cipher(_type);
+
+			if (entry)
 			{
-				throw std::invalid_argument("type");
+				m_cipher = entry->cipher;
+				m_block_size = entry->block_size;
+				m_key_length = entry->key_length;
+				m_iv_length = entry->iv_length;
+			}
+			else
+			{
+				set_cipher(EVP_get_cipherbynid(_type));
+
+				if (!m_cipher)
+				{
+					throw std::invalid_argument("type");
+				}
 			}
 		}
 
-		cipher_algorithm::cipher_algorithm(const std::string& _name) :
-			m_cipher(EVP_get_cipherbyname(_name.c_str()))
+		cipher_algorithm::cipher_algorithm(const std::string& _name)
 		{
-			if (!m_cipher)
+			const detail::cipher_entry* const entry = detail::find_cipher(_name);
+
+			if (entry)
+			{
+				m_cipher = entry->cipher;
+				m_block_size = entry->block_size;
+				m_key_length = entry->key_length;
+				m_iv_length = entry->iv_length;
+			}
+			else
 			{
-				throw std::invalid_argument("name");
+				set_cipher(EVP_get_cipherbyname(_name.c_str()));
+
+				if (!m_cipher)
+				{
+					throw std::invalid_argument("name");
+				}
 			}
 		}
 	}
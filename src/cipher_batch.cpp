@@ -0,0 +1,200 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file cipher_batch.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A batch cipher class.
+ */
+
+#include "cipher/cipher_batch.hpp"
+
+#include "cipher_mode.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			// The count of keystream blocks computed per ECB call.
+			const size_t keystream_blocks = 256;
+		}
+
+		void cipher_batch::initialize(const cipher_algorithm& _algorithm, cipher_context::cipher_direction direction, const void* key, size_t key_len, ENGINE* impl)
+		{
+			m_ctx.initialize(_algorithm, direction, key, key_len, NULL, _algorithm.iv_length(), impl);
+
+			const EVP_CIPHER* ecb = NULL;
+
+#ifdef EVP_CIPH_CTR_MODE
+			if (_algorithm.mode() == EVP_CIPH_CTR_MODE)
+			{
+				ecb = detail::get_mode_counterpart(_algorithm, "ctr", "ecb");
+			}
+#endif
+
+			m_use_keystream = (ecb != NULL) && (_algorithm.iv_length() > 0);
+
+			if (m_use_keystream)
+			{
+				const cipher_algorithm ecb_algorithm(ecb);
+
+				m_keystream_ctx.initialize(ecb_algorithm, cipher_context::encrypt, key, key_len, NULL, 0, impl);
+				m_keystream_ctx.set_padding(false);
+
+				m_counters.resize(keystream_blocks * _algorithm.iv_length());
+				m_keystream.resize(m_counters.size() + ecb_algorithm.block_size());
+			}
+		}
+
+		void cipher_batch::process(message* messages, size_t messages_count)
+		{
+			assert(messages || (messages_count == 0));
+
+			if (m_use_keystream)
+			{
+				process_ctr(messages, messages_count);
+
+				return;
+			}
+
+			for (message* msg = messages; msg != messages + messages_count; ++msg)
+			{
+				error::throw_error_if_not(EVP_CipherInit_ex(&m_ctx.raw(), NULL, NULL, NULL, static_cast<const unsigned char*>(msg->iv), -1) != 0);
+
+				unsigned char* out = static_cast<unsigned char*>(msg->out);
+
+				msg->result = m_ctx.update(out, msg->out_len, msg->in, msg->in_len);
+				msg->result += m_ctx.finalize(out + msg->result, msg->out_len - msg->result);
+			}
+		}
+
+		void cipher_batch::process_ctr(message* messages, size_t messages_count)
+		{
+			const size_t counter_len = m_ctx.algorithm().iv_length();
+
+			for (message* msg = messages; msg != messages + messages_count; ++msg)
+			{
+				if (msg->out_len < msg->in_len)
+				{
+					throw std::logic_error("The output buffer is too small");
+				}
+
+				msg->result = msg->in_len;
+			}
+
+			unsigned char counter[EVP_MAX_IV_LENGTH];
+
+			size_t fill_index = 0;
+			size_t fill_offset = 0;
+			size_t xor_index = 0;
+			size_t xor_offset = 0;
+
+			if (messages_count > 0)
+			{
+				std::memcpy(counter, messages[0].iv, counter_len);
+			}
+
+			while (fill_index < messages_count)
+			{
+				// Lay out the counter blocks of as many messages as possible...
+				size_t used = 0;
+
+				while ((used < m_counters.size()) && (fill_index < messages_count))
+				{
+					if (fill_offset >= messages[fill_index].in_len)
+					{
+						fill_offset = 0;
+
+						if (++fill_index < messages_count)
+						{
+							std::memcpy(counter, messages[fill_index].iv, counter_len);
+						}
+
+						continue;
+					}
+
+					std::memcpy(&m_counters[used], counter, counter_len);
+					detail::increment_counter(counter, counter_len);
+					used += counter_len;
+					fill_offset += counter_len;
+				}
+
+				if (used == 0)
+				{
+					break;
+				}
+
+				// ...compute their keystream in a single call...
+				m_keystream_ctx.update(&m_keystream[0], m_keystream.size(), &m_counters[0], used);
+
+				// ...then spread it back over the messages.
+				for (size_t ks = 0; ks < used;)
+				{
+					while (xor_offset >= messages[xor_index].in_len)
+					{
+						++xor_index;
+						xor_offset = 0;
+					}
+
+					const message& msg = messages[xor_index];
+					const size_t remaining_blocks = (msg.in_len - xor_offset + counter_len - 1) / counter_len;
+					const size_t ks_len = (std::min)(remaining_blocks * counter_len, used - ks);
+					const size_t data_len = (std::min)(ks_len, msg.in_len - xor_offset);
+
+					const unsigned char* in = static_cast<const unsigned char*>(msg.in) + xor_offset;
+					unsigned char* out = static_cast<unsigned char*>(msg.out) + xor_offset;
+					const unsigned char* keystream = &m_keystream[ks];
+
+					for (size_t i = 0; i < data_len; ++i)
+					{
+						out[i] = in[i] ^ keystream[i];
+					}
+
+					ks += ks_len;
+					xor_offset += ks_len;
+				}
+			}
+		}
+	}
+}
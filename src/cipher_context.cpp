@@ -47,7 +47,14 @@
 #include "pkey/pkey.hpp"
 #include "random/random.hpp"
 
+#include "parallel.hpp"
+#include "envelope_key.hpp"
+
+#include <openssl/crypto.h>
+
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 namespace cryptoplus
 {
@@ -81,6 +88,46 @@ namespace cryptoplus
 				return iout_len;
 			}
 
+			class seal_key_task
+			{
+				public:
+
+					seal_key_task(const unsigned char* key, size_t key_len, const pkey::pkey* pkeys, const size_t* offsets, unsigned char* ek, size_t* ekl) :
+						m_key(key),
+						m_key_len(key_len),
+						m_pkeys(pkeys),
+						m_offsets(offsets),
+						m_ek(ek),
+						m_ekl(ekl)
+					{
+					}
+
+					void operator()(size_t index)
+					{
+						const size_t offset = m_offsets[index];
+
+						// This is what EVP_SealInit() does for every public key.
+#if OPENSSL_VERSION_NUMBER >= 0x10000000
+						const int len = EVP_PKEY_encrypt_old(m_ek + offset, m_key, static_cast<int>(m_key_len), const_cast<EVP_PKEY*>(m_pkeys[index].raw()));
+#else
+						const int len = EVP_PKEY_encrypt(m_ek + offset, const_cast<unsigned char*>(m_key), static_cast<int>(m_key_len), const_cast<EVP_PKEY*>(m_pkeys[index].raw()));
+#endif
+
+						error::throw_error_if_not(len > 0);
+
+						m_ekl[index] = static_cast<size_t>(len);
+					}
+
+				private:
+
+					const unsigned char* m_key;
+					size_t m_key_len;
+					const pkey::pkey* m_pkeys;
+					const size_t* m_offsets;
+					unsigned char* m_ek;
+					size_t* m_ekl;
+			};
+
 			size_t generic_finalize(cipher_context& ctx, finalize_function finalize_func, void* out, size_t out_len)
 			{
 				assert(out);
@@ -116,6 +163,65 @@ namespace cryptoplus
 			return seal_initialize(_algorithm, iv, iv_len, &pkey, &pkey + sizeof(&pkey))[0];
 		}
 
+		void cipher_context::seal_initialize(const cipher_algorithm& _algorithm, void* iv, size_t iv_len, const pkey::pkey* pkeys, size_t pkeys_count, void* ek, size_t ek_len, size_t* ekl, unsigned int thread_count)
+		{
+			assert(pkeys || (pkeys_count == 0));
+			assert(ek || (ek_len == 0));
+			assert(ekl || (pkeys_count == 0));
+
+			if (iv && (iv_len != _algorithm.iv_length()))
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			std::vector<size_t> offsets(pkeys_count + 1);
+			detail::get_seal_arena_offsets(pkeys, pkeys_count, &offsets[0]);
+
+			if (ek_len < offsets[pkeys_count])
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			error::throw_error_if_not(EVP_EncryptInit_ex(&m_ctx, _algorithm.raw(), NULL, NULL, NULL) != 0);
+
+			unsigned char key[EVP_MAX_KEY_LENGTH];
+			const size_t key_len = EVP_CIPHER_CTX_key_length(&m_ctx);
+
+			try
+			{
+				error::throw_error_if_not(EVP_CIPHER_CTX_rand_key(&m_ctx, key) > 0);
+
+				if (iv && (iv_len > 0))
+				{
+					random::get_random_bytes(iv, iv_len);
+				}
+
+				detail::wrap_key(key, key_len, pkeys, pkeys_count, &offsets[0], static_cast<unsigned char*>(ek), ekl, thread_count);
+
+				error::throw_error_if_not(EVP_EncryptInit_ex(&m_ctx, NULL, NULL, key, static_cast<const unsigned char*>(iv)) != 0);
+			}
+			catch (...)
+			{
+				OPENSSL_cleanse(key, sizeof(key));
+
+				throw;
+			}
+
+			OPENSSL_cleanse(key, sizeof(key));
+		}
+
+		size_t cipher_context::seal_arena_size(const pkey::pkey* pkeys, size_t pkeys_count)
+		{
+			size_t result = 0;
+
+			for (size_t i = 0; i < pkeys_count; ++i)
+			{
+				result += pkeys[i].size();
+			}
+
+			return result;
+		}
+
 		void cipher_context::open_initialize(const cipher_algorithm& _algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, pkey::pkey pkey)
 		{
 			assert(key);
@@ -133,6 +239,23 @@ namespace cryptoplus
 			error::throw_error_if_not(EVP_OpenInit(&m_ctx, _algorithm.raw(), static_cast<const unsigned char*>(key), static_cast<int>(key_len), static_cast<const unsigned char*>(iv), pkey.raw()) != 0);
 		}
 
+		void cipher_context::copy(const cipher_context& other)
+		{
+			error::throw_error_if_not(EVP_CIPHER_CTX_copy(&m_ctx, &other.m_ctx) != 0);
+		}
+
+		void cipher_context::set_iv(const void* iv, size_t iv_len)
+		{
+			assert(iv);
+
+			if (iv_len != algorithm().iv_length())
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			error::throw_error_if_not(EVP_CipherInit_ex(&m_ctx, NULL, NULL, NULL, static_cast<const unsigned char*>(iv), static_cast<int>(unchanged)) != 0);
+		}
+
 		size_t cipher_context::add_iso_10126_padding(void* buf, size_t buf_len, size_t max_buf_len) const
 		{
 			assert(buf);
@@ -149,12 +272,65 @@ namespace cryptoplus
 
 			unsigned char* padding = reinterpret_cast<unsigned char*>(buf) + buf_len;
 
-			random::get_random_bytes(padding, padding_len - 1);
+			random::get_buffered_random_bytes(padding, padding_len - 1);
 			padding[padding_len - 1] = static_cast<unsigned char>(padding_len);
 
 			return result_len;
 		}
 
+		void cipher_context::add_iso_10126_padding(void* const* bufs, const size_t* buf_lens, const size_t* max_buf_lens, size_t* results, size_t count) const
+		{
+			assert(bufs);
+			assert(buf_lens);
+			assert(max_buf_lens);
+			assert(results);
+
+			size_t random_len = 0;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				assert(bufs[i]);
+				assert(buf_lens[i] <= max_buf_lens[i]);
+
+				results[i] = get_iso_10126_padding_size(buf_lens[i]);
+
+				if (results[i] > max_buf_lens[i])
+				{
+					throw std::logic_error("The resulting buffer is too small");
+				}
+
+				random_len += results[i] - buf_lens[i] - 1;
+			}
+
+			unsigned char random_bytes[random::random_buffer_size];
+			size_t random_offset = 0;
+			size_t random_available = 0;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const size_t padding_len = results[i] - buf_lens[i];
+
+				if (random_available < padding_len - 1)
+				{
+					// A padding is never split across two draws.
+					random_available = std::min(random_len, sizeof(random_bytes));
+					random_offset = 0;
+					random::get_buffered_random_bytes(random_bytes, random_available);
+				}
+
+				unsigned char* padding = static_cast<unsigned char*>(bufs[i]) + buf_lens[i];
+
+				std::memcpy(padding, random_bytes + random_offset, padding_len - 1);
+				padding[padding_len - 1] = static_cast<unsigned char>(padding_len);
+
+				random_offset += padding_len - 1;
+				random_available -= padding_len - 1;
+				random_len -= padding_len - 1;
+			}
+
+			OPENSSL_cleanse(random_bytes, sizeof(random_bytes));
+		}
+
 		size_t cipher_context::verify_iso_10126_padding(const void* buf, size_t buf_len) const
 		{
 			assert(buf);
@@ -206,5 +382,38 @@ namespace cryptoplus
 			return generic_finalize(*this, EVP_OpenFinal, out, out_len);
 		}
 	}
-}
 
+	namespace detail
+	{
+		void get_seal_arena_offsets(const pkey::pkey* pkeys, size_t pkeys_count, size_t* offsets)
+		{
+			offsets[0] = 0;
+
+			for (size_t i = 0; i < pkeys_count; ++i)
+			{
+				offsets[i + 1] = offsets[i] + pkeys[i].size();
+			}
+		}
+
+		void wrap_key(const unsigned char* key, size_t key_len, const pkey::pkey* pkeys, size_t pkeys_count, const size_t* offsets, unsigned char* ek, size_t* ekl, unsigned int thread_count)
+		{
+			cipher::seal_key_task task(key, key_len, pkeys, offsets, ek, ekl);
+
+			parallel_for(pkeys_count, thread_count, task);
+		}
+
+		size_t unwrap_key(unsigned char* key, const unsigned char* ek, size_t ek_len, const pkey::pkey& pkey)
+		{
+			// This is what EVP_OpenInit() does.
+#if OPENSSL_VERSION_NUMBER >= 0x10000000
+			const int len = EVP_PKEY_decrypt_old(key, ek, static_cast<int>(ek_len), const_cast<EVP_PKEY*>(pkey.raw()));
+#else
+			const int len = EVP_PKEY_decrypt(key, const_cast<unsigned char*>(ek), static_cast<int>(ek_len), const_cast<EVP_PKEY*>(pkey.raw()));
+#endif
+
+			error::throw_error_if_not(len > 0);
+
+			return static_cast<size_t>(len);
+		}
+	}
+}
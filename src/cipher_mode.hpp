@@ -0,0 +1,131 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file cipher_mode.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Internal cipher mode helpers.
+ *
+ * This header is private to the library and is not installed.
+ */
+
+#ifndef CRYPTOPLUS_CIPHER_MODE_HPP
+#define CRYPTOPLUS_CIPHER_MODE_HPP
+
+#include "cipher/cipher_algorithm.hpp"
+
+#include <openssl/objects.h>
+
+#include <boost/cstdint.hpp>
+
+#include <string>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace detail
+	{
+		/**
+		 * \brief Get the same block cipher, with the same key length, in another mode.
+		 * \param algorithm The cipher algorithm, in mode from_mode.
+		 * \param from_mode The mode suffix of algorithm's name, in lowercase, such as "ctr" or "gcm".
+		 * \param to_mode The mode suffix of the wanted cipher algorithm, in lowercase, such as "ecb".
+		 * \return The matching cipher, or NULL if there is none.
+		 *
+		 * The long names are used, as the short names are not consistent across modes (the short name of "aes-128-gcm" is "id-aes128-GCM"): the counterpart of "aes-128-ctr" in "ecb" mode is "aes-128-ecb".
+		 */
+		inline const EVP_CIPHER* get_mode_counterpart(const cipher::cipher_algorithm& algorithm, const std::string& from_mode, const std::string& to_mode)
+		{
+			const char* const long_name = OBJ_nid2ln(algorithm.type());
+
+			if (!long_name)
+			{
+				return NULL;
+			}
+
+			std::string name = long_name;
+
+			if ((name.size() <= from_mode.size()) || (name.compare(name.size() - from_mode.size(), from_mode.size(), from_mode) != 0))
+			{
+				return NULL;
+			}
+
+			name.replace(name.size() - from_mode.size(), from_mode.size(), to_mode);
+
+			return EVP_get_cipherbyname(name.c_str());
+		}
+
+		/**
+		 * \brief Increment a big-endian counter block, the way OpenSSL's CTR mode does.
+		 * \param counter The counter block.
+		 * \param counter_len The length of counter.
+		 */
+		inline void increment_counter(unsigned char* counter, size_t counter_len)
+		{
+			for (size_t i = counter_len; i > 0; --i)
+			{
+				if (++counter[i - 1] != 0)
+				{
+					break;
+				}
+			}
+		}
+
+		/**
+		 * \brief Add a value to a big-endian counter block.
+		 * \param counter The counter block.
+		 * \param counter_len The length of counter.
+		 * \param value The value to add.
+		 */
+		inline void add_to_counter(unsigned char* counter, size_t counter_len, boost::uint64_t value)
+		{
+			unsigned int carry = 0;
+
+			for (size_t i = counter_len; (i > 0) && ((value != 0) || (carry != 0)); --i)
+			{
+				const unsigned int sum = counter[i - 1] + static_cast<unsigned int>(value & 0xff) + carry;
+
+				counter[i - 1] = static_cast<unsigned char>(sum);
+				carry = sum >> 8;
+				value >>= 8;
+			}
+		}
+	}
+}
+
+#endif /* CRYPTOPLUS_CIPHER_MODE_HPP */
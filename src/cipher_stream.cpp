@@ -44,41 +44,244 @@
 
 #include "cipher/cipher_stream.hpp"
 
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <stdexcept>
 #include <cassert>
+#include <cerrno>
 
 namespace cryptoplus
 {
 	namespace cipher
 	{
+		namespace
+		{
+			void write_to_bio(bio::bio_ptr bio, const void* buf, size_t buf_len)
+			{
+				error::throw_error_if_not(bio.write(buf, buf_len) == static_cast<ptrdiff_t>(buf_len));
+			}
+
+			void write_to_file(file f, const void* buf, size_t buf_len)
+			{
+				if (fwrite(buf, 1, buf_len, f.raw()) != buf_len)
+				{
+					throw std::runtime_error(std::strerror(errno));
+				}
+			}
+		}
+
+		const size_t cipher_stream::min_segment_size;
+		const size_t cipher_stream::default_scratch_size;
+
+		void cipher_stream::set_sink(const sink_type& sink, size_t scratch_size)
+		{
+			m_sink = sink;
+
+			if (m_sink)
+			{
+				assert(scratch_size > 0);
+
+				// Leave room for the extra block update() may write.
+				m_scratch.resize(scratch_size + EVP_MAX_BLOCK_LENGTH);
+				m_segments.clear();
+				m_current = 0;
+				m_max_capacity = 0;
+			}
+			else
+			{
+				std::vector<unsigned char>().swap(m_scratch);
+			}
+
+			m_result_valid = false;
+		}
+
+		void cipher_stream::set_sink(bio::bio_ptr bio, size_t scratch_size)
+		{
+			set_sink(boost::bind(&write_to_bio, bio, _1, _2), scratch_size);
+		}
+
+		void cipher_stream::set_sink(file f, size_t scratch_size)
+		{
+			set_sink(boost::bind(&write_to_file, f, _1, _2), scratch_size);
+		}
+
 		cipher_stream& cipher_stream::append(const void* buf, size_t buf_len)
 		{
-			size_t out_len = m_buffer.size() - m_offset;
+			if (m_finalized)
+			{
+				reset();
+			}
+
+			m_result_valid = false;
 
-			if (out_len < algorithm().block_size() + buf_len)
+			if (m_sink)
 			{
-				m_buffer.resize(m_buffer.size() + algorithm().block_size() + buf_len - out_len);
-				out_len = algorithm().block_size() + buf_len;
+				sink_append(static_cast<const unsigned char*>(buf), buf_len);
+
+				return *this;
 			}
 
-			m_offset += update(&m_buffer[0] + m_offset, out_len, buf, buf_len);
+			const size_t block_size = algorithm().block_size();
+			const unsigned char* in = static_cast<const unsigned char*>(buf);
+
+			while (buf_len > 0)
+			{
+				segment& seg = output_segment(block_size + 1, growth_capacity());
+
+				// update() may write up to block_size bytes more than it is given.
+				const size_t len = std::min(buf_len, seg.capacity - seg.size - block_size);
+
+				seg.size += update(seg.data.get() + seg.size, seg.capacity - seg.size, in, len);
+
+				in += len;
+				buf_len -= len;
+			}
 
 			return *this;
 		}
 
 		void cipher_stream::finalize()
 		{
-			size_t out_len = m_buffer.size() - m_offset;
+			if (m_finalized)
+			{
+				reset();
+			}
+
+			m_result_valid = false;
+
+			if (m_sink)
+			{
+				const size_t len = finalize(&m_scratch[0], m_scratch.size());
+
+				if (len > 0)
+				{
+					m_sink(&m_scratch[0], len);
+				}
+			}
+			else
+			{
+				segment& seg = output_segment(algorithm().block_size(), growth_capacity());
+
+				seg.size += finalize(seg.data.get() + seg.size, seg.capacity - seg.size);
+			}
+
+			m_finalized = true;
+		}
+
+		std::vector<cipher_stream::const_buffer> cipher_stream::buffers() const
+		{
+			std::vector<const_buffer> result;
+
+			for (std::vector<segment>::const_iterator seg = m_segments.begin(); seg != m_segments.end(); ++seg)
+			{
+				if (seg->size > 0)
+				{
+					const const_buffer buffer = { seg->data.get(), seg->size };
+
+					result.push_back(buffer);
+				}
+			}
+
+			return result;
+		}
+
+		size_t cipher_stream::size() const
+		{
+			size_t result = 0;
+
+			for (std::vector<segment>::const_iterator seg = m_segments.begin(); seg != m_segments.end(); ++seg)
+			{
+				result += seg->size;
+			}
+
+			return result;
+		}
 
-			if (out_len < algorithm().block_size())
+		const std::vector<unsigned char>& cipher_stream::result() const
+		{
+			if (!m_result_valid)
 			{
-				m_buffer.resize(m_buffer.size() + algorithm().block_size() - out_len);
-				out_len = algorithm().block_size();
+				m_result.clear();
+				m_result.reserve(size());
+
+				for (std::vector<segment>::const_iterator seg = m_segments.begin(); seg != m_segments.end(); ++seg)
+				{
+					m_result.insert(m_result.end(), seg->data.get(), seg->data.get() + seg->size);
+				}
+
+				m_result_valid = true;
 			}
 
-			m_buffer.resize(m_offset + finalize(&m_buffer[0] + m_offset, out_len));
+			return m_result;
+		}
+
+		void cipher_stream::reset()
+		{
+			// The segments are kept, to be reused by the next sequence.
+			for (std::vector<segment>::iterator seg = m_segments.begin(); seg != m_segments.end(); ++seg)
+			{
+				seg->size = 0;
+			}
 
-			m_offset = 0;
+			m_current = 0;
+			m_finalized = false;
+		}
+
+		cipher_stream::segment& cipher_stream::output_segment(size_t len, size_t capacity)
+		{
+			while (m_current < m_segments.size())
+			{
+				segment& seg = m_segments[m_current];
+
+				if (seg.capacity - seg.size >= len)
+				{
+					return seg;
+				}
+
+				if (seg.size == 0)
+				{
+					// An unused segment that is too small: drop it.
+					m_segments.erase(m_segments.begin() + m_current);
+				}
+				else
+				{
+					++m_current;
+				}
+			}
+
+			capacity = std::max(len, capacity);
+
+			const segment seg = { boost::shared_array<unsigned char>(new unsigned char[capacity]), capacity, 0 };
+
+			m_segments.push_back(seg);
+			m_max_capacity = std::max(m_max_capacity, capacity);
+
+			return m_segments.back();
+		}
+
+		size_t cipher_stream::growth_capacity() const
+		{
+			return std::max(min_segment_size, 2 * m_max_capacity);
+		}
+
+		void cipher_stream::sink_append(const unsigned char* buf, size_t buf_len)
+		{
+			const size_t scratch_size = m_scratch.size() - EVP_MAX_BLOCK_LENGTH;
+
+			while (buf_len > 0)
+			{
+				const size_t len = std::min(buf_len, scratch_size);
+				const size_t out_len = update(&m_scratch[0], m_scratch.size(), buf, len);
+
+				if (out_len > 0)
+				{
+					m_sink(&m_scratch[0], out_len);
+				}
+
+				buf += len;
+				buf_len -= len;
+			}
 		}
 	}
 }
-
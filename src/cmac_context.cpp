@@ -0,0 +1,106 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file cmac_context.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A CMAC context class.
+ */
+
+#include "hash/cmac_context.hpp"
+
+#include <stdexcept>
+#include <cassert>
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+namespace cryptoplus
+{
+	namespace hash
+	{
+		void cmac_context::initialize(const void* key, size_t key_len, const cipher::cipher_algorithm& algorithm, ENGINE* impl)
+		{
+			assert(key);
+
+			if (key_len != algorithm.key_length())
+			{
+				throw std::runtime_error("key_len");
+			}
+
+			error::throw_error_if_not(CMAC_Init(m_ctx, key, key_len, algorithm.raw(), impl) != 0);
+
+			m_result_size = algorithm.block_size();
+		}
+
+		size_t cmac_context::finalize(void* mac, size_t len)
+		{
+			assert(mac);
+
+			if (len < m_result_size)
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			size_t result = len;
+
+			error::throw_error_if_not(CMAC_Final(m_ctx, static_cast<unsigned char*>(mac), &result) != 0);
+
+			return result;
+		}
+
+		size_t cmac_context::compute(void* mac, size_t mac_len, const void* data, size_t data_len)
+		{
+			reset();
+			update(data, data_len);
+
+			return finalize(mac, mac_len);
+		}
+
+		void cmac_context::compute(message* messages, size_t messages_count)
+		{
+			assert(messages || (messages_count == 0));
+
+			for (message* msg = messages; msg != messages + messages_count; ++msg)
+			{
+				msg->result = compute(msg->mac, msg->mac_len, msg->data, msg->data_len);
+			}
+		}
+	}
+}
+
+#endif
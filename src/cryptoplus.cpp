@@ -44,6 +44,79 @@
 
 #include "cryptoplus.hpp"
 
+#include "algorithm_registry.hpp"
+
+#include <openssl/crypto.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
+#endif
+
 namespace cryptoplus
 {
+	void _algorithms_initialize()
+	{
+		_OpenSSL_add_all_algorithms();
+		detail::register_algorithms();
+	}
+
+	void _algorithms_cleanup()
+	{
+		detail::unregister_algorithms();
+		EVP_cleanup();
+	}
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000
+	namespace
+	{
+		std::vector<boost::mutex*> mutexes;
+
+		void locking_callback(int mode, int type, const char*, int)
+		{
+			if (mode & CRYPTO_LOCK)
+			{
+				mutexes[type]->lock();
+			}
+			else
+			{
+				mutexes[type]->unlock();
+			}
+		}
+	}
+
+	void _threading_initialize()
+	{
+		mutexes.resize(CRYPTO_num_locks());
+
+		for (std::vector<boost::mutex*>::iterator mutex = mutexes.begin(); mutex != mutexes.end(); ++mutex)
+		{
+			*mutex = new boost::mutex();
+		}
+
+		// OpenSSL identifies threads by the address of errno by default, which is fine on every supported platform.
+		CRYPTO_set_locking_callback(locking_callback);
+	}
+
+	void _threading_cleanup()
+	{
+		CRYPTO_set_locking_callback(NULL);
+
+		for (std::vector<boost::mutex*>::iterator mutex = mutexes.begin(); mutex != mutexes.end(); ++mutex)
+		{
+			delete *mutex;
+		}
+
+		mutexes.clear();
+	}
+#else
+	void _threading_initialize()
+	{
+	}
+
+	void _threading_cleanup()
+	{
+	}
+#endif
 }
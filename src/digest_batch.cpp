@@ -0,0 +1,410 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file digest_batch.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A batch message digest class.
+ */
+
+#include "hash/digest_batch.hpp"
+
+#include "capabilities.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CRYPTOPLUS_DIGEST_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#define CRYPTOPLUS_DIGEST_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+namespace cryptoplus
+{
+	namespace hash
+	{
+		namespace
+		{
+#ifdef CRYPTOPLUS_DIGEST_BATCH_SSE2
+			const size_t sha256_block_size = 64;
+			const size_t sha256_result_size = 32;
+
+			const boost::uint32_t sha256_initial_state[8] =
+			{
+				0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+			};
+
+			const boost::uint32_t sha256_k[64] =
+			{
+				0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+				0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+				0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+				0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+				0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+				0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+				0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+				0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+			};
+
+			inline boost::uint32_t load_uint32_be(const unsigned char* buf)
+			{
+				return (static_cast<boost::uint32_t>(buf[0]) << 24) | (static_cast<boost::uint32_t>(buf[1]) << 16) | (static_cast<boost::uint32_t>(buf[2]) << 8) | buf[3];
+			}
+
+			inline void store_uint32_be(unsigned char* buf, boost::uint32_t value)
+			{
+				buf[0] = static_cast<unsigned char>(value >> 24);
+				buf[1] = static_cast<unsigned char>(value >> 16);
+				buf[2] = static_cast<unsigned char>(value >> 8);
+				buf[3] = static_cast<unsigned char>(value);
+			}
+
+			// The SIMD operations, on 4 lanes of 32-bit words.
+			struct sse2_lanes
+			{
+				typedef __m128i vector;
+
+				static const size_t count = 4;
+
+				static vector load(const boost::uint32_t* words) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(words)); }
+				static void store(boost::uint32_t* words, vector x) { _mm_storeu_si128(reinterpret_cast<__m128i*>(words), x); }
+				static vector set(boost::uint32_t x) { return _mm_set1_epi32(static_cast<int>(x)); }
+				static vector add(vector x, vector y) { return _mm_add_epi32(x, y); }
+				static vector bitwise_and(vector x, vector y) { return _mm_and_si128(x, y); }
+				static vector bitwise_andnot(vector x, vector y) { return _mm_andnot_si128(x, y); }
+				static vector bitwise_or(vector x, vector y) { return _mm_or_si128(x, y); }
+				static vector bitwise_xor(vector x, vector y) { return _mm_xor_si128(x, y); }
+				static vector shr(vector x, int n) { return _mm_srli_epi32(x, n); }
+				static vector rotr(vector x, int n) { return _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - n)); }
+			};
+
+			const size_t sse2_lanes::count;
+
+#ifdef CRYPTOPLUS_DIGEST_BATCH_AVX2
+			// The SIMD operations, on 8 lanes of 32-bit words.
+			struct avx2_lanes
+			{
+				typedef __m256i vector;
+
+				static const size_t count = 8;
+
+				static vector load(const boost::uint32_t* words) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words)); }
+				static void store(boost::uint32_t* words, vector x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(words), x); }
+				static vector set(boost::uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x)); }
+				static vector add(vector x, vector y) { return _mm256_add_epi32(x, y); }
+				static vector bitwise_and(vector x, vector y) { return _mm256_and_si256(x, y); }
+				static vector bitwise_andnot(vector x, vector y) { return _mm256_andnot_si256(x, y); }
+				static vector bitwise_or(vector x, vector y) { return _mm256_or_si256(x, y); }
+				static vector bitwise_xor(vector x, vector y) { return _mm256_xor_si256(x, y); }
+				static vector shr(vector x, int n) { return _mm256_srli_epi32(x, n); }
+				static vector rotr(vector x, int n) { return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n)); }
+			};
+
+			const size_t avx2_lanes::count;
+#endif
+
+			// Compress one block per lane. state holds, for each state word, one value per lane.
+			template <typename Lanes>
+			void sha256_compress(boost::uint32_t state[8][Lanes::count], const unsigned char* const blocks[Lanes::count])
+			{
+				typedef typename Lanes::vector vector;
+
+				boost::uint32_t words[16][Lanes::count];
+
+				for (size_t t = 0; t < 16; ++t)
+				{
+					for (size_t lane = 0; lane < Lanes::count; ++lane)
+					{
+						words[t][lane] = load_uint32_be(blocks[lane] + 4 * t);
+					}
+				}
+
+				vector w[16];
+				vector a = Lanes::load(state[0]);
+				vector b = Lanes::load(state[1]);
+				vector c = Lanes::load(state[2]);
+				vector d = Lanes::load(state[3]);
+				vector e = Lanes::load(state[4]);
+				vector f = Lanes::load(state[5]);
+				vector g = Lanes::load(state[6]);
+				vector h = Lanes::load(state[7]);
+
+				for (size_t t = 0; t < 64; ++t)
+				{
+					if (t < 16)
+					{
+						w[t] = Lanes::load(words[t]);
+					}
+					else
+					{
+						const vector w15 = w[(t - 15) & 15];
+						const vector w2 = w[(t - 2) & 15];
+						const vector s0 = Lanes::bitwise_xor(Lanes::bitwise_xor(Lanes::rotr(w15, 7), Lanes::rotr(w15, 18)), Lanes::shr(w15, 3));
+						const vector s1 = Lanes::bitwise_xor(Lanes::bitwise_xor(Lanes::rotr(w2, 17), Lanes::rotr(w2, 19)), Lanes::shr(w2, 10));
+
+						w[t & 15] = Lanes::add(Lanes::add(w[t & 15], s0), Lanes::add(w[(t - 7) & 15], s1));
+					}
+
+					const vector sigma1 = Lanes::bitwise_xor(Lanes::bitwise_xor(Lanes::rotr(e, 6), Lanes::rotr(e, 11)), Lanes::rotr(e, 25));
+					const vector ch = Lanes::bitwise_xor(Lanes::bitwise_and(e, f), Lanes::bitwise_andnot(e, g));
+					const vector t1 = Lanes::add(Lanes::add(Lanes::add(h, sigma1), Lanes::add(ch, Lanes::set(sha256_k[t]))), w[t & 15]);
+					const vector sigma0 = Lanes::bitwise_xor(Lanes::bitwise_xor(Lanes::rotr(a, 2), Lanes::rotr(a, 13)), Lanes::rotr(a, 22));
+					const vector maj = Lanes::bitwise_or(Lanes::bitwise_and(a, b), Lanes::bitwise_and(c, Lanes::bitwise_or(a, b)));
+					const vector t2 = Lanes::add(sigma0, maj);
+
+					h = g;
+					g = f;
+					f = e;
+					e = Lanes::add(d, t1);
+					d = c;
+					c = b;
+					b = a;
+					a = Lanes::add(t1, t2);
+				}
+
+				Lanes::store(state[0], Lanes::add(Lanes::load(state[0]), a));
+				Lanes::store(state[1], Lanes::add(Lanes::load(state[1]), b));
+				Lanes::store(state[2], Lanes::add(Lanes::load(state[2]), c));
+				Lanes::store(state[3], Lanes::add(Lanes::load(state[3]), d));
+				Lanes::store(state[4], Lanes::add(Lanes::load(state[4]), e));
+				Lanes::store(state[5], Lanes::add(Lanes::load(state[5]), f));
+				Lanes::store(state[6], Lanes::add(Lanes::load(state[6]), g));
+				Lanes::store(state[7], Lanes::add(Lanes::load(state[7]), h));
+			}
+
+			// The progress of a message in a lane: its full blocks are read in place, the padded tail from a copy.
+			struct sha256_lane
+			{
+				digest_batch::message* msg;
+				const unsigned char* data;
+				size_t blocks;
+				unsigned char tail[2 * sha256_block_size];
+				size_t tail_blocks;
+				size_t tail_index;
+			};
+
+			template <typename Lanes>
+			void sha256_start(sha256_lane& lane, boost::uint32_t state[8][Lanes::count], size_t index, digest_batch::message* msg)
+			{
+				const size_t len = msg->data_len;
+				const size_t remaining = len % sha256_block_size;
+				const boost::uint64_t bit_len = static_cast<boost::uint64_t>(len) * 8;
+
+				lane.msg = msg;
+				lane.data = static_cast<const unsigned char*>(msg->data);
+				lane.blocks = len / sha256_block_size;
+				lane.tail_blocks = (remaining + 9 > sha256_block_size) ? 2 : 1;
+				lane.tail_index = 0;
+
+				const size_t tail_len = lane.tail_blocks * sha256_block_size;
+
+				if (remaining > 0)
+				{
+					std::memcpy(lane.tail, lane.data + lane.blocks * sha256_block_size, remaining);
+				}
+
+				lane.tail[remaining] = 0x80;
+				std::memset(lane.tail + remaining + 1, 0x00, tail_len - remaining - 1);
+				store_uint32_be(lane.tail + tail_len - 8, static_cast<boost::uint32_t>(bit_len >> 32));
+				store_uint32_be(lane.tail + tail_len - 4, static_cast<boost::uint32_t>(bit_len));
+
+				for (size_t i = 0; i < 8; ++i)
+				{
+					state[i][index] = sha256_initial_state[i];
+				}
+			}
+
+			template <typename Lanes>
+			void sha256_multi_buffer(digest_batch::message* messages, size_t messages_count)
+			{
+				const unsigned char idle_block[sha256_block_size] = {};
+
+				sha256_lane lanes[Lanes::count];
+				boost::uint32_t state[8][Lanes::count];
+				const unsigned char* blocks[Lanes::count];
+				size_t next = 0;
+				size_t active = 0;
+
+				std::memset(state, 0x00, sizeof(state));
+
+				for (size_t index = 0; index < Lanes::count; ++index)
+				{
+					if (next < messages_count)
+					{
+						sha256_start<Lanes>(lanes[index], state, index, &messages[next++]);
+						++active;
+					}
+					else
+					{
+						lanes[index].msg = NULL;
+					}
+				}
+
+				while (active > 0)
+				{
+					for (size_t index = 0; index < Lanes::count; ++index)
+					{
+						const sha256_lane& lane = lanes[index];
+
+						if (!lane.msg)
+						{
+							blocks[index] = idle_block;
+						}
+						else if (lane.blocks > 0)
+						{
+							blocks[index] = lane.data;
+						}
+						else
+						{
+							blocks[index] = lane.tail + lane.tail_index * sha256_block_size;
+						}
+					}
+
+					sha256_compress<Lanes>(state, blocks);
+
+					for (size_t index = 0; index < Lanes::count; ++index)
+					{
+						sha256_lane& lane = lanes[index];
+
+						if (!lane.msg)
+						{
+							continue;
+						}
+
+						if (lane.blocks > 0)
+						{
+							lane.data += sha256_block_size;
+							--lane.blocks;
+						}
+						else if (++lane.tail_index == lane.tail_blocks)
+						{
+							unsigned char* const md = static_cast<unsigned char*>(lane.msg->md);
+
+							for (size_t i = 0; i < 8; ++i)
+							{
+								store_uint32_be(md + 4 * i, state[i][index]);
+							}
+
+							lane.msg->result = sha256_result_size;
+
+							if (next < messages_count)
+							{
+								sha256_start<Lanes>(lane, state, index, &messages[next++]);
+							}
+							else
+							{
+								lane.msg = NULL;
+								--active;
+							}
+						}
+					}
+				}
+
+				std::memset(lanes, 0x00, sizeof(lanes));
+			}
+#endif
+		}
+
+		digest_batch::digest_batch(const message_digest_algorithm& _algorithm, ENGINE* impl) :
+			m_algorithm(_algorithm),
+			m_impl(impl),
+			m_kernel(NULL),
+			m_lanes(1)
+		{
+#ifdef CRYPTOPLUS_DIGEST_BATCH_SSE2
+			// With SHA-NI, OpenSSL hashes a single buffer faster than the multi-buffer kernels.
+			if (!m_impl && (m_algorithm.type() == NID_sha256) && !has_cpu_feature(cpu_sha))
+			{
+#ifdef CRYPTOPLUS_DIGEST_BATCH_AVX2
+				if (has_cpu_feature(cpu_avx2))
+				{
+					m_kernel = &sha256_multi_buffer<avx2_lanes>;
+					m_lanes = avx2_lanes::count;
+				}
+				else
+#endif
+				{
+					m_kernel = &sha256_multi_buffer<sse2_lanes>;
+					m_lanes = sse2_lanes::count;
+				}
+			}
+#endif
+		}
+
+		void digest_batch::compute(message* messages, size_t messages_count)
+		{
+			assert(messages || (messages_count == 0));
+
+			const size_t result_size = m_algorithm.result_size();
+
+			for (const message* msg = messages; msg != messages + messages_count; ++msg)
+			{
+				assert(msg->md);
+				assert(msg->data || (msg->data_len == 0));
+
+				if (msg->md_len < result_size)
+				{
+					throw std::logic_error("The output buffer is too small");
+				}
+			}
+
+			// A single message would leave all the lanes but one idle.
+			if (m_kernel && (messages_count > 1))
+			{
+				m_kernel(messages, messages_count);
+
+				return;
+			}
+
+			for (message* msg = messages; msg != messages + messages_count; ++msg)
+			{
+				m_ctx.initialize(m_algorithm, m_impl);
+				m_ctx.update(msg->data, msg->data_len);
+				msg->result = m_ctx.finalize(msg->md, msg->md_len);
+			}
+		}
+	}
+}
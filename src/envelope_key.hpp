@@ -0,0 +1,94 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file envelope_key.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Internal envelope key helpers.
+ *
+ * This header is private to the library and is not installed.
+ */
+
+#ifndef CRYPTOPLUS_ENVELOPE_KEY_HPP
+#define CRYPTOPLUS_ENVELOPE_KEY_HPP
+
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace pkey
+	{
+		class pkey;
+	}
+
+	namespace detail
+	{
+		/**
+		 * \brief Compute the offsets of the encrypted keys in a seal arena.
+		 * \param pkeys The public keys.
+		 * \param pkeys_count The count of public keys.
+		 * \param offsets An array of pkeys_count + 1 values that receives the offsets: offsets[i] is cipher_context::seal_arena_size(pkeys, i), and offsets[pkeys_count] is the arena size.
+		 */
+		void get_seal_arena_offsets(const pkey::pkey* pkeys, size_t pkeys_count, size_t* offsets);
+
+		/**
+		 * \brief Encrypt a shared secret key for several public keys concurrently, as EVP_SealInit() does.
+		 * \param key The shared secret key.
+		 * \param key_len The length of key.
+		 * \param pkeys The public keys.
+		 * \param pkeys_count The count of public keys.
+		 * \param offsets The offsets of the encrypted keys in ek, as computed by get_seal_arena_offsets().
+		 * \param ek The buffer that receives the encrypted keys. The key for pkeys[i] is written at the offset offsets[i].
+		 * \param ekl An array of pkeys_count values that receives the length of each encrypted key.
+		 * \param thread_count The maximum count of threads to use.
+		 */
+		void wrap_key(const unsigned char* key, size_t key_len, const pkey::pkey* pkeys, size_t pkeys_count, const size_t* offsets, unsigned char* ek, size_t* ekl, unsigned int thread_count);
+
+		/**
+		 * \brief Decrypt a shared secret key, as EVP_OpenInit() does.
+		 * \param key The buffer that receives the shared secret key. Must be at least pkey.size() bytes long.
+		 * \param ek The encrypted key.
+		 * \param ek_len The length of ek.
+		 * \param pkey The private key.
+		 * \return The length of the shared secret key.
+		 */
+		size_t unwrap_key(unsigned char* key, const unsigned char* ek, size_t ek_len, const pkey::pkey& pkey);
+	}
+}
+
+#endif /* CRYPTOPLUS_ENVELOPE_KEY_HPP */
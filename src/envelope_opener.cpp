@@ -0,0 +1,119 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file envelope_opener.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An envelope opener class.
+ */
+
+#include "cipher/envelope_opener.hpp"
+
+#include "cipher/cipher_context.hpp"
+#include "envelope_key.hpp"
+
+#include <openssl/crypto.h>
+
+#include <cassert>
+#include <cstring>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		void envelope_opener::add_key(const key_id_type& key_id, const void* wrapped_key, size_t wrapped_key_len, const pkey::pkey& pkey)
+		{
+			assert(wrapped_key);
+
+			std::vector<unsigned char> key(pkey.size());
+
+			try
+			{
+				const size_t key_len = detail::unwrap_key(&key[0], static_cast<const unsigned char*>(wrapped_key), wrapped_key_len, pkey);
+
+				m_ciphers[key_id].reset(new keyed_cipher(m_algorithm, cipher_context::decrypt, &key[0], key_len));
+			}
+			catch (...)
+			{
+				OPENSSL_cleanse(&key[0], key.size());
+
+				throw;
+			}
+
+			OPENSSL_cleanse(&key[0], key.size());
+		}
+
+		size_t envelope_opener::open(void* out, size_t out_len, const void* in, size_t in_len) const
+		{
+			assert(out);
+			assert(in);
+
+			const size_t header_size = envelope_session::key_id_length + m_algorithm.iv_length();
+
+			if (in_len < header_size)
+			{
+				throw std::runtime_error("in_len");
+			}
+
+			if (out_len < in_len - header_size + m_algorithm.block_size())
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			const unsigned char* const buf = static_cast<const unsigned char*>(in);
+
+			key_id_type key_id;
+			std::memcpy(key_id.data(), buf, key_id.size());
+
+			const cipher_map::const_iterator it = m_ciphers.find(key_id);
+
+			if (it == m_ciphers.end())
+			{
+				throw std::runtime_error("key_id");
+			}
+
+			cipher_context ctx;
+			it->second->create_context(ctx, buf + envelope_session::key_id_length, m_algorithm.iv_length());
+
+			size_t cnt = ctx.update(out, out_len, buf + header_size, in_len - header_size);
+			cnt += ctx.finalize(static_cast<unsigned char*>(out) + cnt, out_len - cnt);
+
+			return cnt;
+		}
+	}
+}
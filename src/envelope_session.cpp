@@ -0,0 +1,193 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file envelope_session.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An envelope encryption session class.
+ */
+
+#include "cipher/envelope_session.hpp"
+
+#include "cipher/cipher_context.hpp"
+#include "random/random.hpp"
+#include "envelope_key.hpp"
+
+#include <openssl/crypto.h>
+
+#include <cassert>
+#include <cstring>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		const size_t envelope_session::key_id_length;
+		const boost::uint64_t envelope_session::default_max_messages;
+		const unsigned int envelope_session::default_max_age;
+
+		envelope_session::envelope_session(const cipher_algorithm& _algorithm, const pkey::pkey* pkeys, size_t pkeys_count, boost::uint64_t max_messages, unsigned int max_age, unsigned int thread_count, rotation_handler_type handler) :
+			m_algorithm(_algorithm),
+			m_pkeys(pkeys, pkeys + pkeys_count),
+			m_max_messages(max_messages),
+			m_max_age(max_age),
+			m_thread_count(thread_count),
+			m_rotation_handler(handler),
+			m_wrapped_key_offsets(pkeys_count + 1),
+			m_wrapped_key_lengths(pkeys_count),
+			m_messages_count(0),
+			m_creation_time(0)
+		{
+			assert(pkeys);
+
+			if (pkeys_count == 0)
+			{
+				throw std::runtime_error("pkeys_count");
+			}
+
+			detail::get_seal_arena_offsets(pkeys, pkeys_count, &m_wrapped_key_offsets[0]);
+			m_wrapped_keys.resize(m_wrapped_key_offsets[pkeys_count]);
+
+			rotate();
+		}
+
+		void envelope_session::rotate()
+		{
+			unsigned char key[EVP_MAX_KEY_LENGTH];
+
+			const size_t key_len = m_algorithm.key_length();
+
+			// The new data key is wrapped aside: the session keeps its current data key if anything throws.
+			std::vector<unsigned char> wrapped_keys(m_wrapped_keys.size());
+			std::vector<size_t> wrapped_key_lengths(m_wrapped_key_lengths.size());
+			boost::scoped_ptr<keyed_cipher> cipher;
+			key_id_type key_id;
+
+			try
+			{
+				random::get_random_bytes(key, key_len);
+
+				detail::wrap_key(key, key_len, &m_pkeys[0], m_pkeys.size(), &m_wrapped_key_offsets[0], &wrapped_keys[0], &wrapped_key_lengths[0], m_thread_count);
+
+				cipher.reset(new keyed_cipher(m_algorithm, cipher_context::encrypt, key, key_len));
+			}
+			catch (...)
+			{
+				OPENSSL_cleanse(key, sizeof(key));
+
+				throw;
+			}
+
+			OPENSSL_cleanse(key, sizeof(key));
+
+			random::get_random_bytes(key_id.data(), key_id.size());
+
+			m_wrapped_keys.swap(wrapped_keys);
+			m_wrapped_key_lengths.swap(wrapped_key_lengths);
+			m_cipher.swap(cipher);
+			m_key_id = key_id;
+			m_messages_count = 0;
+			m_creation_time = std::time(NULL);
+
+			if (m_rotation_handler)
+			{
+				m_rotation_handler(*this);
+			}
+		}
+
+		bool envelope_session::needs_rotation() const
+		{
+			if ((m_max_messages > 0) && (m_messages_count >= m_max_messages))
+			{
+				return true;
+			}
+
+			if (m_max_age > 0)
+			{
+				const std::time_t now = std::time(NULL);
+
+				// A clock going backwards also expires the key.
+				if ((now < m_creation_time) || (static_cast<unsigned long>(now - m_creation_time) >= m_max_age))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		size_t envelope_session::seal(void* out, size_t out_len, const void* in, size_t in_len)
+		{
+			assert(out);
+			assert(in || (in_len == 0));
+
+			if (out_len < max_sealed_size(in_len))
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			if (needs_rotation())
+			{
+				rotate();
+			}
+
+			unsigned char* const buf = static_cast<unsigned char*>(out);
+			const size_t iv_len = m_algorithm.iv_length();
+
+			std::memcpy(buf, m_key_id.data(), m_key_id.size());
+			random::get_buffered_random_bytes(buf + key_id_length, iv_len);
+
+			size_t cnt = header_size();
+
+			cipher_context ctx;
+			m_cipher->create_context(ctx, buf + key_id_length, iv_len);
+
+			// cipher_context::update() does not accept a NULL input, even when empty.
+			if (in_len > 0)
+			{
+				cnt += ctx.update(buf + cnt, out_len - cnt, in, in_len);
+			}
+
+			cnt += ctx.finalize(buf + cnt, out_len - cnt);
+
+			++m_messages_count;
+
+			return cnt;
+		}
+	}
+}
@@ -0,0 +1,226 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file etm_context.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An encrypt-then-MAC context class.
+ */
+
+#include "cipher/etm_context.hpp"
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		const size_t etm_context::tile_size;
+
+		void etm_context::initialize(const cipher_algorithm& _algorithm, cipher_context::cipher_direction direction, const void* key, size_t key_len, const hash::message_digest_algorithm& mac_algorithm, const void* mac_key, size_t mac_key_len, size_t tag_len, ENGINE* impl)
+		{
+			assert(mac_key);
+
+			if (tag_len == 0)
+			{
+				tag_len = mac_algorithm.result_size();
+			}
+
+			if (tag_len > mac_algorithm.result_size())
+			{
+				throw std::runtime_error("tag_len");
+			}
+
+			// The IV is set for each message in start().
+			m_cipher_ctx.initialize(_algorithm, direction, key, key_len, NULL, _algorithm.iv_length(), impl);
+			m_mac_ctx.initialize(mac_key, mac_key_len, &mac_algorithm, impl);
+			m_tag_len = tag_len;
+		}
+
+		size_t etm_context::seal(void* out, size_t out_len, const void* iv, size_t iv_len, const void* aad, size_t aad_len, const void* in, size_t in_len)
+		{
+			assert(out);
+			assert(in || (in_len == 0));
+
+			if (out_len < max_sealed_size(in_len))
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			start(iv, iv_len, aad, aad_len);
+
+			unsigned char* const cout = static_cast<unsigned char*>(out);
+			const unsigned char* const cin = static_cast<const unsigned char*>(in);
+			size_t cnt = 0;
+
+			for (size_t offset = 0; offset < in_len; offset += tile_size)
+			{
+				const size_t len = (std::min)(tile_size, in_len - offset);
+				const size_t tile_cnt = m_cipher_ctx.update(cout + cnt, out_len - cnt, cin + offset, len);
+
+				// The ciphertext of the tile is still in cache.
+				m_mac_ctx.update(cout + cnt, tile_cnt);
+				cnt += tile_cnt;
+			}
+
+			const size_t final_cnt = m_cipher_ctx.finalize(cout + cnt, out_len - cnt);
+
+			m_mac_ctx.update(cout + cnt, final_cnt);
+			cnt += final_cnt;
+
+			finish_mac(aad_len, cout + cnt);
+
+			return cnt + m_tag_len;
+		}
+
+		bool etm_context::open(void* out, size_t out_len, const void* iv, size_t iv_len, const void* aad, size_t aad_len, const void* in, size_t in_len, size_t& result)
+		{
+			assert(out);
+			assert(in);
+
+			if (in_len < m_tag_len)
+			{
+				return false;
+			}
+
+			const size_t ciphertext_len = in_len - m_tag_len;
+
+			if (out_len < ciphertext_len + algorithm().block_size())
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			start(iv, iv_len, aad, aad_len);
+
+			unsigned char* const cout = static_cast<unsigned char*>(out);
+			const unsigned char* const cin = static_cast<const unsigned char*>(in);
+			size_t cnt = 0;
+
+			for (size_t offset = 0; offset < ciphertext_len; offset += tile_size)
+			{
+				const size_t len = (std::min)(tile_size, ciphertext_len - offset);
+
+				m_mac_ctx.update(cin + offset, len);
+				cnt += m_cipher_ctx.update(cout + cnt, out_len - cnt, cin + offset, len);
+			}
+
+			// A bad padding must not be distinguishable from a bad tag.
+			int final_len = 0;
+			const bool padding_ok = (EVP_CipherFinal_ex(&m_cipher_ctx.raw(), cout + cnt, &final_len) > 0);
+
+			if (padding_ok)
+			{
+				cnt += static_cast<size_t>(final_len);
+			}
+			else
+			{
+				ERR_clear_error();
+			}
+
+			unsigned char tag[EVP_MAX_MD_SIZE];
+
+			finish_mac(aad_len, tag);
+
+			unsigned char diff = 0;
+
+			for (size_t i = 0; i < m_tag_len; ++i)
+			{
+				diff |= tag[i] ^ cin[ciphertext_len + i];
+			}
+
+			if ((diff != 0) || !padding_ok)
+			{
+				OPENSSL_cleanse(out, out_len);
+
+				return false;
+			}
+
+			result = cnt;
+
+			return true;
+		}
+
+		void etm_context::start(const void* iv, size_t iv_len, const void* aad, size_t aad_len)
+		{
+			assert(iv || (iv_len == 0));
+			assert(aad || (aad_len == 0));
+
+			if (iv_len != algorithm().iv_length())
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			if (iv)
+			{
+				m_cipher_ctx.set_iv(iv, iv_len);
+			}
+
+			// Restart the HMAC with the current key.
+			m_mac_ctx.initialize(NULL, 0, NULL);
+			m_mac_ctx.update(aad, aad_len);
+			m_mac_ctx.update(iv, iv_len);
+		}
+
+		void etm_context::finish_mac(size_t aad_len, unsigned char* tag)
+		{
+			const boost::uint64_t aad_bits = static_cast<boost::uint64_t>(aad_len) * 8;
+			unsigned char al[8];
+
+			for (size_t b = 0; b < sizeof(al); ++b)
+			{
+				al[sizeof(al) - 1 - b] = static_cast<unsigned char>(aad_bits >> (8 * b));
+			}
+
+			m_mac_ctx.update(al, sizeof(al));
+
+			unsigned char mac[EVP_MAX_MD_SIZE];
+
+			m_mac_ctx.finalize(mac, sizeof(mac));
+
+			std::copy(mac, mac + m_tag_len, tag);
+			OPENSSL_cleanse(mac, sizeof(mac));
+		}
+	}
+}
@@ -0,0 +1,224 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file file_pipeline.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A file cipher pipeline class.
+ */
+
+#include "cipher/file_pipeline.hpp"
+
+#include "parallel.hpp"
+
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+#include <cerrno>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			struct work_item
+			{
+				size_t index;
+				size_t len;
+				bool last;
+			};
+
+			work_item make_work_item(size_t index, size_t len, bool last)
+			{
+				const work_item result = { index, len, last };
+
+				return result;
+			}
+
+			typedef std::vector<std::vector<unsigned char> > buffer_list;
+			typedef detail::blocking_queue<work_item> work_queue;
+
+			void read_loop(FILE* in, buffer_list& buffers, work_queue& free_buffers, work_queue& full_buffers, detail::parallel_failure& failure)
+			{
+				try
+				{
+					work_item item;
+
+					while (free_buffers.pop(item))
+					{
+						item.len = fread(&buffers[item.index][0], 1, buffers[item.index].size(), in);
+						item.last = (item.len < buffers[item.index].size());
+
+						if (item.last && ferror(in))
+						{
+							throw std::runtime_error(std::strerror(errno));
+						}
+
+						full_buffers.push(item);
+
+						if (item.last)
+						{
+							break;
+						}
+					}
+				}
+				catch (...)
+				{
+					failure.capture_current_exception();
+					full_buffers.close();
+				}
+			}
+
+			void write_loop(FILE* out, buffer_list& buffers, work_queue& full_buffers, work_queue& free_buffers, detail::parallel_failure& failure)
+			{
+				try
+				{
+					work_item item;
+
+					while (full_buffers.pop(item))
+					{
+						if ((item.len > 0) && (fwrite(&buffers[item.index][0], 1, item.len, out) != item.len))
+						{
+							throw std::runtime_error(std::strerror(errno));
+						}
+
+						if (item.last)
+						{
+							if (fflush(out) != 0)
+							{
+								throw std::runtime_error(std::strerror(errno));
+							}
+
+							break;
+						}
+
+						free_buffers.push(item);
+					}
+				}
+				catch (...)
+				{
+					failure.capture_current_exception();
+					free_buffers.close();
+				}
+			}
+		}
+
+		const size_t file_pipeline::default_buffer_size;
+		const size_t file_pipeline::default_buffer_count;
+
+		file_pipeline::file_pipeline(size_t buffer_size, size_t buffer_count) :
+			m_buffer_size(buffer_size),
+			m_buffer_count(buffer_count)
+		{
+			assert(m_buffer_size > 0);
+			assert(m_buffer_count > 0);
+		}
+
+		boost::uint64_t file_pipeline::run(cipher_context& ctx, file in, file out)
+		{
+			const size_t block_size = ctx.algorithm().block_size();
+
+			buffer_list input_buffers(m_buffer_count, std::vector<unsigned char>(m_buffer_size));
+			// update() may write one block more than it is given, and finalize() one more block.
+			buffer_list output_buffers(m_buffer_count, std::vector<unsigned char>(m_buffer_size + 2 * block_size));
+
+			work_queue free_input, full_input, free_output, full_output;
+
+			for (size_t i = 0; i < m_buffer_count; ++i)
+			{
+				free_input.push(make_work_item(i, 0, false));
+				free_output.push(make_work_item(i, 0, false));
+			}
+
+			detail::parallel_failure failure;
+
+			boost::thread reader(&read_loop, in.raw(), boost::ref(input_buffers), boost::ref(free_input), boost::ref(full_input), boost::ref(failure));
+			boost::thread writer(&write_loop, out.raw(), boost::ref(output_buffers), boost::ref(full_output), boost::ref(free_output), boost::ref(failure));
+
+			boost::uint64_t result = 0;
+			bool done = false;
+
+			try
+			{
+				work_item input;
+				work_item output;
+
+				while (!done && full_input.pop(input) && free_output.pop(output))
+				{
+					std::vector<unsigned char>& buffer = output_buffers[output.index];
+
+					output.len = (input.len > 0) ? ctx.update(&buffer[0], buffer.size(), &input_buffers[input.index][0], input.len) : 0;
+
+					if (input.last)
+					{
+						output.len += ctx.finalize(&buffer[0] + output.len, buffer.size() - output.len);
+						done = true;
+					}
+
+					output.last = input.last;
+					result += output.len;
+
+					full_output.push(output);
+					free_input.push(input);
+				}
+			}
+			catch (...)
+			{
+				failure.capture_current_exception();
+			}
+
+			if (!done)
+			{
+				// Something failed: wake up and stop the other threads.
+				free_input.close();
+				full_input.close();
+				free_output.close();
+				full_output.close();
+			}
+
+			reader.join();
+			writer.join();
+
+			failure.rethrow();
+
+			return result;
+		}
+	}
+}
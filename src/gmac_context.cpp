@@ -0,0 +1,99 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file gmac_context.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A GMAC context class.
+ */
+
+#include "hash/gmac_context.hpp"
+
+#include <stdexcept>
+#include <cassert>
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+namespace cryptoplus
+{
+	namespace hash
+	{
+		void gmac_context::initialize(const void* key, size_t key_len, const cipher::cipher_algorithm& algorithm, size_t iv_len, size_t mac_len, ENGINE* impl)
+		{
+			m_ctx.initialize(algorithm, cipher::cipher_context::encrypt, key, key_len, iv_len, mac_len, impl);
+		}
+
+		size_t gmac_context::finalize(void* mac, size_t len)
+		{
+			assert(mac);
+
+			if (len < result_size())
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			// There is no ciphertext: finalize() never writes anything.
+			unsigned char out[EVP_MAX_BLOCK_LENGTH];
+
+			m_ctx.finalize(out, sizeof(out));
+			m_ctx.get_tag(mac, result_size());
+
+			return result_size();
+		}
+
+		size_t gmac_context::compute(void* mac, size_t mac_len, const void* iv, size_t iv_len, const void* data, size_t data_len)
+		{
+			reset(iv, iv_len);
+			update(data, data_len);
+
+			return finalize(mac, mac_len);
+		}
+
+		void gmac_context::compute(message* messages, size_t messages_count)
+		{
+			assert(messages || (messages_count == 0));
+
+			for (message* msg = messages; msg != messages + messages_count; ++msg)
+			{
+				msg->result = compute(msg->mac, msg->mac_len, msg->iv, iv_length(), msg->data, msg->data_len);
+			}
+		}
+	}
+}
+
+#endif
@@ -44,6 +44,7 @@
 
 #include "hash/hmac.hpp"
 #include "hash/hmac_context.hpp"
+#include "context_pool.hpp"
 
 #include <cassert>
 
@@ -51,16 +52,21 @@ namespace cryptoplus
 {
 	namespace hash
 	{
+		namespace
+		{
+			context_pool<hmac_context> pool;
+		}
+
 		size_t hmac(void* out, size_t out_len, const void* key, size_t key_len, const void* data, size_t len, const message_digest_algorithm& algorithm, ENGINE* impl)
 		{
 			assert(out);
 			assert(key);
 			assert(data);
 
-			hmac_context ctx;
-			ctx.initialize(key, key_len, &algorithm, impl);
-			ctx.update(data, len);
-			return ctx.finalize(out, out_len);
+			context_pool<hmac_context>::lease ctx(pool);
+			ctx->initialize(key, key_len, &algorithm, impl);
+			ctx->update(data, len);
+			return ctx->finalize(out, out_len);
 		}
 	}
 }
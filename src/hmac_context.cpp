@@ -44,6 +44,9 @@
 
 #include "hash/hmac_context.hpp"
 
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+
 #include <cassert>
 
 namespace cryptoplus
@@ -73,5 +76,28 @@ namespace cryptoplus
 			return ilen;
 		}
 	}
+
+	void context_pool_traits<hash::hmac_context>::reset(hash::hmac_context& context)
+	{
+		//WARNING: Here we directly use the undocumented HMAC_CTX fields, as hmac_context::algorithm() does.
+		HMAC_CTX& ctx = context.raw();
+
+		if (ctx.md)
+		{
+			OPENSSL_cleanse(ctx.key, sizeof(ctx.key));
+			ctx.key_length = 0;
+
+			// Initializing a digest context with its current digest only resets its state: nothing is freed or allocated.
+			if ((EVP_DigestInit_ex(&ctx.i_ctx, ctx.md, NULL) != 0) && (EVP_DigestInit_ex(&ctx.o_ctx, ctx.md, NULL) != 0) && (EVP_DigestInit_ex(&ctx.md_ctx, ctx.md, NULL) != 0))
+			{
+				return;
+			}
+
+			ERR_clear_error();
+		}
+
+		hash::hmac_context empty_context;
+		context = boost::move(empty_context);
+	}
 }
 
@@ -0,0 +1,377 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file key_wrap.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An AES key wrap class.
+ */
+
+#include "cipher/key_wrap.hpp"
+
+#include <openssl/crypto.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include <cstring>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			// The maximum count of keys processed in lockstep.
+			const size_t lockstep_lanes = 256;
+
+			const size_t semiblock_size = 8;
+			const size_t block_size = 2 * semiblock_size;
+
+			const unsigned char rfc3394_iv[semiblock_size] = { 0xa6, 0xa6, 0xa6, 0xa6, 0xa6, 0xa6, 0xa6, 0xa6 };
+			const unsigned char rfc5649_iv[4] = { 0xa6, 0x59, 0x59, 0xa6 };
+
+			const EVP_CIPHER* get_ecb_cipher(size_t kek_len)
+			{
+				switch (kek_len)
+				{
+					case 16:
+						return EVP_aes_128_ecb();
+					case 24:
+						return EVP_aes_192_ecb();
+					case 32:
+						return EVP_aes_256_ecb();
+				}
+
+				throw std::runtime_error("kek_len");
+			}
+
+			size_t steps_count(size_t n)
+			{
+				// RFC 5649 wraps a single semiblock with one AES block operation.
+				return (n == 1) ? 1 : 6 * n;
+			}
+
+			void xor_counter(unsigned char* a, size_t t)
+			{
+				for (size_t b = 0; b < sizeof(size_t); ++b)
+				{
+					a[semiblock_size - 1 - b] ^= static_cast<unsigned char>(t >> (8 * b));
+				}
+			}
+		}
+
+		key_wrap::key_wrap(const void* kek, size_t kek_len, wrap_mode _mode, ENGINE* impl) :
+			m_mode(_mode)
+		{
+			assert(kek);
+
+			const cipher_algorithm algorithm(get_ecb_cipher(kek_len));
+
+			m_encrypt_ctx.initialize(algorithm, cipher_context::encrypt, kek, kek_len, NULL, 0, impl);
+			m_encrypt_ctx.set_padding(false);
+			m_decrypt_ctx.initialize(algorithm, cipher_context::decrypt, kek, kek_len, NULL, 0, impl);
+			m_decrypt_ctx.set_padding(false);
+		}
+
+		size_t key_wrap::wrap(void* out, size_t out_len, const void* key, size_t key_len)
+		{
+			message msg = { key, key_len, out, out_len, 0 };
+
+			wrap(&msg, 1);
+
+			return msg.result;
+		}
+
+		size_t key_wrap::unwrap(void* out, size_t out_len, const void* in, size_t in_len)
+		{
+			message msg = { in, in_len, out, out_len, 0 };
+
+			unwrap(&msg, 1);
+
+			return msg.result;
+		}
+
+		void key_wrap::wrap(message* messages, size_t messages_count)
+		{
+			assert(messages || (messages_count == 0));
+
+			for (message* msg = messages; msg != messages + messages_count; ++msg)
+			{
+				assert(msg->in);
+				assert(msg->out);
+
+				if ((msg->in_len == 0) || ((m_mode == rfc3394) && ((msg->in_len < 2 * semiblock_size) || (msg->in_len % semiblock_size != 0))))
+				{
+					throw std::runtime_error("key_len");
+				}
+
+				if (msg->out_len < wrapped_length(msg->in_len))
+				{
+					throw std::logic_error("The output buffer is too small");
+				}
+			}
+
+			// The keys are wrapped in place, in their output buffer.
+			m_lanes.resize(messages_count);
+
+			for (size_t i = 0; i < messages_count; ++i)
+			{
+				message& msg = messages[i];
+				unsigned char* const out = static_cast<unsigned char*>(msg.out);
+
+				msg.result = wrapped_length(msg.in_len);
+
+				lane& l = m_lanes[i];
+				l.a = out;
+				l.r = out + semiblock_size;
+				l.n = (msg.result - semiblock_size) / semiblock_size;
+
+				if (m_mode == rfc3394)
+				{
+					std::memcpy(l.a, rfc3394_iv, semiblock_size);
+				}
+				else
+				{
+					std::memcpy(l.a, rfc5649_iv, sizeof(rfc5649_iv));
+
+					for (size_t b = 0; b < 4; ++b)
+					{
+						l.a[semiblock_size - 1 - b] = static_cast<unsigned char>(msg.in_len >> (8 * b));
+					}
+				}
+
+				std::memmove(l.r, msg.in, msg.in_len);
+				std::memset(l.r + msg.in_len, 0x00, l.n * semiblock_size - msg.in_len);
+			}
+
+			if (messages_count > 0)
+			{
+				run(m_encrypt_ctx, true, &m_lanes[0], messages_count);
+			}
+		}
+
+		size_t key_wrap::unwrap(message* messages, size_t messages_count)
+		{
+			assert(messages || (messages_count == 0));
+
+			size_t state_len = 0;
+
+			for (message* msg = messages; msg != messages + messages_count; ++msg)
+			{
+				assert(msg->in);
+				assert(msg->out);
+
+				if ((msg->in_len < 2 * semiblock_size) || (msg->in_len % semiblock_size != 0) || ((m_mode == rfc3394) && (msg->in_len < 3 * semiblock_size)))
+				{
+					throw std::runtime_error("in_len");
+				}
+
+				if (msg->out_len < msg->in_len - semiblock_size)
+				{
+					throw std::logic_error("The output buffer is too small");
+				}
+
+				state_len += msg->in_len;
+			}
+
+			// The input buffers are left untouched: the keys are unwrapped in an internal buffer.
+			m_state.resize(state_len);
+			m_lanes.resize(messages_count);
+
+			unsigned char* state = m_state.empty() ? NULL : &m_state[0];
+
+			for (size_t i = 0; i < messages_count; ++i)
+			{
+				const message& msg = messages[i];
+
+				std::memcpy(state, msg.in, msg.in_len);
+
+				lane& l = m_lanes[i];
+				l.a = state;
+				l.r = state + semiblock_size;
+				l.n = (msg.in_len - semiblock_size) / semiblock_size;
+
+				state += msg.in_len;
+			}
+
+			if (messages_count > 0)
+			{
+				run(m_decrypt_ctx, false, &m_lanes[0], messages_count);
+			}
+
+			size_t failed_count = 0;
+
+			for (size_t i = 0; i < messages_count; ++i)
+			{
+				message& msg = messages[i];
+				const lane& l = m_lanes[i];
+				const size_t max_len = l.n * semiblock_size;
+
+				unsigned char error = 0;
+				size_t key_len = max_len;
+
+				if (m_mode == rfc3394)
+				{
+					for (size_t b = 0; b < semiblock_size; ++b)
+					{
+						error |= l.a[b] ^ rfc3394_iv[b];
+					}
+				}
+				else
+				{
+					for (size_t b = 0; b < sizeof(rfc5649_iv); ++b)
+					{
+						error |= l.a[b] ^ rfc5649_iv[b];
+					}
+
+					key_len = 0;
+
+					for (size_t b = 0; b < 4; ++b)
+					{
+						key_len = (key_len << 8) | l.a[semiblock_size - 4 + b];
+					}
+
+					if ((key_len + semiblock_size <= max_len) || (key_len > max_len))
+					{
+						error |= 1;
+						key_len = max_len;
+					}
+
+					for (size_t b = key_len; b < max_len; ++b)
+					{
+						error |= l.r[b];
+					}
+				}
+
+				if (error == 0)
+				{
+					std::memcpy(msg.out, l.r, key_len);
+					msg.result = key_len;
+				}
+				else
+				{
+					msg.result = 0;
+					++failed_count;
+				}
+			}
+
+			if (!m_state.empty())
+			{
+				OPENSSL_cleanse(&m_state[0], m_state.size());
+			}
+
+			return failed_count;
+		}
+
+		void key_wrap::run(cipher_context& ctx, bool encrypt, lane* lanes, size_t lanes_count)
+		{
+			m_blocks.resize((lockstep_lanes + 1) * block_size);
+
+			unsigned char* const blocks = &m_blocks[0];
+
+			for (lane* group = lanes; group < lanes + lanes_count; group += lockstep_lanes)
+			{
+				lane* const group_end = std::min(group + lockstep_lanes, lanes + lanes_count);
+
+				size_t max_steps = 0;
+
+				for (lane* l = group; l != group_end; ++l)
+				{
+					max_steps = std::max(max_steps, steps_count(l->n));
+				}
+
+				for (size_t s = 0; s < max_steps; ++s)
+				{
+					unsigned char* block = blocks;
+
+					for (lane* l = group; l != group_end; ++l)
+					{
+						const size_t steps = steps_count(l->n);
+
+						if (s < steps)
+						{
+							// Unwrapping runs the wrapping steps backwards.
+							const size_t t = encrypt ? (s + 1) : (steps - s);
+							unsigned char* const r = l->r + ((t - 1) % l->n) * semiblock_size;
+
+							std::memcpy(block, l->a, semiblock_size);
+							std::memcpy(block + semiblock_size, r, semiblock_size);
+
+							if (!encrypt && (steps > 1))
+							{
+								xor_counter(block, t);
+							}
+
+							block += block_size;
+						}
+					}
+
+					const size_t len = static_cast<size_t>(block - blocks);
+
+					ctx.update(blocks, m_blocks.size(), blocks, len);
+
+					block = blocks;
+
+					for (lane* l = group; l != group_end; ++l)
+					{
+						const size_t steps = steps_count(l->n);
+
+						if (s < steps)
+						{
+							const size_t t = encrypt ? (s + 1) : (steps - s);
+							unsigned char* const r = l->r + ((t - 1) % l->n) * semiblock_size;
+
+							std::memcpy(l->a, block, semiblock_size);
+							std::memcpy(r, block + semiblock_size, semiblock_size);
+
+							if (encrypt && (steps > 1))
+							{
+								xor_counter(l->a, t);
+							}
+
+							block += block_size;
+						}
+					}
+				}
+			}
+
+			OPENSSL_cleanse(blocks, m_blocks.size());
+		}
+	}
+}
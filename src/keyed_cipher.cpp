@@ -0,0 +1,84 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file keyed_cipher.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A pre-keyed cipher class.
+ */
+
+#include "cipher/keyed_cipher.hpp"
+
+#include <cassert>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		keyed_cipher::keyed_cipher(const cipher_algorithm& _algorithm, cipher_context::cipher_direction _direction, const void* key, size_t key_len, bool padding, ENGINE* impl) :
+			m_direction(_direction)
+		{
+			assert(key);
+
+			if (key_len != _algorithm.key_length())
+			{
+				throw std::runtime_error("key_len");
+			}
+
+			// The IV is set for each message in create_context().
+			error::throw_error_if_not(EVP_CipherInit_ex(&m_ctx.raw(), _algorithm.raw(), impl, static_cast<const unsigned char*>(key), NULL, static_cast<int>(_direction)) != 0);
+
+			m_ctx.set_padding(padding);
+		}
+
+		void keyed_cipher::create_context(cipher_context& ctx, const void* iv, size_t iv_len) const
+		{
+			if (iv_len != m_ctx.algorithm().iv_length())
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			ctx.copy(m_ctx);
+
+			if (iv)
+			{
+				ctx.set_iv(iv, iv_len);
+			}
+		}
+	}
+}
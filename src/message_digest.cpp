@@ -44,6 +44,7 @@
 
 #include "hash/message_digest.hpp"
 #include "hash/message_digest_context.hpp"
+#include "context_pool.hpp"
 
 #include <cassert>
 
@@ -51,15 +52,20 @@ namespace cryptoplus
 {
 	namespace hash
 	{
+		namespace
+		{
+			context_pool<message_digest_context> pool;
+		}
+
 		size_t message_digest(void* out, size_t out_len, const void* data, size_t len, const message_digest_algorithm& algorithm, ENGINE* impl)
 		{
 			assert(out);
 			assert(data);
 
-			message_digest_context ctx;
-			ctx.initialize(algorithm, impl);
-			ctx.update(data, len);
-			return ctx.finalize(out, out_len);
+			context_pool<message_digest_context>::lease ctx(pool);
+			ctx->initialize(algorithm, impl);
+			ctx->update(data, len);
+			return ctx->finalize(out, out_len);
 		}
 	}
 }
@@ -44,6 +44,8 @@
 
 #include "hash/message_digest_algorithm.hpp"
 
+#include "algorithm_registry.hpp"
+
 #include <stdexcept>
 #include <cassert>
 
@@ -51,21 +53,45 @@ namespace cryptoplus
 {
 	namespace hash
 	{
-		message_digest_algorithm::message_digest_algorithm(int _type) :
-			m_md(EVP_get_digestbynid(_type))
+		message_digest_algorithm::message_digest_algorithm(int _type)
 		{
-			if (!m_md)
+			const detail::digest_entry* const entry = detail::find_digest(_type);
+
+			if (entry)
 			{
-				throw std::invalid_argument("type");
+				m_md = entry->md;
+				m_result_size = entry->result_size;
+				m_block_size = entry->block_size;
+			}
+			else
+			{
+				set_md(EVP_get_digestbynid(_type));
+
+				if (!m_md)
+				{
+					throw std::invalid_argument("type");
+				}
 			}
 		}
 
-		message_digest_algorithm::message_digest_algorithm(const std::string& _name) :
-			m_md(EVP_get_digestbyname(_name.c_str()))
+		message_digest_algorithm::message_digest_algorithm(const std::string& _name)
 		{
-			if (!m_md)
+			const detail::digest_entry* const entry = detail::find_digest(_name);
+
+			if (entry)
+			{
+				m_md = entry->md;
+				m_result_size = entry->result_size;
+				m_block_size = entry->block_size;
+			}
+			else
 			{
-				throw std::invalid_argument("name");
+				set_md(EVP_get_digestbyname(_name.c_str()));
+
+				if (!m_md)
+				{
+					throw std::invalid_argument("name");
+				}
 			}
 		}
 	}
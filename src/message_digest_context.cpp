@@ -46,6 +46,8 @@
 
 #include "pkey/pkey.hpp"
 
+#include <openssl/err.h>
+
 #include <cassert>
 
 namespace cryptoplus
@@ -83,5 +85,22 @@ namespace cryptoplus
 			return (result == 1);
 		}
 	}
+
+	void context_pool_traits<hash::message_digest_context>::reset(hash::message_digest_context& context)
+	{
+		EVP_MD_CTX& ctx = context.raw();
+		const EVP_MD* md = EVP_MD_CTX_md(&ctx);
+
+		// Initializing a digest context with its current digest only resets its state: nothing is freed or allocated.
+		if (md && (EVP_DigestInit_ex(&ctx, md, NULL) != 0))
+		{
+			return;
+		}
+
+		ERR_clear_error();
+
+		hash::message_digest_context empty_context;
+		context = boost::move(empty_context);
+	}
 }
 
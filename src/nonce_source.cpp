@@ -0,0 +1,204 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file nonce_source.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief A nonce generator class.
+ */
+
+#include "cipher/nonce_source.hpp"
+
+#include "random/random.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			boost::uint64_t get_random_counter()
+			{
+				unsigned char buf[8];
+
+				random::get_random_bytes(buf, sizeof(buf));
+
+				boost::uint64_t result = 0;
+
+				for (size_t i = 0; i < sizeof(buf); ++i)
+				{
+					result = (result << 8) | buf[i];
+				}
+
+				return result;
+			}
+
+			void store_counter(unsigned char* buf, boost::uint64_t counter)
+			{
+				for (size_t i = 0; i < nonce_source::counter_length; ++i)
+				{
+					buf[nonce_source::counter_length - 1 - i] = static_cast<unsigned char>(counter >> (8 * i));
+				}
+			}
+		}
+
+		const size_t nonce_source::counter_length = 8;
+		const size_t nonce_source::default_nonce_length = 12;
+		const boost::uint64_t nonce_source::counter_block_size = 1 << 20;
+
+		nonce_source::nonce_source(nonce_mode _mode, size_t nonce_len) :
+			m_mode(_mode),
+			m_nonce_len(nonce_len),
+			m_next_counter(0),
+			m_reserved_blocks(0)
+		{
+			if ((nonce_len == 0) || ((m_mode == deterministic_nonce) && (nonce_len < counter_length)))
+			{
+				throw std::runtime_error("nonce_len");
+			}
+
+			if (m_mode == deterministic_nonce)
+			{
+				m_fixed.resize(nonce_len - counter_length);
+
+				if (!m_fixed.empty())
+				{
+					random::get_random_bytes(&m_fixed[0], m_fixed.size());
+				}
+
+				m_next_counter = get_random_counter();
+			}
+		}
+
+		nonce_source::nonce_source(const void* fixed, size_t fixed_len) :
+			m_mode(deterministic_nonce),
+			m_nonce_len(fixed_len + counter_length),
+			m_fixed(static_cast<const unsigned char*>(fixed), static_cast<const unsigned char*>(fixed) + fixed_len),
+			m_next_counter(get_random_counter()),
+			m_reserved_blocks(0)
+		{
+			assert(fixed || (fixed_len == 0));
+		}
+
+		void nonce_source::generate(void* nonces, size_t nonce_len, size_t count) const
+		{
+			assert(nonces);
+
+			if (nonce_len != m_nonce_len)
+			{
+				throw std::runtime_error("nonce_len");
+			}
+
+			if (m_mode == random_nonce)
+			{
+				random::get_buffered_random_bytes(nonces, nonce_len * count);
+
+				return;
+			}
+
+			counter_block& block = get_counter_block();
+			unsigned char* nonce = static_cast<unsigned char*>(nonces);
+
+			for (size_t i = 0; i < count; ++i, nonce += nonce_len)
+			{
+				if (block.next == block.end)
+				{
+					reserve_counter_block(block);
+				}
+
+				std::copy(m_fixed.begin(), m_fixed.end(), nonce);
+				store_counter(nonce + m_fixed.size(), block.next++);
+			}
+		}
+
+		void nonce_source::reseed() const
+		{
+			if (m_mode == random_nonce)
+			{
+				random::discard_buffered_random_bytes();
+
+				return;
+			}
+
+			m_counter_block.reset();
+
+			boost::mutex::scoped_lock lock(m_mutex);
+
+			m_next_counter = get_random_counter();
+		}
+
+		nonce_source::counter_block& nonce_source::get_counter_block() const
+		{
+			counter_block* block = m_counter_block.get();
+
+			if (!block)
+			{
+				block = new counter_block();
+				block->next = 0;
+				block->end = 0;
+
+				m_counter_block.reset(block);
+			}
+
+			return *block;
+		}
+
+		void nonce_source::reserve_counter_block(counter_block& block) const
+		{
+			// The counter wraps: 2^64 / counter_block_size blocks can be reserved from any first value.
+			const boost::uint64_t max_blocks = (~boost::uint64_t(0) / counter_block_size) + 1;
+
+			boost::mutex::scoped_lock lock(m_mutex);
+
+			if (m_reserved_blocks == max_blocks)
+			{
+				throw std::runtime_error("The nonce counter is exhausted");
+			}
+
+			++m_reserved_blocks;
+
+			block.next = m_next_counter;
+			block.end = block.next + counter_block_size;
+			m_next_counter = block.end;
+		}
+	}
+}
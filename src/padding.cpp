@@ -0,0 +1,162 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file padding.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Batch padding verification functions.
+ */
+
+#include "cipher/padding.hpp"
+
+#include <openssl/evp.h>
+
+#include <stdexcept>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CRYPTOPLUS_PADDING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			// All these helpers return either 0 or ~0, without branching.
+
+			inline size_t mask_if_zero(size_t x)
+			{
+				return static_cast<size_t>(0) - static_cast<size_t>(((x | (static_cast<size_t>(0) - x)) >> (sizeof(size_t) * 8 - 1)) ^ 1);
+			}
+
+			inline size_t mask_if_less(size_t a, size_t b)
+			{
+				// Only valid for a and b lower than half the range of size_t.
+				return static_cast<size_t>(0) - ((a - b) >> (sizeof(size_t) * 8 - 1));
+			}
+
+			inline size_t padding_error_bytes(const unsigned char* last_block, size_t block_size, size_t padding_len)
+			{
+				size_t error = 0;
+
+				for (size_t i = 0; i < block_size; ++i)
+				{
+					// The byte at i is in the padding if block_size - i <= padding_len.
+					const size_t in_padding = mask_if_less(block_size - i, padding_len + 1);
+
+					error |= in_padding & (last_block[i] ^ padding_len);
+				}
+
+				return error;
+			}
+
+#ifdef CRYPTOPLUS_PADDING_SSE2
+			inline size_t padding_error_bytes_16(const unsigned char* last_block, size_t padding_len)
+			{
+				const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last_block));
+				const __m128i padding = _mm_set1_epi8(static_cast<char>(padding_len));
+				const __m128i positions = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+				// padding_len is at most 255: compare the high bit separately from the signed comparison.
+				const __m128i in_padding = _mm_or_si128(_mm_cmpgt_epi8(padding, positions), _mm_cmplt_epi8(padding, _mm_setzero_si128()));
+				const __m128i mismatch = _mm_andnot_si128(_mm_cmpeq_epi8(block, padding), in_padding);
+
+				return static_cast<size_t>(_mm_movemask_epi8(mismatch));
+			}
+#endif
+		}
+
+		size_t verify_padding(padding_scheme scheme, size_t block_size, const void* const* bufs, const size_t* buf_lens, size_t* results, size_t count)
+		{
+			assert(bufs);
+			assert(buf_lens);
+			assert(results);
+
+			if ((block_size == 0) || (block_size > EVP_MAX_BLOCK_LENGTH))
+			{
+				throw std::logic_error("Invalid block size");
+			}
+
+			const bool check_bytes = (scheme == pkcs7_padding);
+			size_t invalid_count = 0;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const size_t buf_len = buf_lens[i];
+
+				// The length is public: branching on it leaks nothing.
+				if ((buf_len == 0) || (buf_len % block_size != 0))
+				{
+					results[i] = invalid_padding;
+					++invalid_count;
+
+					continue;
+				}
+
+				assert(bufs[i]);
+
+				const unsigned char* const last_block = static_cast<const unsigned char*>(bufs[i]) + buf_len - block_size;
+				const size_t padding_len = last_block[block_size - 1];
+
+				size_t error = mask_if_zero(padding_len) | ~mask_if_less(padding_len, block_size + 1);
+
+				if (check_bytes)
+				{
+#ifdef CRYPTOPLUS_PADDING_SSE2
+					if (block_size == 16)
+					{
+						error |= ~mask_if_zero(padding_error_bytes_16(last_block, padding_len));
+					}
+					else
+#endif
+					{
+						error |= ~mask_if_zero(padding_error_bytes(last_block, block_size, padding_len));
+					}
+				}
+
+				results[i] = ((buf_len - padding_len) & ~error) | (invalid_padding & error);
+				invalid_count += error & 1;
+			}
+
+			return invalid_count;
+		}
+	}
+}
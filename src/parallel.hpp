@@ -0,0 +1,264 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file parallel.hpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Internal helpers to spread independent work items over several threads.
+ *
+ * This header is private to the library and is not installed.
+ */
+
+#ifndef CRYPTOPLUS_PARALLEL_HPP
+#define CRYPTOPLUS_PARALLEL_HPP
+
+#include "error/cryptographic_exception.hpp"
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <cstddef>
+
+namespace cryptoplus
+{
+	namespace detail
+	{
+		/**
+		 * \brief Get the count of threads to use.
+		 * \param thread_count The requested thread count. 0 means one thread per hardware thread.
+		 * \param items_count The count of work items.
+		 * \return The count of threads to use, between 1 and items_count.
+		 */
+		inline size_t get_thread_count(unsigned int thread_count, size_t items_count)
+		{
+			size_t result = (thread_count == 0) ? boost::thread::hardware_concurrency() : thread_count;
+
+			return (std::max)(static_cast<size_t>(1), (std::min)(result, items_count));
+		}
+
+		/**
+		 * \brief Records the first failure of a set of workers.
+		 *
+		 * The OpenSSL error queue is per-thread, so cryptographic errors must be captured in the thread that got them.
+		 */
+		class parallel_failure : public boost::noncopyable
+		{
+			public:
+
+				parallel_failure() : m_failed(false), m_err(0) {}
+
+				void capture_cryptographic_error(const error::cryptographic_exception& ex)
+				{
+					boost::mutex::scoped_lock lock(m_mutex);
+
+					if (!m_failed)
+					{
+						m_failed = true;
+						m_err = ex.err();
+					}
+				}
+
+				void capture_current_exception()
+				{
+					boost::mutex::scoped_lock lock(m_mutex);
+
+					if (!m_failed)
+					{
+						m_failed = true;
+						m_exception = boost::current_exception();
+					}
+				}
+
+				void rethrow() const
+				{
+					if (m_failed)
+					{
+						if (m_exception)
+						{
+							boost::rethrow_exception(m_exception);
+						}
+
+						throw error::cryptographic_exception(m_err);
+					}
+				}
+
+			private:
+
+				boost::mutex m_mutex;
+				bool m_failed;
+				error::error_type m_err;
+				boost::exception_ptr m_exception;
+		};
+
+		template <typename Function>
+		void parallel_run_range(Function& function, size_t begin, size_t end, parallel_failure& failure)
+		{
+			try
+			{
+				for (size_t i = begin; i != end; ++i)
+				{
+					function(i);
+				}
+			}
+			catch (const error::cryptographic_exception& ex)
+			{
+				failure.capture_cryptographic_error(ex);
+			}
+			catch (...)
+			{
+				failure.capture_current_exception();
+			}
+		}
+
+		/**
+		 * \brief Call function(i) for every i in [0, items_count), using several threads.
+		 * \param items_count The count of work items.
+		 * \param thread_count The maximum count of threads to use, including the calling thread. 0 means one thread per hardware thread.
+		 * \param function The function to call. It is shared by all the threads and must be safe to call concurrently for different items.
+		 *
+		 * Each thread gets a contiguous range of items. The first exception thrown by a work item is rethrown in the calling thread once all the threads are done.
+		 */
+		template <typename Function>
+		void parallel_for(size_t items_count, unsigned int thread_count, Function& function)
+		{
+			const size_t threads_count = get_thread_count(thread_count, items_count);
+
+			if (threads_count <= 1)
+			{
+				for (size_t i = 0; i != items_count; ++i)
+				{
+					function(i);
+				}
+
+				return;
+			}
+
+			parallel_failure failure;
+			boost::thread_group threads;
+
+			try
+			{
+				for (size_t t = 1; t < threads_count; ++t)
+				{
+					threads.create_thread(boost::bind(&parallel_run_range<Function>, boost::ref(function), items_count * t / threads_count, items_count * (t + 1) / threads_count, boost::ref(failure)));
+				}
+			}
+			catch (...)
+			{
+				threads.join_all();
+
+				throw;
+			}
+
+			parallel_run_range(function, 0, items_count / threads_count, failure);
+
+			threads.join_all();
+
+			failure.rethrow();
+		}
+
+		/**
+		 * \brief A blocking queue, to pass work items between threads.
+		 *
+		 * Once closed, the queue drops all its items and pop() returns false immediately: this is used to abort a pipeline.
+		 */
+		template <typename T>
+		class blocking_queue : public boost::noncopyable
+		{
+			public:
+
+				blocking_queue() : m_closed(false) {}
+
+				void push(const T& item)
+				{
+					boost::mutex::scoped_lock lock(m_mutex);
+
+					if (!m_closed)
+					{
+						m_items.push_back(item);
+						m_condition.notify_one();
+					}
+				}
+
+				bool pop(T& item)
+				{
+					boost::mutex::scoped_lock lock(m_mutex);
+
+					while (m_items.empty() && !m_closed)
+					{
+						m_condition.wait(lock);
+					}
+
+					if (m_closed)
+					{
+						return false;
+					}
+
+					item = m_items.front();
+					m_items.pop_front();
+
+					return true;
+				}
+
+				void close()
+				{
+					boost::mutex::scoped_lock lock(m_mutex);
+
+					m_closed = true;
+					m_items.clear();
+					m_condition.notify_all();
+				}
+
+			private:
+
+				boost::mutex m_mutex;
+				boost::condition_variable m_condition;
+				std::deque<T> m_items;
+				bool m_closed;
+		};
+	}
+}
+
+#endif /* CRYPTOPLUS_PARALLEL_HPP */
@@ -0,0 +1,722 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file parallel_cipher.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Multi-threaded cipher helper functions.
+ */
+
+#include "cipher/parallel_cipher.hpp"
+
+#include "cipher/cipher_context.hpp"
+#include "cipher/aead_context.hpp"
+
+#include "parallel.hpp"
+#include "cipher_mode.hpp"
+
+#include <openssl/crypto.h>
+
+#include <boost/cstdint.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <climits>
+#include <cassert>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			// Chunks smaller than this are not worth a thread.
+			const size_t min_chunk_size = 64 * 1024;
+
+			// The tile size used to interleave the cipher and the GHASH passes while the data is still in cache.
+			const size_t tile_size = 32 * 1024;
+
+			const size_t counter_block_size = 16;
+
+			// OpenSSL takes int lengths: larger buffers are processed in several calls, of a whole count of blocks each.
+			const size_t max_update_size = INT_MAX / counter_block_size * counter_block_size;
+
+			size_t get_chunk_size(size_t len, unsigned int thread_count)
+			{
+				const size_t chunks_count = detail::get_thread_count(thread_count, (len + min_chunk_size - 1) / min_chunk_size);
+				const size_t chunk_size = (len + chunks_count - 1) / chunks_count;
+
+				// Chunks must start on a counter block boundary.
+				return (std::max)(counter_block_size, (chunk_size + counter_block_size - 1) / counter_block_size * counter_block_size);
+			}
+
+			// cipher_context::update() requires one extra block of output space, which the chunks do not have.
+			size_t raw_update(cipher_context& ctx, unsigned char* out, const unsigned char* in, size_t len)
+			{
+				int out_len = 0;
+
+				error::throw_error_if_not(EVP_CipherUpdate(&ctx.raw(), out, &out_len, in, static_cast<int>(len)) != 0);
+
+				return out_len;
+			}
+
+			size_t raw_finalize(cipher_context& ctx, unsigned char* out)
+			{
+				int out_len = 0;
+
+				error::throw_error_if_not(EVP_CipherFinal_ex(&ctx.raw(), out, &out_len) != 0);
+
+				return out_len;
+			}
+
+			void set_counter(cipher_context& ctx, const unsigned char* counter)
+			{
+				error::throw_error_if_not(EVP_CipherInit_ex(&ctx.raw(), NULL, NULL, NULL, counter, -1) != 0);
+			}
+
+			class ctr_task
+			{
+				public:
+
+					ctr_task(unsigned char* out, const unsigned char* in, size_t len, size_t chunk_size, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv) :
+						m_out(out),
+						m_in(in),
+						m_len(len),
+						m_chunk_size(chunk_size),
+						m_algorithm(algorithm),
+						m_key(key),
+						m_key_len(key_len),
+						m_iv(static_cast<const unsigned char*>(iv))
+					{
+					}
+
+					void operator()(size_t chunk)
+					{
+						const size_t offset = chunk * m_chunk_size;
+						const size_t len = (std::min)(m_chunk_size, m_len - offset);
+
+						unsigned char counter[counter_block_size];
+						std::memcpy(counter, m_iv, counter_block_size);
+						detail::add_to_counter(counter, counter_block_size, offset / counter_block_size);
+
+						cipher_context ctx;
+						ctx.initialize(m_algorithm, cipher_context::encrypt, m_key, m_key_len, counter, counter_block_size);
+
+						for (size_t done = 0; done < len; done += max_update_size)
+						{
+							raw_update(ctx, m_out + offset + done, m_in + offset + done, (std::min)(max_update_size, len - done));
+						}
+					}
+
+				private:
+
+					unsigned char* m_out;
+					const unsigned char* m_in;
+					size_t m_len;
+					size_t m_chunk_size;
+					cipher_algorithm m_algorithm;
+					const void* m_key;
+					size_t m_key_len;
+					const unsigned char* m_iv;
+			};
+
+			class cbc_decrypt_task
+			{
+				public:
+
+					cbc_decrypt_task(unsigned char* out, const unsigned char* in, size_t len, size_t chunk_size, bool padding, const cipher_algorithm& algorithm, const void* key, size_t key_len, const std::vector<unsigned char>& ivs, std::vector<size_t>& results) :
+						m_out(out),
+						m_in(in),
+						m_len(len),
+						m_chunk_size(chunk_size),
+						m_padding(padding),
+						m_algorithm(algorithm),
+						m_key(key),
+						m_key_len(key_len),
+						m_ivs(ivs),
+						m_results(results)
+					{
+					}
+
+					void operator()(size_t chunk)
+					{
+						const size_t offset = chunk * m_chunk_size;
+						const size_t len = (std::min)(m_chunk_size, m_len - offset);
+						const size_t iv_len = m_algorithm.iv_length();
+						const bool last = (offset + len == m_len);
+
+						cipher_context ctx;
+						ctx.initialize(m_algorithm, cipher_context::decrypt, m_key, m_key_len, &m_ivs[chunk * iv_len], iv_len);
+						ctx.set_padding(m_padding && last);
+
+						size_t result = 0;
+
+						for (size_t done = 0; done < len; done += max_update_size)
+						{
+							result += raw_update(ctx, m_out + offset + result, m_in + offset + done, (std::min)(max_update_size, len - done));
+						}
+
+						result += raw_finalize(ctx, m_out + offset + result);
+
+						m_results[chunk] = result;
+					}
+
+				private:
+
+					unsigned char* m_out;
+					const unsigned char* m_in;
+					size_t m_len;
+					size_t m_chunk_size;
+					bool m_padding;
+					cipher_algorithm m_algorithm;
+					const void* m_key;
+					size_t m_key_len;
+					const std::vector<unsigned char>& m_ivs;
+					std::vector<size_t>& m_results;
+			};
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+			/*
+			 * GF(2^128) arithmetic, as defined by the GCM specification.
+			 *
+			 * This is only used to combine a few partial GHASH values: the bulk of the GHASH work is done by OpenSSL.
+			 */
+
+			struct block128
+			{
+				boost::uint64_t hi;
+				boost::uint64_t lo;
+			};
+
+			block128 make_block(boost::uint64_t hi, boost::uint64_t lo)
+			{
+				block128 result = { hi, lo };
+
+				return result;
+			}
+
+			block128 load_block(const unsigned char* buf)
+			{
+				block128 result = { 0, 0 };
+
+				for (size_t i = 0; i < 8; ++i)
+				{
+					result.hi = (result.hi << 8) | buf[i];
+					result.lo = (result.lo << 8) | buf[i + 8];
+				}
+
+				return result;
+			}
+
+			void store_block(const block128& block, unsigned char* buf)
+			{
+				for (size_t i = 0; i < 8; ++i)
+				{
+					buf[i] = static_cast<unsigned char>(block.hi >> (56 - 8 * i));
+					buf[i + 8] = static_cast<unsigned char>(block.lo >> (56 - 8 * i));
+				}
+			}
+
+			block128 operator^(const block128& lhs, const block128& rhs)
+			{
+				return make_block(lhs.hi ^ rhs.hi, lhs.lo ^ rhs.lo);
+			}
+
+			block128 gf_multiply(const block128& x, const block128& y)
+			{
+				block128 z = make_block(0, 0);
+				block128 v = y;
+
+				for (unsigned int i = 0; i < 128; ++i)
+				{
+					const boost::uint64_t bit = ((i < 64) ? (x.hi >> (63 - i)) : (x.lo >> (127 - i))) & 1;
+					const boost::uint64_t mask = ~bit + 1;
+
+					z.hi ^= v.hi & mask;
+					z.lo ^= v.lo & mask;
+
+					const boost::uint64_t lsb_mask = ~(v.lo & 1) + 1;
+
+					v.lo = (v.lo >> 1) | (v.hi << 63);
+					v.hi = (v.hi >> 1) ^ (static_cast<boost::uint64_t>(0xe1) << 56 & lsb_mask);
+				}
+
+				return z;
+			}
+
+			block128 gf_power(const block128& x, boost::uint64_t n)
+			{
+				// The multiplicative identity has only its first bit set.
+				block128 result = make_block(static_cast<boost::uint64_t>(1) << 63, 0);
+				block128 base = x;
+
+				for (; n != 0; n >>= 1)
+				{
+					if (n & 1)
+					{
+						result = gf_multiply(result, base);
+					}
+
+					base = gf_multiply(base, base);
+				}
+
+				return result;
+			}
+
+			block128 length_block(boost::uint64_t aad_len, boost::uint64_t data_len)
+			{
+				return make_block(aad_len * 8, data_len * 8);
+			}
+
+			block128 ecb_encrypt_block(cipher_context& ecb, const block128& block)
+			{
+				unsigned char buf[counter_block_size];
+				unsigned char result[2 * counter_block_size];
+
+				store_block(block, buf);
+				ecb.update(result, sizeof(result), buf, sizeof(buf));
+
+				return load_block(result);
+			}
+
+			/*
+			 * The GHASH of a buffer is obtained from OpenSSL by authenticating it as additional data under a fixed IV (GMAC):
+			 *
+			 * tag = E(K, J0') ^ (S * H) ^ (L * H)
+			 *
+			 * where S is the Horner sum of the buffer blocks and L its length block.
+			 */
+			class ghash_accumulator
+			{
+				public:
+
+					static const unsigned char fixed_iv[12];
+
+					ghash_accumulator(const cipher_algorithm& algorithm, const void* key, size_t key_len) :
+						m_len(0)
+					{
+						m_ctx.initialize(algorithm, cipher_context::encrypt, key, key_len, sizeof(fixed_iv));
+						m_ctx.set_iv(fixed_iv, sizeof(fixed_iv));
+					}
+
+					void update(const unsigned char* buf, size_t len)
+					{
+						for (size_t done = 0; done < len; done += max_update_size)
+						{
+							m_ctx.update_aad(buf + done, (std::min)(max_update_size, len - done));
+						}
+
+						m_len += len;
+					}
+
+					// Get S * H, given H and E(K, J0').
+					block128 finalize(const block128& h, const block128& mask)
+					{
+						unsigned char tag[counter_block_size];
+						unsigned char dummy[counter_block_size];
+
+						m_ctx.finalize(dummy, sizeof(dummy));
+						m_ctx.get_tag(tag, sizeof(tag));
+
+						return load_block(tag) ^ mask ^ gf_multiply(length_block(m_len, 0), h);
+					}
+
+				private:
+
+					aead_context m_ctx;
+					boost::uint64_t m_len;
+			};
+
+			const unsigned char ghash_accumulator::fixed_iv[12] = { 0 };
+
+			void check_tag_length(size_t tag_len)
+			{
+				if ((tag_len < 4) || (tag_len > counter_block_size))
+				{
+					throw std::runtime_error("tag_len");
+				}
+			}
+
+			class gcm_task
+			{
+				public:
+
+					gcm_task(unsigned char* out, const unsigned char* in, size_t len, size_t chunk_size, bool encrypt, const cipher_algorithm& algorithm, const cipher_algorithm& ctr_algorithm, const void* key, size_t key_len, const block128& j0, const block128& h, const block128& mask, std::vector<block128>& partials) :
+						m_out(out),
+						m_in(in),
+						m_len(len),
+						m_chunk_size(chunk_size),
+						m_encrypt(encrypt),
+						m_algorithm(algorithm),
+						m_ctr_algorithm(ctr_algorithm),
+						m_key(key),
+						m_key_len(key_len),
+						m_j0(j0),
+						m_h(h),
+						m_mask(mask),
+						m_partials(partials)
+					{
+					}
+
+					void operator()(size_t chunk)
+					{
+						const size_t offset = chunk * m_chunk_size;
+						const size_t len = (std::min)(m_chunk_size, m_len - offset);
+
+						// GCM increments only the last 32 bits of the counter block, starting at inc32(J0).
+						boost::uint32_t counter_low = static_cast<boost::uint32_t>(m_j0.lo) + 1 + static_cast<boost::uint32_t>(offset / counter_block_size);
+
+						cipher_context ctr;
+						ctr.initialize(m_ctr_algorithm, cipher_context::encrypt, m_key, m_key_len, NULL, counter_block_size);
+
+						ghash_accumulator ghash(m_algorithm, m_key, m_key_len);
+
+						for (size_t tile_offset = offset; tile_offset < offset + len; tile_offset += tile_size)
+						{
+							const size_t tile_len = (std::min)(tile_size, offset + len - tile_offset);
+
+							if (!m_encrypt)
+							{
+								ghash.update(m_in + tile_offset, tile_len);
+							}
+
+							for (size_t done = 0; done < tile_len;)
+							{
+								// The 32 bits counter may wrap around in the middle of a tile: OpenSSL's CTR mode would then carry into the upper bits.
+								const boost::uint64_t blocks_before_wrap = (static_cast<boost::uint64_t>(1) << 32) - counter_low;
+								const size_t part_len = static_cast<size_t>((std::min)(static_cast<boost::uint64_t>(tile_len - done), blocks_before_wrap * counter_block_size));
+
+								unsigned char counter[counter_block_size];
+								store_block(make_block(m_j0.hi, (m_j0.lo & ~static_cast<boost::uint64_t>(0xffffffff)) | counter_low), counter);
+
+								set_counter(ctr, counter);
+								raw_update(ctr, m_out + tile_offset + done, m_in + tile_offset + done, part_len);
+
+								counter_low += static_cast<boost::uint32_t>((part_len + counter_block_size - 1) / counter_block_size);
+								done += part_len;
+							}
+
+							if (m_encrypt)
+							{
+								ghash.update(m_out + tile_offset, tile_len);
+							}
+						}
+
+						m_partials[chunk] = ghash.finalize(m_h, m_mask);
+					}
+
+				private:
+
+					unsigned char* m_out;
+					const unsigned char* m_in;
+					size_t m_len;
+					size_t m_chunk_size;
+					bool m_encrypt;
+					cipher_algorithm m_algorithm;
+					cipher_algorithm m_ctr_algorithm;
+					const void* m_key;
+					size_t m_key_len;
+					block128 m_j0;
+					block128 m_h;
+					block128 m_mask;
+					std::vector<block128>& m_partials;
+			};
+
+			void gcm_compute_tag(unsigned char* tag, size_t tag_len, unsigned char* out, const unsigned char* in, size_t len, const void* aad, size_t aad_len, bool encrypt, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, unsigned int thread_count)
+			{
+				assert(key);
+				assert(iv);
+
+				if (key_len != algorithm.key_length())
+				{
+					throw std::runtime_error("key_len");
+				}
+
+				if (iv_len == 0)
+				{
+					throw std::runtime_error("iv_len");
+				}
+
+				check_tag_length(tag_len);
+
+				// GCM cannot encrypt more than 2^32 - 2 blocks with a single IV.
+				if (static_cast<boost::uint64_t>(len) > ((static_cast<boost::uint64_t>(1) << 32) - 2) * counter_block_size)
+				{
+					throw std::runtime_error("in_len");
+				}
+
+				const EVP_CIPHER* ecb_cipher = detail::get_mode_counterpart(algorithm, "gcm", "ecb");
+				const EVP_CIPHER* ctr_cipher = detail::get_mode_counterpart(algorithm, "gcm", "ctr");
+
+				if (!ecb_cipher || !ctr_cipher)
+				{
+					throw std::runtime_error("algorithm");
+				}
+
+				cipher_context ecb;
+				ecb.initialize(cipher_algorithm(ecb_cipher), cipher_context::encrypt, key, key_len, NULL, 0);
+				ecb.set_padding(false);
+
+				const block128 h = ecb_encrypt_block(ecb, make_block(0, 0));
+
+				block128 j0;
+
+				if (iv_len == 12)
+				{
+					unsigned char buf[counter_block_size] = { 0 };
+					std::memcpy(buf, iv, iv_len);
+					buf[counter_block_size - 1] = 0x01;
+					j0 = load_block(buf);
+				}
+				else
+				{
+					// J0 = GHASH(IV || padding || length block)
+					const unsigned char* civ = static_cast<const unsigned char*>(iv);
+
+					j0 = make_block(0, 0);
+
+					for (size_t i = 0; i < iv_len; i += counter_block_size)
+					{
+						unsigned char buf[counter_block_size] = { 0 };
+						std::memcpy(buf, civ + i, (std::min)(counter_block_size, iv_len - i));
+						j0 = gf_multiply(j0 ^ load_block(buf), h);
+					}
+
+					j0 = gf_multiply(j0 ^ length_block(0, iv_len), h);
+				}
+
+				const block128 mask = ecb_encrypt_block(ecb, make_block(0, 1));
+
+				const boost::uint64_t data_blocks = (len + counter_block_size - 1) / counter_block_size;
+
+				block128 ghash = gf_multiply(length_block(aad_len, len), h);
+
+				if (aad_len > 0)
+				{
+					ghash_accumulator aad_ghash(algorithm, key, key_len);
+					aad_ghash.update(static_cast<const unsigned char*>(aad), aad_len);
+
+					ghash = ghash ^ gf_multiply(aad_ghash.finalize(h, mask), gf_power(h, data_blocks));
+				}
+
+				if (len > 0)
+				{
+					const size_t chunk_size = get_chunk_size(len, thread_count);
+					const size_t chunks_count = (len + chunk_size - 1) / chunk_size;
+
+					std::vector<block128> partials(chunks_count);
+
+					const cipher_algorithm ctr_algorithm(ctr_cipher);
+					gcm_task task(out, in, len, chunk_size, encrypt, algorithm, ctr_algorithm, key, key_len, j0, h, mask, partials);
+
+					detail::parallel_for(chunks_count, thread_count, task);
+
+					for (size_t chunk = 0; chunk < chunks_count; ++chunk)
+					{
+						const boost::uint64_t chunk_end_block = (std::min)(static_cast<boost::uint64_t>(chunk + 1) * (chunk_size / counter_block_size), data_blocks);
+
+						ghash = ghash ^ gf_multiply(partials[chunk], gf_power(h, data_blocks - chunk_end_block));
+					}
+				}
+
+				unsigned char full_tag[counter_block_size];
+				store_block(ecb_encrypt_block(ecb, j0) ^ ghash, full_tag);
+				std::memcpy(tag, full_tag, tag_len);
+			}
+
+#endif
+		}
+
+		size_t parallel_ctr_update(void* out, size_t out_len, const void* in, size_t in_len, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, unsigned int thread_count)
+		{
+			assert(out);
+			assert(in || (in_len == 0));
+			assert(iv);
+
+#ifdef EVP_CIPH_CTR_MODE
+			if (algorithm.mode() != EVP_CIPH_CTR_MODE)
+#endif
+			{
+				throw std::runtime_error("algorithm");
+			}
+
+			if (iv_len != algorithm.iv_length() || (iv_len != counter_block_size))
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			if (out_len < in_len)
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			if (in_len > 0)
+			{
+				const size_t chunk_size = get_chunk_size(in_len, thread_count);
+				ctr_task task(static_cast<unsigned char*>(out), static_cast<const unsigned char*>(in), in_len, chunk_size, algorithm, key, key_len, iv);
+
+				detail::parallel_for((in_len + chunk_size - 1) / chunk_size, thread_count, task);
+			}
+
+			return in_len;
+		}
+
+		size_t parallel_cbc_decrypt(void* out, size_t out_len, const void* in, size_t in_len, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, bool padding, unsigned int thread_count)
+		{
+			assert(out);
+			assert(in || (in_len == 0));
+			assert(iv);
+
+			const size_t block_size = algorithm.block_size();
+
+			if (iv_len != algorithm.iv_length() || (iv_len != block_size))
+			{
+				throw std::runtime_error("iv_len");
+			}
+
+			if ((in_len % block_size) != 0)
+			{
+				throw std::runtime_error("in_len");
+			}
+
+			if (out_len < in_len)
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			if (in_len == 0)
+			{
+				if (padding)
+				{
+					// There must be at least one padding block.
+					throw std::runtime_error("in_len");
+				}
+
+				return 0;
+			}
+
+			const unsigned char* cin = static_cast<const unsigned char*>(in);
+			unsigned char* cout = static_cast<unsigned char*>(out);
+
+			const size_t chunk_size = (std::max)(block_size, get_chunk_size(in_len, thread_count) / block_size * block_size);
+			const size_t chunks_count = (in_len + chunk_size - 1) / chunk_size;
+
+			// Each chunk is chained to the last ciphertext block of the previous one. These blocks must be saved beforehand as the decryption may be done in place.
+			std::vector<unsigned char> ivs(chunks_count * iv_len);
+			std::memcpy(&ivs[0], iv, iv_len);
+
+			for (size_t chunk = 1; chunk < chunks_count; ++chunk)
+			{
+				std::memcpy(&ivs[chunk * iv_len], cin + chunk * chunk_size - block_size, iv_len);
+			}
+
+			std::vector<size_t> results(chunks_count);
+			cbc_decrypt_task task(cout, cin, in_len, chunk_size, padding, algorithm, key, key_len, ivs, results);
+
+			detail::parallel_for(chunks_count, thread_count, task);
+
+			// Only the last chunk may be shorter than its input, because of the padding.
+			return (chunks_count - 1) * chunk_size + results[chunks_count - 1];
+		}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+
+		size_t parallel_gcm_seal(void* out, size_t out_len, const void* in, size_t in_len, const void* aad, size_t aad_len, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, size_t tag_len, unsigned int thread_count)
+		{
+			assert(out);
+			assert(in || (in_len == 0));
+
+			check_tag_length(tag_len);
+
+			if (out_len < in_len + tag_len)
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			unsigned char* cout = static_cast<unsigned char*>(out);
+
+			gcm_compute_tag(cout + in_len, tag_len, cout, static_cast<const unsigned char*>(in), in_len, aad, aad_len, true, algorithm, key, key_len, iv, iv_len, thread_count);
+
+			return in_len + tag_len;
+		}
+
+		bool parallel_gcm_open(void* out, size_t out_len, const void* in, size_t in_len, const void* aad, size_t aad_len, const cipher_algorithm& algorithm, const void* key, size_t key_len, const void* iv, size_t iv_len, size_t tag_len, unsigned int thread_count)
+		{
+			assert(out);
+			assert(in);
+
+			// The tag is copied to a fixed size buffer below.
+			check_tag_length(tag_len);
+
+			if (in_len < tag_len)
+			{
+				return false;
+			}
+
+			const size_t data_len = in_len - tag_len;
+
+			if (out_len < data_len)
+			{
+				throw std::logic_error("The output buffer is too small");
+			}
+
+			const unsigned char* cin = static_cast<const unsigned char*>(in);
+
+			// The expected tag must be saved before the decryption, which may be done in place.
+			unsigned char expected_tag[counter_block_size];
+			std::memcpy(expected_tag, cin + data_len, tag_len);
+
+			unsigned char tag[counter_block_size];
+			gcm_compute_tag(tag, tag_len, static_cast<unsigned char*>(out), cin, data_len, aad, aad_len, false, algorithm, key, key_len, iv, iv_len, thread_count);
+
+			if (CRYPTO_memcmp(tag, expected_tag, tag_len) != 0)
+			{
+				OPENSSL_cleanse(out, data_len);
+
+				return false;
+			}
+
+			return true;
+		}
+
+#endif
+	}
+}
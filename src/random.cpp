@@ -44,9 +44,118 @@
 
 #include "random/random.hpp"
 
+#include <boost/thread/tss.hpp>
+#include <boost/thread/once.hpp>
+
+#include <openssl/crypto.h>
+
+#ifndef WINDOWS
+#include <pthread.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
 namespace cryptoplus
 {
 	namespace random
 	{
+		namespace
+		{
+			// Incremented in the child process after each fork(): the buffers filled before belong to the parent too.
+			unsigned int fork_generation = 0;
+
+			boost::once_flag fork_handler_flag = BOOST_ONCE_INIT;
+
+#ifndef WINDOWS
+			extern "C" void increment_fork_generation()
+			{
+				++fork_generation;
+			}
+#endif
+
+			void register_fork_handler()
+			{
+#ifndef WINDOWS
+				pthread_atfork(NULL, NULL, &increment_fork_generation);
+#endif
+			}
+
+			struct random_buffer
+			{
+				random_buffer() : available(0), generation(fork_generation) {}
+
+				~random_buffer()
+				{
+					OPENSSL_cleanse(data, sizeof(data));
+				}
+
+				unsigned char data[random_buffer_size];
+				size_t available;
+				unsigned int generation;
+			};
+
+			boost::thread_specific_ptr<random_buffer> thread_random_buffer;
+		}
+
+		void get_buffered_random_bytes(void* buf, size_t buf_len)
+		{
+			if (buf_len > random_buffer_size)
+			{
+				get_random_bytes(buf, buf_len);
+
+				return;
+			}
+
+			random_buffer* rb = thread_random_buffer.get();
+
+			if (!rb)
+			{
+				boost::call_once(register_fork_handler, fork_handler_flag);
+
+				rb = new random_buffer();
+				thread_random_buffer.reset(rb);
+			}
+
+			if (rb->generation != fork_generation)
+			{
+				OPENSSL_cleanse(rb->data, sizeof(rb->data));
+				rb->available = 0;
+				rb->generation = fork_generation;
+			}
+
+			unsigned char* out = static_cast<unsigned char*>(buf);
+
+			while (buf_len > 0)
+			{
+				if (rb->available == 0)
+				{
+					get_random_bytes(rb->data, sizeof(rb->data));
+					rb->available = sizeof(rb->data);
+				}
+
+				// Bytes are served from the end of the buffer.
+				const size_t cnt = std::min(buf_len, rb->available);
+				unsigned char* const src = rb->data + rb->available - cnt;
+
+				std::memcpy(out, src, cnt);
+				OPENSSL_cleanse(src, cnt);
+
+				rb->available -= cnt;
+				out += cnt;
+				buf_len -= cnt;
+			}
+		}
+
+		void discard_buffered_random_bytes()
+		{
+			random_buffer* rb = thread_random_buffer.get();
+
+			if (rb)
+			{
+				OPENSSL_cleanse(rb->data, sizeof(rb->data));
+				rb->available = 0;
+			}
+		}
 	}
 }
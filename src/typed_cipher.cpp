@@ -0,0 +1,93 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file typed_cipher.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief Compile-time typed cipher classes.
+ */
+
+#include "cipher/typed_cipher.hpp"
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		const bool aes_128_cbc::aead;
+		const size_t aes_128_cbc::key_length;
+		const size_t aes_128_cbc::iv_length;
+		const size_t aes_128_cbc::block_size;
+
+		const bool aes_256_cbc::aead;
+		const size_t aes_256_cbc::key_length;
+		const size_t aes_256_cbc::iv_length;
+		const size_t aes_256_cbc::block_size;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+		const bool aes_128_ctr::aead;
+		const size_t aes_128_ctr::key_length;
+		const size_t aes_128_ctr::iv_length;
+		const size_t aes_128_ctr::block_size;
+
+		const bool aes_256_ctr::aead;
+		const size_t aes_256_ctr::key_length;
+		const size_t aes_256_ctr::iv_length;
+		const size_t aes_256_ctr::block_size;
+
+		const bool aes_128_gcm::aead;
+		const size_t aes_128_gcm::key_length;
+		const size_t aes_128_gcm::iv_length;
+		const size_t aes_128_gcm::block_size;
+		const size_t aes_128_gcm::tag_length;
+
+		const bool aes_256_gcm::aead;
+		const size_t aes_256_gcm::key_length;
+		const size_t aes_256_gcm::iv_length;
+		const size_t aes_256_gcm::block_size;
+		const size_t aes_256_gcm::tag_length;
+#endif
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000
+		const bool chacha20_poly1305::aead;
+		const size_t chacha20_poly1305::key_length;
+		const size_t chacha20_poly1305::iv_length;
+		const size_t chacha20_poly1305::block_size;
+		const size_t chacha20_poly1305::tag_length;
+#endif
+	}
+}
@@ -0,0 +1,211 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file xts_sector_cipher.cpp
+ * \author Julien KAUFFMANN <julien.kauffmann@freelan.org>
+ * \brief An XTS sector cipher class.
+ */
+
+#include "cipher/xts_sector_cipher.hpp"
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+namespace cryptoplus
+{
+	namespace cipher
+	{
+		namespace
+		{
+			// Requests smaller than this are not worth a thread.
+			const size_t min_chunk_size = 64 * 1024;
+
+			const size_t tweak_size = 16;
+
+			size_t get_chunks_count(size_t sectors_count, size_t sector_size, unsigned int thread_count)
+			{
+				const size_t min_chunk_sectors = (std::max)(static_cast<size_t>(1), min_chunk_size / sector_size);
+
+				return detail::get_thread_count(thread_count, (sectors_count + min_chunk_sectors - 1) / min_chunk_sectors);
+			}
+
+			void cipher_sector(cipher_context& ctx, boost::uint64_t number, unsigned char* data, size_t sector_size)
+			{
+				unsigned char tweak[tweak_size] = {};
+
+				for (size_t b = 0; b < sizeof(number); ++b)
+				{
+					tweak[b] = static_cast<unsigned char>(number >> (8 * b));
+				}
+
+				// Only the tweak is set: the key schedules are kept.
+				error::throw_error_if_not(EVP_CipherInit_ex(&ctx.raw(), NULL, NULL, NULL, tweak, -1) != 0);
+
+				int out_len = 0;
+
+				error::throw_error_if_not(EVP_CipherUpdate(&ctx.raw(), data, &out_len, data, static_cast<int>(sector_size)) != 0);
+			}
+
+			class sectors_task
+			{
+				public:
+
+					sectors_task(const cipher_context& ctx, const xts_sector_cipher::sector* sectors, size_t sectors_count, size_t sector_size, size_t chunks_count) :
+						m_ctx(ctx),
+						m_sectors(sectors),
+						m_sectors_count(sectors_count),
+						m_sector_size(sector_size),
+						m_chunks_count(chunks_count)
+					{
+					}
+
+					void operator()(size_t chunk)
+					{
+						cipher_context ctx;
+						ctx.copy(m_ctx);
+
+						const size_t end = m_sectors_count * (chunk + 1) / m_chunks_count;
+
+						for (size_t i = m_sectors_count * chunk / m_chunks_count; i < end; ++i)
+						{
+							assert(m_sectors[i].data);
+
+							cipher_sector(ctx, m_sectors[i].number, static_cast<unsigned char*>(m_sectors[i].data), m_sector_size);
+						}
+					}
+
+				private:
+
+					const cipher_context& m_ctx;
+					const xts_sector_cipher::sector* m_sectors;
+					size_t m_sectors_count;
+					size_t m_sector_size;
+					size_t m_chunks_count;
+			};
+
+			class buffer_task
+			{
+				public:
+
+					buffer_task(const cipher_context& ctx, boost::uint64_t first_sector, unsigned char* buf, size_t sectors_count, size_t sector_size, size_t chunks_count) :
+						m_ctx(ctx),
+						m_first_sector(first_sector),
+						m_buf(buf),
+						m_sectors_count(sectors_count),
+						m_sector_size(sector_size),
+						m_chunks_count(chunks_count)
+					{
+					}
+
+					void operator()(size_t chunk)
+					{
+						cipher_context ctx;
+						ctx.copy(m_ctx);
+
+						const size_t end = m_sectors_count * (chunk + 1) / m_chunks_count;
+
+						for (size_t i = m_sectors_count * chunk / m_chunks_count; i < end; ++i)
+						{
+							cipher_sector(ctx, m_first_sector + i, m_buf + i * m_sector_size, m_sector_size);
+						}
+					}
+
+				private:
+
+					const cipher_context& m_ctx;
+					boost::uint64_t m_first_sector;
+					unsigned char* m_buf;
+					size_t m_sectors_count;
+					size_t m_sector_size;
+					size_t m_chunks_count;
+			};
+		}
+
+		xts_sector_cipher::xts_sector_cipher(const cipher_algorithm& _algorithm, const void* key, size_t key_len, size_t _sector_size, ENGINE* impl) :
+			m_sector_size(_sector_size)
+		{
+#ifdef EVP_CIPH_XTS_MODE
+			if (_algorithm.mode() != EVP_CIPH_XTS_MODE)
+#endif
+			{
+				throw std::runtime_error("algorithm");
+			}
+
+			if (_sector_size < _algorithm.iv_length())
+			{
+				throw std::runtime_error("sector_size");
+			}
+
+			m_encrypt_ctx.initialize(_algorithm, cipher_context::encrypt, key, key_len, NULL, _algorithm.iv_length(), impl);
+			m_decrypt_ctx.initialize(_algorithm, cipher_context::decrypt, key, key_len, NULL, _algorithm.iv_length(), impl);
+		}
+
+		void xts_sector_cipher::process(const cipher_context& ctx, const sector* sectors, size_t sectors_count, unsigned int thread_count) const
+		{
+			assert(sectors || (sectors_count == 0));
+
+			const size_t chunks_count = get_chunks_count(sectors_count, m_sector_size, thread_count);
+
+			sectors_task task(ctx, sectors, sectors_count, m_sector_size, chunks_count);
+
+			detail::parallel_for(chunks_count, static_cast<unsigned int>(chunks_count), task);
+		}
+
+		void xts_sector_cipher::process(const cipher_context& ctx, boost::uint64_t first_sector, void* buf, size_t buf_len, unsigned int thread_count) const
+		{
+			assert(buf || (buf_len == 0));
+
+			if (buf_len % m_sector_size != 0)
+			{
+				throw std::logic_error("buf_len should be a multiple of sector_size()");
+			}
+
+			const size_t sectors_count = buf_len / m_sector_size;
+			const size_t chunks_count = get_chunks_count(sectors_count, m_sector_size, thread_count);
+
+			buffer_task task(ctx, first_sector, static_cast<unsigned char*>(buf), sectors_count, m_sector_size, chunks_count);
+
+			detail::parallel_for(chunks_count, static_cast<unsigned int>(chunks_count), task);
+		}
+	}
+}
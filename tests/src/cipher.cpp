@@ -0,0 +1,1400 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file cipher.cpp
+ * \author Julien Kauffmann <julien.kauffmann@freelan.org>
+ * \brief The cipher test file.
+ */
+
+#include "cipher.hpp"
+
+#include <cryptoplus/cipher/aead_context.hpp>
+#include <cryptoplus/cipher/cipher_batch.hpp>
+#include <cryptoplus/cipher/parallel_cipher.hpp>
+#include <cryptoplus/cipher/keyed_cipher.hpp>
+#include <cryptoplus/cipher/cipher_stream.hpp>
+#include <cryptoplus/bio/bio_chain.hpp>
+#include <cryptoplus/cipher/chunked_container.hpp>
+#include <cryptoplus/cipher/file_pipeline.hpp>
+#include <cryptoplus/cipher/envelope_session.hpp>
+#include <cryptoplus/cipher/envelope_opener.hpp>
+#include <cryptoplus/pkey/rsa_key.hpp>
+#include <cryptoplus/cipher/padding.hpp>
+#include <cryptoplus/cipher/key_wrap.hpp>
+#include <cryptoplus/cipher/xts_sector_cipher.hpp>
+#include <cryptoplus/cipher/etm_context.hpp>
+#include <cryptoplus/cipher/nonce_source.hpp>
+#include <cryptoplus/cipher/typed_cipher.hpp>
+#include <cryptoplus/random/random.hpp>
+#include <cryptoplus/capabilities.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/function.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+
+#ifndef WINDOWS
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CipherTest);
+
+using namespace cryptoplus::cipher;
+
+namespace
+{
+	cipher_context make_encryption_context(const cipher_algorithm& algorithm, const void* key, size_t key_len)
+	{
+		cipher_context ctx;
+		ctx.initialize(algorithm, cipher_context::encrypt, key, key_len, NULL, 0);
+		ctx.set_padding(false);
+
+		return boost::move(ctx);
+	}
+
+	cryptoplus::file make_temporary_file(const std::vector<unsigned char>& content)
+	{
+		cryptoplus::file result = cryptoplus::file::take_ownership(std::tmpfile());
+
+		if (!content.empty())
+		{
+			CPPUNIT_ASSERT_EQUAL(content.size(), std::fwrite(&content[0], 1, content.size(), result.raw()));
+		}
+
+		std::rewind(result.raw());
+
+		return result;
+	}
+
+	std::vector<unsigned char> gather_buffers(const cipher_stream& stream)
+	{
+		const std::vector<cipher_stream::const_buffer> buffers = stream.buffers();
+
+		std::vector<unsigned char> result;
+
+		for (size_t i = 0; i < buffers.size(); ++i)
+		{
+			result.insert(result.end(), buffers[i].data, buffers[i].data + buffers[i].size);
+		}
+
+		return result;
+	}
+
+	struct sink_recorder
+	{
+		sink_recorder() : calls(0), max_len(0) {}
+
+		std::vector<unsigned char> data;
+		size_t calls;
+		size_t max_len;
+	};
+
+	void record_output(sink_recorder& recorder, const void* buf, size_t buf_len)
+	{
+		const unsigned char* const cbuf = static_cast<const unsigned char*>(buf);
+
+		recorder.data.insert(recorder.data.end(), cbuf, cbuf + buf_len);
+		++recorder.calls;
+		recorder.max_len = std::max(recorder.max_len, buf_len);
+	}
+
+	void throw_output(const void*, size_t)
+	{
+		throw std::runtime_error("sink");
+	}
+
+	std::vector<unsigned char> read_temporary_file(cryptoplus::file file)
+	{
+		std::vector<unsigned char> result;
+		unsigned char buf[4096];
+
+		std::rewind(file.raw());
+
+		for (size_t cnt = std::fread(buf, 1, sizeof(buf), file.raw()); cnt > 0; cnt = std::fread(buf, 1, sizeof(buf), file.raw()))
+		{
+			result.insert(result.end(), buf, buf + cnt);
+		}
+
+		return result;
+	}
+
+	void add_session_key(envelope_opener& opener, const cryptoplus::pkey::pkey& pkey, const envelope_session& session)
+	{
+		opener.add_key(session.key_id(), session.wrapped_key(0), session.wrapped_key_length(0), pkey);
+	}
+
+	std::string seal_and_open(envelope_session& session, const envelope_opener& opener, const std::string& message)
+	{
+		std::vector<unsigned char> sealed(session.max_sealed_size(message.size()));
+		sealed.resize(session.seal(&sealed[0], sealed.size(), message.empty() ? NULL : message.c_str(), message.size()));
+
+		std::vector<unsigned char> opened(sealed.size());
+		opened.resize(opener.open(&opened[0], opened.size(), &sealed[0], sealed.size()));
+
+		return std::string(opened.begin(), opened.end());
+	}
+
+	std::vector<unsigned char> draw_buffered_random_bytes(size_t cnt)
+	{
+		std::vector<unsigned char> result(cnt);
+
+		cryptoplus::random::get_buffered_random_bytes(&result[0], result.size());
+
+		return result;
+	}
+
+#ifndef WINDOWS
+	std::vector<unsigned char> run_in_child_process(boost::function<std::vector<unsigned char> ()> function)
+	{
+		int fds[2];
+
+		CPPUNIT_ASSERT(pipe(fds) == 0);
+
+		const pid_t pid = fork();
+
+		CPPUNIT_ASSERT(pid >= 0);
+
+		if (pid == 0)
+		{
+			close(fds[0]);
+
+			const std::vector<unsigned char> child_result = function();
+			size_t written = 0;
+
+			while (written < child_result.size())
+			{
+				const ssize_t cnt = write(fds[1], &child_result[written], child_result.size() - written);
+
+				if (cnt <= 0)
+				{
+					_exit(1);
+				}
+
+				written += static_cast<size_t>(cnt);
+			}
+
+			_exit(0);
+		}
+
+		close(fds[1]);
+
+		std::vector<unsigned char> result;
+		unsigned char buf[4096];
+
+		for (ssize_t cnt = read(fds[0], buf, sizeof(buf)); cnt > 0; cnt = read(fds[0], buf, sizeof(buf)))
+		{
+			result.insert(result.end(), buf, buf + cnt);
+		}
+
+		close(fds[0]);
+
+		int status = 0;
+
+		CPPUNIT_ASSERT(waitpid(pid, &status, 0) == pid);
+		CPPUNIT_ASSERT(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+		return result;
+	}
+#endif
+}
+
+void CipherTest::setUp()
+{
+}
+
+void CipherTest::tearDown()
+{
+}
+
+void CipherTest::testAEADSealOpen()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+	// NIST GCM specification, test case 2.
+	const unsigned char expected[32] = {
+		0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92, 0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78,
+		0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd, 0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf
+	};
+
+	const std::vector<unsigned char> key(16, 0x00);
+	const std::vector<unsigned char> iv(12, 0x00);
+	const std::vector<unsigned char> plaintext(16, 0x00);
+
+	aead_context encrypt_ctx;
+	encrypt_ctx.initialize(cipher_algorithm(EVP_aes_128_gcm()), cipher_context::encrypt, &key[0], key.size());
+
+	std::vector<unsigned char> sealed(plaintext.size() + encrypt_ctx.tag_length());
+
+	CPPUNIT_ASSERT_EQUAL(sealed.size(), encrypt_ctx.seal(&sealed[0], sealed.size(), &iv[0], iv.size(), NULL, 0, &plaintext[0], plaintext.size()));
+	CPPUNIT_ASSERT(std::memcmp(&sealed[0], expected, sizeof(expected)) == 0);
+
+	aead_context decrypt_ctx;
+	decrypt_ctx.initialize(cipher_algorithm(EVP_aes_128_gcm()), cipher_context::decrypt, &key[0], key.size());
+
+	std::vector<unsigned char> opened(plaintext.size());
+
+	CPPUNIT_ASSERT(decrypt_ctx.open(&opened[0], opened.size(), &iv[0], iv.size(), NULL, 0, &sealed[0], sealed.size()));
+	CPPUNIT_ASSERT(opened == plaintext);
+
+	sealed[0] ^= 0x01;
+
+	CPPUNIT_ASSERT(!decrypt_ctx.open(&opened[0], opened.size(), &iv[0], iv.size(), NULL, 0, &sealed[0], sealed.size()));
+#endif
+}
+
+void CipherTest::testBatch()
+{
+	const char* const names[] = { "AES-128-CBC", "AES-128-CTR" };
+	const size_t lengths[] = { 0, 1, 16, 33, 1500 };
+	const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+
+	for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); ++n)
+	{
+		const cipher_algorithm algorithm(names[n]);
+		const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+
+		std::vector<std::vector<unsigned char> > ivs(count);
+		std::vector<std::vector<unsigned char> > inputs(count);
+		std::vector<std::vector<unsigned char> > outputs(count);
+		std::vector<cipher_batch::message> messages(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			ivs[i].assign(algorithm.iv_length(), static_cast<unsigned char>(0xf0 + i));
+			inputs[i].assign(lengths[i] + 1, static_cast<unsigned char>(i));
+			outputs[i].resize(lengths[i] + algorithm.block_size());
+
+			const cipher_batch::message message = { &ivs[i][0], &inputs[i][0], lengths[i], &outputs[i][0], outputs[i].size(), 0 };
+			messages[i] = message;
+		}
+
+		cipher_batch batch;
+		batch.initialize(algorithm, cipher_context::encrypt, &key[0], key.size());
+		batch.process(messages);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			cipher_context ctx;
+			ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &ivs[i][0], ivs[i].size());
+
+			std::vector<unsigned char> expected(lengths[i] + algorithm.block_size());
+			size_t expected_len = ctx.update(&expected[0], expected.size(), &inputs[i][0], lengths[i]);
+			expected_len += ctx.finalize(&expected[0] + expected_len, expected.size() - expected_len);
+
+			CPPUNIT_ASSERT_EQUAL(expected_len, messages[i].result);
+			CPPUNIT_ASSERT(std::memcmp(&expected[0], &outputs[i][0], expected_len) == 0);
+		}
+	}
+}
+
+void CipherTest::testParallelCTR()
+{
+	const cipher_algorithm algorithm("aes-128-ctr");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const std::vector<unsigned char> iv(algorithm.iv_length(), 0xff);
+
+	std::vector<unsigned char> input(300001);
+
+	for (size_t i = 0; i < input.size(); ++i)
+	{
+		input[i] = static_cast<unsigned char>(i * 7);
+	}
+
+	cipher_context ctx;
+	ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+	std::vector<unsigned char> expected(input.size() + algorithm.block_size());
+	expected.resize(ctx.update(&expected[0], expected.size(), &input[0], input.size()));
+
+	std::vector<unsigned char> output(input.size());
+
+	// The counter carries across the chunk boundaries.
+	CPPUNIT_ASSERT_EQUAL(input.size(), parallel_ctr_update(&output[0], output.size(), &input[0], input.size(), algorithm, &key[0], key.size(), &iv[0], iv.size(), 4));
+	CPPUNIT_ASSERT(output == expected);
+
+	const cipher_algorithm cbc_algorithm("aes-128-cbc");
+
+	CPPUNIT_ASSERT_THROW(parallel_ctr_update(&output[0], output.size(), &input[0], input.size(), cbc_algorithm, &key[0], key.size(), &iv[0], iv.size(), 4), std::runtime_error);
+}
+
+void CipherTest::testParallelGCM()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+	const cipher_algorithm algorithm("aes-128-gcm");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const std::vector<unsigned char> aad(13, 0x17);
+	const size_t iv_lengths[] = { 12, 16 };
+
+	std::vector<unsigned char> input(300001);
+
+	for (size_t i = 0; i < input.size(); ++i)
+	{
+		input[i] = static_cast<unsigned char>(i * 7);
+	}
+
+	for (size_t n = 0; n < sizeof(iv_lengths) / sizeof(iv_lengths[0]); ++n)
+	{
+		const std::vector<unsigned char> iv(iv_lengths[n], 0x42);
+
+		aead_context ctx;
+		ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), iv.size());
+
+		std::vector<unsigned char> expected(input.size() + ctx.tag_length());
+		const size_t expected_len = ctx.seal(&expected[0], expected.size(), &iv[0], iv.size(), &aad[0], aad.size(), &input[0], input.size());
+
+		std::vector<unsigned char> sealed(expected.size());
+		const size_t sealed_len = parallel_gcm_seal(&sealed[0], sealed.size(), &input[0], input.size(), &aad[0], aad.size(), algorithm, &key[0], key.size(), &iv[0], iv.size(), 16, 4);
+
+		CPPUNIT_ASSERT_EQUAL(expected_len, sealed_len);
+		CPPUNIT_ASSERT(sealed == expected);
+
+		std::vector<unsigned char> opened(input.size());
+
+		CPPUNIT_ASSERT(parallel_gcm_open(&opened[0], opened.size(), &sealed[0], sealed_len, &aad[0], aad.size(), algorithm, &key[0], key.size(), &iv[0], iv.size(), 16, 4));
+		CPPUNIT_ASSERT(opened == input);
+
+		sealed[0] ^= 0x01;
+
+		CPPUNIT_ASSERT(!parallel_gcm_open(&opened[0], opened.size(), &sealed[0], sealed_len, &aad[0], aad.size(), algorithm, &key[0], key.size(), &iv[0], iv.size(), 16, 4));
+	}
+
+	const std::vector<unsigned char> iv(12, 0x42);
+	std::vector<unsigned char> buf(input.size() + 32);
+
+	CPPUNIT_ASSERT_THROW(parallel_gcm_seal(&buf[0], buf.size(), &input[0], input.size(), NULL, 0, algorithm, &key[0], key.size(), &iv[0], iv.size(), 17, 4), std::runtime_error);
+	CPPUNIT_ASSERT_THROW(parallel_gcm_open(&buf[0], buf.size(), &input[0], input.size(), NULL, 0, algorithm, &key[0], key.size(), &iv[0], iv.size(), 17, 4), std::runtime_error);
+	CPPUNIT_ASSERT_THROW(parallel_gcm_open(&buf[0], buf.size(), &input[0], input.size(), NULL, 0, algorithm, &key[0], key.size(), &iv[0], iv.size(), 3, 4), std::runtime_error);
+#endif
+}
+
+void CipherTest::testParallelCBCDecrypt()
+{
+	const cipher_algorithm algorithm("aes-128-cbc");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const std::vector<unsigned char> iv(algorithm.iv_length(), 0x42);
+	const size_t input_lengths[] = { 300000, 300001 };
+
+	for (size_t n = 0; n < sizeof(input_lengths) / sizeof(input_lengths[0]); ++n)
+	{
+		std::vector<unsigned char> input(input_lengths[n]);
+
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			input[i] = static_cast<unsigned char>(i * 7);
+		}
+
+		// Only a whole count of blocks can go unpadded.
+		const bool padding = (input.size() % algorithm.block_size() != 0);
+
+		cipher_context encrypt_ctx;
+		encrypt_ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+		encrypt_ctx.set_padding(padding);
+
+		std::vector<unsigned char> ciphertext(input.size() + 2 * algorithm.block_size());
+		size_t ciphertext_len = encrypt_ctx.update(&ciphertext[0], ciphertext.size(), &input[0], input.size());
+		ciphertext_len += encrypt_ctx.finalize(&ciphertext[ciphertext_len], ciphertext.size() - ciphertext_len);
+		ciphertext.resize(ciphertext_len);
+
+		cipher_context decrypt_ctx;
+		decrypt_ctx.initialize(algorithm, cipher_context::decrypt, &key[0], key.size(), &iv[0], iv.size());
+		decrypt_ctx.set_padding(padding);
+
+		std::vector<unsigned char> expected(ciphertext.size() + algorithm.block_size());
+		size_t expected_len = decrypt_ctx.update(&expected[0], expected.size(), &ciphertext[0], ciphertext.size());
+		expected_len += decrypt_ctx.finalize(&expected[expected_len], expected.size() - expected_len);
+		expected.resize(expected_len);
+
+		CPPUNIT_ASSERT(expected == input);
+
+		std::vector<unsigned char> output(ciphertext.size());
+
+		// With 4 threads, the ciphertext is split in 4 chunks.
+		output.resize(parallel_cbc_decrypt(&output[0], output.size(), &ciphertext[0], ciphertext.size(), algorithm, &key[0], key.size(), &iv[0], iv.size(), padding, 4));
+
+		CPPUNIT_ASSERT(output == expected);
+	}
+}
+
+void CipherTest::testKeyedCipher()
+{
+	const cipher_algorithm algorithm("aes-128-cbc");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const std::string plaintext = "The quick brown fox jumps over the lazy dog";
+
+	const keyed_cipher encrypt_cipher(algorithm, cipher_context::encrypt, &key[0], key.size());
+	const keyed_cipher decrypt_cipher(algorithm, cipher_context::decrypt, &key[0], key.size());
+
+	CPPUNIT_ASSERT(encrypt_cipher.direction() == cipher_context::encrypt);
+	CPPUNIT_ASSERT(decrypt_cipher.direction() == cipher_context::decrypt);
+
+	// The same contexts are reused for every message.
+	cipher_context encrypt_ctx;
+	cipher_context decrypt_ctx;
+
+	for (unsigned char n = 0; n < 3; ++n)
+	{
+		const std::vector<unsigned char> iv(algorithm.iv_length(), n);
+
+		cipher_context reference_ctx;
+		reference_ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+		std::vector<unsigned char> expected(plaintext.size() + 2 * algorithm.block_size());
+		size_t expected_len = reference_ctx.update(&expected[0], expected.size(), plaintext.c_str(), plaintext.size());
+		expected_len += reference_ctx.finalize(&expected[expected_len], expected.size() - expected_len);
+		expected.resize(expected_len);
+
+		encrypt_cipher.create_context(encrypt_ctx, &iv[0], iv.size());
+
+		std::vector<unsigned char> ciphertext(expected.size() + algorithm.block_size());
+		size_t ciphertext_len = encrypt_ctx.update(&ciphertext[0], ciphertext.size(), plaintext.c_str(), plaintext.size());
+		ciphertext_len += encrypt_ctx.finalize(&ciphertext[ciphertext_len], ciphertext.size() - ciphertext_len);
+		ciphertext.resize(ciphertext_len);
+
+		CPPUNIT_ASSERT(ciphertext == expected);
+
+		decrypt_cipher.create_context(decrypt_ctx, &iv[0], iv.size());
+
+		std::vector<unsigned char> decrypted(ciphertext.size() + algorithm.block_size());
+		size_t decrypted_len = decrypt_ctx.update(&decrypted[0], decrypted.size(), &ciphertext[0], ciphertext.size());
+		decrypted_len += decrypt_ctx.finalize(&decrypted[decrypted_len], decrypted.size() - decrypted_len);
+
+		CPPUNIT_ASSERT_EQUAL(plaintext, std::string(decrypted.begin(), decrypted.begin() + decrypted_len));
+	}
+
+	cipher_context ctx;
+
+	CPPUNIT_ASSERT_THROW(encrypt_cipher.create_context(ctx, &key[0], algorithm.iv_length() - 1), std::runtime_error);
+}
+
+void CipherTest::testAlgorithmRegistry()
+{
+	// Canonical names, aliases, case variants and unknown names: the lookups must always agree with OpenSSL.
+	const char* const names[] = { "aes-128-cbc", "AES-128-CBC", "Aes-128-Cbc", "aes128", "AES128", "aes-256-gcm", "id-aes256-GCM", "des-ede3-cbc", "des3", "DES3", "unknown-cipher", "" };
+
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+	{
+		const EVP_CIPHER* const cipher = EVP_get_cipherbyname(names[i]);
+
+		if (!cipher)
+		{
+			CPPUNIT_ASSERT_THROW(cipher_algorithm(std::string(names[i])), std::invalid_argument);
+
+			continue;
+		}
+
+		const cipher_algorithm by_name(names[i]);
+		const cipher_algorithm by_type(EVP_CIPHER_nid(cipher));
+		const cipher_algorithm by_pointer(cipher);
+
+		const cipher_algorithm* const algorithms[] = { &by_name, &by_type, &by_pointer };
+
+		for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); ++a)
+		{
+			CPPUNIT_ASSERT(algorithms[a]->raw() == cipher);
+			CPPUNIT_ASSERT_EQUAL(EVP_CIPHER_nid(cipher), algorithms[a]->type());
+			CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(EVP_CIPHER_block_size(cipher)), algorithms[a]->block_size());
+			CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(EVP_CIPHER_key_length(cipher)), algorithms[a]->key_length());
+			CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(EVP_CIPHER_iv_length(cipher)), algorithms[a]->iv_length());
+		}
+	}
+
+	CPPUNIT_ASSERT_THROW(cipher_algorithm(NID_undef), std::invalid_argument);
+}
+
+void CipherTest::testCipherStream()
+{
+	const cipher_algorithm algorithm("aes-128-cbc");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const std::vector<unsigned char> iv(algorithm.iv_length(), 0x17);
+	const size_t block_size = algorithm.block_size();
+
+	// The output of the first three inputs fills the first segment exactly, or crosses into a second one. The last one spans many segments.
+	const size_t sizes[] = { 1, cipher_stream::min_segment_size - 2 * block_size, cipher_stream::min_segment_size - block_size, cipher_stream::min_segment_size - block_size + 1, 3 * 1024 * 1024 + 5 };
+
+	for (size_t n = 0; n < sizeof(sizes) / sizeof(sizes[0]); ++n)
+	{
+		std::vector<unsigned char> input(sizes[n]);
+
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			input[i] = static_cast<unsigned char>(i * 13 + 5);
+		}
+
+		cipher_context ctx;
+		ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+		std::vector<unsigned char> expected(input.size() + block_size);
+		size_t cnt = ctx.update(&expected[0], expected.size(), &input[0], input.size());
+		cnt += ctx.finalize(&expected[cnt], expected.size() - cnt);
+		expected.resize(cnt);
+
+		cipher_stream stream(0);
+
+		// The second pass reuses the segments of the first one.
+		for (size_t pass = 0; pass < 2; ++pass)
+		{
+			stream.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+			if (pass == 0)
+			{
+				stream.append(&input[0], input.size());
+			}
+			else
+			{
+				// Single-byte appends, for the inputs that fit in the first segments.
+				const size_t step = (input.size() > 4 * cipher_stream::min_segment_size) ? 4099 : 1;
+
+				for (size_t offset = 0; offset < input.size(); offset += step)
+				{
+					stream.append(&input[offset], std::min(step, input.size() - offset));
+				}
+			}
+
+			stream.finalize();
+
+			CPPUNIT_ASSERT_EQUAL(expected.size(), stream.size());
+			CPPUNIT_ASSERT(gather_buffers(stream) == expected);
+			CPPUNIT_ASSERT(stream.result() == expected);
+		}
+
+		if (input.size() <= cipher_stream::min_segment_size - block_size)
+		{
+			CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), stream.buffers().size());
+		}
+		else
+		{
+			CPPUNIT_ASSERT(stream.buffers().size() > 1);
+		}
+
+		// And back.
+		cipher_stream decrypt_stream(expected.size());
+		decrypt_stream.initialize(algorithm, cipher_context::decrypt, &key[0], key.size(), &iv[0], iv.size());
+		decrypt_stream.append(&expected[0], expected.size());
+		decrypt_stream.finalize();
+
+		CPPUNIT_ASSERT(gather_buffers(decrypt_stream) == input);
+	}
+}
+
+void CipherTest::testCipherStreamSink()
+{
+	const cipher_algorithm algorithm("aes-128-cbc");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const std::vector<unsigned char> iv(algorithm.iv_length(), 0x17);
+	const size_t scratch_size = 4096;
+
+	std::vector<unsigned char> input(1024 * 1024 + 3);
+
+	for (size_t i = 0; i < input.size(); ++i)
+	{
+		input[i] = static_cast<unsigned char>(i * 13 + 5);
+	}
+
+	cipher_context ctx;
+	ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+	std::vector<unsigned char> expected(input.size() + algorithm.block_size());
+	size_t cnt = ctx.update(&expected[0], expected.size(), &input[0], input.size());
+	cnt += ctx.finalize(&expected[cnt], expected.size() - cnt);
+	expected.resize(cnt);
+
+	{
+		sink_recorder recorder;
+
+		cipher_stream stream(0);
+		stream.set_sink(boost::bind(&record_output, boost::ref(recorder), _1, _2), scratch_size);
+		stream.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+		for (size_t offset = 0; offset < input.size(); offset += 10000)
+		{
+			stream.append(&input[offset], std::min<size_t>(10000, input.size() - offset));
+		}
+
+		// The sink got the output so far, in order, but the last block is only flushed by finalize().
+		CPPUNIT_ASSERT(recorder.data.size() < expected.size());
+		CPPUNIT_ASSERT(std::equal(recorder.data.begin(), recorder.data.end(), expected.begin()));
+
+		stream.finalize();
+
+		CPPUNIT_ASSERT(recorder.data == expected);
+
+		// The stream buffers nothing, and the sink never gets more than the scratch buffer at once.
+		CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), stream.size());
+		CPPUNIT_ASSERT(stream.buffers().empty());
+		CPPUNIT_ASSERT(recorder.max_len <= scratch_size + EVP_MAX_BLOCK_LENGTH);
+		CPPUNIT_ASSERT(recorder.calls >= input.size() / (scratch_size + EVP_MAX_BLOCK_LENGTH));
+	}
+
+	{
+		const cryptoplus::bio::bio_chain chain(BIO_s_mem());
+
+		cipher_stream stream(0);
+		stream.set_sink(chain.first(), scratch_size);
+		stream.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+		stream.append(&input[0], input.size());
+		stream.finalize();
+
+		char* data = NULL;
+		const size_t data_len = chain.first().get_mem_data(data);
+
+		CPPUNIT_ASSERT(std::vector<unsigned char>(data, data + data_len) == expected);
+	}
+
+	{
+		cryptoplus::file f = make_temporary_file(std::vector<unsigned char>());
+
+		cipher_stream stream(0);
+		stream.set_sink(f, scratch_size);
+		stream.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+		stream.append(&input[0], input.size());
+		stream.finalize();
+
+		CPPUNIT_ASSERT(read_temporary_file(f) == expected);
+	}
+
+	{
+		cipher_stream stream(0);
+		stream.set_sink(&throw_output, scratch_size);
+		stream.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+		CPPUNIT_ASSERT_THROW(stream.append(&input[0], input.size()), std::runtime_error);
+
+		// Writing to a read-only memory BIO fails.
+		char read_only_data[16] = { 0 };
+		const cryptoplus::bio::bio_chain read_only_chain(BIO_new_mem_buf(read_only_data, sizeof(read_only_data)));
+
+		stream.set_sink(read_only_chain.first(), scratch_size);
+		stream.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+		CPPUNIT_ASSERT_THROW(stream.append(&input[0], input.size()), cryptoplus::error::cryptographic_exception);
+
+		// Back to buffering the output.
+		stream.set_sink(cipher_stream::sink_type());
+		stream.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+		stream.append(&input[0], input.size());
+		stream.finalize();
+
+		CPPUNIT_ASSERT(gather_buffers(stream) == expected);
+	}
+}
+
+void CipherTest::testChunkedContainer()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+	const cipher_algorithm algorithm("aes-128-gcm");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const size_t chunk_size = 1024;
+
+	std::vector<unsigned char> input(5 * chunk_size - 120);
+
+	for (size_t i = 0; i < input.size(); ++i)
+	{
+		input[i] = static_cast<unsigned char>(i * 7);
+	}
+
+	const chunked_writer writer(algorithm, &key[0], key.size(), chunk_size);
+	const std::vector<unsigned char> sealed = writer.seal<unsigned char>(&input[0], input.size(), 4);
+
+	CPPUNIT_ASSERT_EQUAL(writer.sealed_size(input.size()), sealed.size());
+
+	{
+		chunked_reader reader(algorithm, &key[0], key.size(), &sealed[0], sealed.size());
+
+		CPPUNIT_ASSERT_EQUAL(static_cast<boost::uint64_t>(input.size()), reader.size());
+		CPPUNIT_ASSERT_EQUAL(chunk_size, reader.chunk_size());
+
+		std::vector<unsigned char> output(input.size());
+
+		CPPUNIT_ASSERT_EQUAL(output.size(), reader.read_at(&output[0], output.size(), 0));
+		CPPUNIT_ASSERT(output == input);
+
+		// A read that spans three chunks.
+		std::vector<unsigned char> range(chunk_size + 200);
+
+		CPPUNIT_ASSERT_EQUAL(range.size(), reader.read_at(&range[0], range.size(), chunk_size - 100));
+		CPPUNIT_ASSERT(std::equal(range.begin(), range.end(), input.begin() + chunk_size - 100));
+
+		// Reads are truncated at the end of the plaintext.
+		CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(10), reader.read_at(&range[0], range.size(), input.size() - 10));
+		CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), reader.read_at(&range[0], range.size(), input.size()));
+		CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), reader.read_at(&range[0], range.size(), input.size() + chunk_size));
+	}
+
+#ifndef WINDOWS
+	{
+		// A child process created by fork() shares the writer, but not its nonces.
+		std::vector<unsigned char> (chunked_writer::*seal)(const void*, size_t, unsigned int) const = &chunked_writer::seal<unsigned char>;
+
+		const std::vector<unsigned char> child_sealed = run_in_child_process(boost::bind(seal, boost::cref(writer), &input[0], input.size(), 1));
+		const std::vector<unsigned char> parent_sealed = writer.seal<unsigned char>(&input[0], input.size(), 1);
+
+		CPPUNIT_ASSERT_EQUAL(sealed.size(), child_sealed.size());
+		CPPUNIT_ASSERT_EQUAL(sealed.size(), parent_sealed.size());
+
+		const size_t sealed_chunk_size = chunked_container::nonce_size + chunk_size + chunked_container::tag_size;
+
+		for (size_t offset = chunked_container::header_size; offset < sealed.size(); offset += sealed_chunk_size)
+		{
+			CPPUNIT_ASSERT(!std::equal(&child_sealed[offset], &child_sealed[offset] + chunked_container::nonce_size, &parent_sealed[offset]));
+		}
+
+		chunked_reader reader(algorithm, &key[0], key.size(), &child_sealed[0], child_sealed.size());
+
+		std::vector<unsigned char> output(input.size());
+
+		CPPUNIT_ASSERT_EQUAL(output.size(), reader.read_at(&output[0], output.size(), 0));
+		CPPUNIT_ASSERT(output == input);
+	}
+#endif
+
+	{
+		const std::vector<unsigned char> empty = writer.seal<unsigned char>(NULL, 0);
+
+		CPPUNIT_ASSERT_EQUAL(writer.sealed_size(0), empty.size());
+
+		chunked_reader reader(algorithm, &key[0], key.size(), &empty[0], empty.size());
+
+		unsigned char buf[16];
+
+		CPPUNIT_ASSERT_EQUAL(static_cast<boost::uint64_t>(0), reader.size());
+		CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), reader.read_at(buf, sizeof(buf), 0));
+	}
+
+	std::vector<unsigned char> output(input.size());
+
+	{
+		// Swap the first two chunks.
+		std::vector<unsigned char> tampered = sealed;
+		const size_t sealed_chunk_size = chunked_container::nonce_size + chunk_size + chunked_container::tag_size;
+
+		std::swap_ranges(tampered.begin() + chunked_container::header_size, tampered.begin() + chunked_container::header_size + sealed_chunk_size, tampered.begin() + chunked_container::header_size + sealed_chunk_size);
+
+		chunked_reader reader(algorithm, &key[0], key.size(), &tampered[0], tampered.size());
+
+		CPPUNIT_ASSERT_THROW(reader.read_at(&output[0], chunk_size, 0), std::runtime_error);
+		CPPUNIT_ASSERT_THROW(reader.read_at(&output[0], chunk_size, chunk_size), std::runtime_error);
+	}
+
+	{
+		// Truncate the last chunk.
+		const std::vector<unsigned char> tampered(sealed.begin(), sealed.end() - 1);
+
+		chunked_reader reader(algorithm, &key[0], key.size(), &tampered[0], tampered.size());
+
+		CPPUNIT_ASSERT_THROW(reader.read_at(&output[0], output.size(), 0), std::runtime_error);
+	}
+
+	// A reserved header byte and the last byte of the plaintext size.
+	const size_t header_offsets[] = { 5, 19 };
+
+	for (size_t n = 0; n < sizeof(header_offsets) / sizeof(header_offsets[0]); ++n)
+	{
+		std::vector<unsigned char> tampered = sealed;
+		tampered[header_offsets[n]] ^= 0x01;
+
+		chunked_reader reader(algorithm, &key[0], key.size(), &tampered[0], tampered.size());
+
+		CPPUNIT_ASSERT_THROW(reader.read_at(&output[0], output.size(), 0), std::runtime_error);
+	}
+#endif
+}
+
+void CipherTest::testFilePipeline()
+{
+	const cipher_algorithm algorithm("aes-128-cbc");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const std::vector<unsigned char> iv(algorithm.iv_length(), 0x42);
+	const size_t input_lengths[] = { 0, 100, 300001 };
+
+	// Small buffers, so that the input spans many of them.
+	file_pipeline pipeline(4096, 3);
+
+	for (size_t n = 0; n < sizeof(input_lengths) / sizeof(input_lengths[0]); ++n)
+	{
+		std::vector<unsigned char> input(input_lengths[n]);
+
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			input[i] = static_cast<unsigned char>(i * 7);
+		}
+
+		cipher_context reference_ctx;
+		reference_ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+		std::vector<unsigned char> expected(input.size() + 2 * algorithm.block_size());
+		size_t expected_len = input.empty() ? 0 : reference_ctx.update(&expected[0], expected.size(), &input[0], input.size());
+		expected_len += reference_ctx.finalize(&expected[expected_len], expected.size() - expected_len);
+		expected.resize(expected_len);
+
+		cipher_context encrypt_ctx;
+		encrypt_ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+		const cryptoplus::file ciphertext = make_temporary_file(std::vector<unsigned char>());
+
+		CPPUNIT_ASSERT_EQUAL(static_cast<boost::uint64_t>(expected.size()), pipeline.run(encrypt_ctx, make_temporary_file(input), ciphertext));
+		CPPUNIT_ASSERT(read_temporary_file(ciphertext) == expected);
+
+		cipher_context decrypt_ctx;
+		decrypt_ctx.initialize(algorithm, cipher_context::decrypt, &key[0], key.size(), &iv[0], iv.size());
+
+		const cryptoplus::file decrypted = make_temporary_file(std::vector<unsigned char>());
+
+		std::rewind(ciphertext.raw());
+
+		CPPUNIT_ASSERT_EQUAL(static_cast<boost::uint64_t>(input.size()), pipeline.run(decrypt_ctx, ciphertext, decrypted));
+		CPPUNIT_ASSERT(read_temporary_file(decrypted) == input);
+	}
+}
+
+void CipherTest::testSealInitialize()
+{
+	const cipher_algorithm algorithm("aes-128-cbc");
+	const std::string message = "The quick brown fox jumps over the lazy dog";
+
+	// Keys of different sizes, so that the wrapped keys do not all have the same offset pattern.
+	const int bits[] = { 1024, 1536, 1024, 2048, 1024 };
+	const size_t pkeys_count = sizeof(bits) / sizeof(bits[0]);
+
+	std::vector<cryptoplus::pkey::pkey> pkeys;
+
+	for (size_t i = 0; i < pkeys_count; ++i)
+	{
+		pkeys.push_back(cryptoplus::pkey::pkey::from_rsa_key(cryptoplus::pkey::rsa_key::generate_private_key(bits[i], 17)));
+	}
+
+	const size_t ek_len = cipher_context::seal_arena_size(&pkeys[0], pkeys.size());
+
+	{
+		std::vector<unsigned char> iv(algorithm.iv_length());
+		std::vector<unsigned char> ek(ek_len - 1);
+		std::vector<size_t> ekl(pkeys.size());
+
+		cipher_context ctx;
+
+		CPPUNIT_ASSERT_THROW(ctx.seal_initialize(algorithm, &iv[0], iv.size(), &pkeys[0], pkeys.size(), &ek[0], ek.size(), &ekl[0]), std::logic_error);
+	}
+
+	const unsigned int thread_counts[] = { 1, 4 };
+
+	for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); ++t)
+	{
+		std::vector<unsigned char> iv(algorithm.iv_length());
+		std::vector<unsigned char> ek(ek_len);
+		std::vector<size_t> ekl(pkeys.size());
+
+		cipher_context ctx;
+		ctx.seal_initialize(algorithm, &iv[0], iv.size(), &pkeys[0], pkeys.size(), &ek[0], ek.size(), &ekl[0], thread_counts[t]);
+
+		std::vector<unsigned char> sealed(message.size() + algorithm.block_size());
+		size_t cnt = ctx.seal_update(&sealed[0], sealed.size(), message.c_str(), message.size());
+		cnt += ctx.seal_finalize(&sealed[cnt], sealed.size() - cnt);
+		sealed.resize(cnt);
+
+		// Each recipient opens the envelope with its own wrapped key, as EVP_SealInit() would have written it.
+		for (size_t i = 0; i < pkeys.size(); ++i)
+		{
+			const size_t offset = cipher_context::seal_arena_size(&pkeys[0], i);
+
+			CPPUNIT_ASSERT(ekl[i] > 0);
+			CPPUNIT_ASSERT(ekl[i] <= pkeys[i].size());
+
+			cipher_context open_ctx;
+
+			CPPUNIT_ASSERT(EVP_OpenInit(&open_ctx.raw(), algorithm.raw(), &ek[offset], static_cast<int>(ekl[i]), &iv[0], const_cast<EVP_PKEY*>(pkeys[i].raw())) > 0);
+
+			std::vector<unsigned char> opened(sealed.size() + algorithm.block_size());
+			size_t opened_len = open_ctx.open_update(&opened[0], opened.size(), &sealed[0], sealed.size());
+			opened_len += open_ctx.open_finalize(&opened[opened_len], opened.size() - opened_len);
+
+			CPPUNIT_ASSERT_EQUAL(message, std::string(opened.begin(), opened.begin() + opened_len));
+		}
+	}
+}
+
+void CipherTest::testEnvelopeSession()
+{
+	const cipher_algorithm algorithm("aes-128-cbc");
+	const cryptoplus::pkey::pkey pkey = cryptoplus::pkey::pkey::from_rsa_key(cryptoplus::pkey::rsa_key::generate_private_key(1024, 17));
+	const std::string message = "The quick brown fox jumps over the lazy dog";
+
+	envelope_opener opener(algorithm);
+
+	// The data key is rotated every two messages. The rotation handler also gets the first data key.
+	envelope_session session(algorithm, &pkey, 1, 2, 0, 0, boost::bind(&add_session_key, boost::ref(opener), boost::cref(pkey), _1));
+
+	const envelope_session::key_id_type first_key_id = session.key_id();
+
+	CPPUNIT_ASSERT(opener.has_key(first_key_id));
+
+	CPPUNIT_ASSERT_EQUAL(message, seal_and_open(session, opener, message));
+	CPPUNIT_ASSERT_EQUAL(std::string(), seal_and_open(session, opener, std::string()));
+	CPPUNIT_ASSERT_EQUAL(static_cast<boost::uint64_t>(2), session.messages_count());
+	CPPUNIT_ASSERT(session.needs_rotation());
+
+	std::vector<unsigned char> sealed(session.max_sealed_size(message.size()));
+	sealed.resize(session.seal(&sealed[0], sealed.size(), message.c_str(), message.size()));
+
+	CPPUNIT_ASSERT(session.key_id() != first_key_id);
+	CPPUNIT_ASSERT_EQUAL(static_cast<boost::uint64_t>(1), session.messages_count());
+	CPPUNIT_ASSERT(opener.has_key(first_key_id));
+	CPPUNIT_ASSERT(opener.has_key(session.key_id()));
+
+	std::vector<unsigned char> opened(sealed.size());
+	opened.resize(opener.open(&opened[0], opened.size(), &sealed[0], sealed.size()));
+
+	CPPUNIT_ASSERT_EQUAL(message, std::string(opened.begin(), opened.end()));
+
+	// An opener that does not know the data key.
+	const envelope_opener other_opener(algorithm);
+
+	opened.resize(sealed.size());
+
+	CPPUNIT_ASSERT_THROW(other_opener.open(&opened[0], opened.size(), &sealed[0], sealed.size()), std::runtime_error);
+
+	opener.remove_key(session.key_id());
+
+	CPPUNIT_ASSERT_THROW(opener.open(&opened[0], opened.size(), &sealed[0], sealed.size()), std::runtime_error);
+}
+
+void CipherTest::testISO10126Padding()
+{
+	const cipher_algorithm algorithm("aes-128-cbc");
+	const std::vector<unsigned char> key(algorithm.key_length(), 0x2a);
+	const std::vector<unsigned char> iv(algorithm.iv_length(), 0x17);
+	const size_t block_size = algorithm.block_size();
+
+	cipher_context ctx;
+	ctx.initialize(algorithm, cipher_context::encrypt, &key[0], key.size(), &iv[0], iv.size());
+
+	// Enough buffers for the padding bytes to span several random draws.
+	const size_t count = 1000;
+	const size_t max_buf_len = 4 * block_size;
+
+	std::vector<unsigned char> data(count * max_buf_len);
+	std::vector<void*> bufs(count);
+	std::vector<const void*> const_bufs(count);
+	std::vector<size_t> buf_lens(count);
+	std::vector<size_t> max_buf_lens(count, max_buf_len);
+	std::vector<size_t> results(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		bufs[i] = &data[i * max_buf_len];
+		const_bufs[i] = bufs[i];
+		buf_lens[i] = i % (3 * block_size);
+	}
+
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<unsigned char>(i * 13 + 5);
+	}
+
+	const std::vector<unsigned char> original = data;
+
+	{
+		// No buffer is padded if one of them is too small.
+		std::vector<size_t> small_max_buf_lens = max_buf_lens;
+		small_max_buf_lens[count - 1] = buf_lens[count - 1];
+
+		CPPUNIT_ASSERT_THROW(ctx.add_iso_10126_padding(&bufs[0], &buf_lens[0], &small_max_buf_lens[0], &results[0], count), std::logic_error);
+		CPPUNIT_ASSERT(data == original);
+	}
+
+	ctx.add_iso_10126_padding(&bufs[0], &buf_lens[0], &max_buf_lens[0], &results[0], count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		CPPUNIT_ASSERT_EQUAL((buf_lens[i] / block_size + 1) * block_size, results[i]);
+		CPPUNIT_ASSERT(std::equal(&data[i * max_buf_len], &data[i * max_buf_len] + buf_lens[i], &original[i * max_buf_len]));
+		CPPUNIT_ASSERT_EQUAL(buf_lens[i], ctx.verify_iso_10126_padding(bufs[i], results[i]));
+	}
+
+	std::vector<size_t> lengths(count);
+
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), verify_padding(iso_10126_padding, block_size, &const_bufs[0], &results[0], &lengths[0], count));
+	CPPUNIT_ASSERT(lengths == buf_lens);
+}
+
+void CipherTest::testBufferedRandom()
+{
+	using cryptoplus::random::random_buffer_size;
+
+	// Requests around and above the buffer size, some of which span a refill of the buffer.
+	const size_t sizes[] = { 1, 3000, 3000, random_buffer_size - 1, random_buffer_size, random_buffer_size + 1, 3 * random_buffer_size + 5 };
+
+	std::vector<unsigned char> previous;
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		const std::vector<unsigned char> bytes = draw_buffered_random_bytes(sizes[i]);
+
+		CPPUNIT_ASSERT_EQUAL(sizes[i], bytes.size());
+
+		if (bytes.size() >= 64)
+		{
+			// The whole request is filled: about one byte in 256 is zero.
+			CPPUNIT_ASSERT(static_cast<size_t>(std::count(bytes.begin(), bytes.end(), 0)) < bytes.size() / 32 + 4);
+		}
+
+		CPPUNIT_ASSERT(bytes != previous);
+
+		previous = bytes;
+	}
+
+#ifndef WINDOWS
+	// The buffer of the calling thread is filled before fork(): the child must not serve the same bytes.
+	draw_buffered_random_bytes(1);
+
+	const std::vector<unsigned char> child_bytes = run_in_child_process(boost::bind(&draw_buffered_random_bytes, 64));
+	const std::vector<unsigned char> parent_bytes = draw_buffered_random_bytes(64);
+
+	CPPUNIT_ASSERT_EQUAL(parent_bytes.size(), child_bytes.size());
+	CPPUNIT_ASSERT(parent_bytes != child_bytes);
+#endif
+}
+
+void CipherTest::testVerifyPadding()
+{
+	const unsigned char valid[16] = { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 4, 4, 4, 4 };
+	const unsigned char random[16] = { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 9, 1, 7, 4 };
+	const unsigned char too_long[16] = { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 17, 17, 17, 17 };
+	const unsigned char empty[16] = { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 4, 4, 4, 0 };
+
+	const void* const bufs[5] = { valid, random, too_long, empty, valid };
+	const size_t buf_lens[5] = { 16, 16, 16, 16, 15 };
+	size_t results[5];
+
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), verify_padding(pkcs7_padding, 16, bufs, buf_lens, results, 5));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(12), results[0]);
+	CPPUNIT_ASSERT_EQUAL(invalid_padding, results[1]);
+	CPPUNIT_ASSERT_EQUAL(invalid_padding, results[2]);
+	CPPUNIT_ASSERT_EQUAL(invalid_padding, results[3]);
+	CPPUNIT_ASSERT_EQUAL(invalid_padding, results[4]);
+
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), verify_padding(iso_10126_padding, 16, bufs, buf_lens, results, 5));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(12), results[0]);
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(12), results[1]);
+
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), verify_padding(pkcs7_padding, 8, bufs, buf_lens, results, 2));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(12), results[0]);
+	CPPUNIT_ASSERT_EQUAL(invalid_padding, results[1]);
+}
+
+void CipherTest::testKeyWrap()
+{
+	// RFC 3394, section 4.1.
+	const unsigned char kek[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+	const unsigned char key[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+	const unsigned char expected[24] = { 0x1f, 0xa6, 0x8b, 0x0a, 0x81, 0x12, 0xb4, 0x47, 0xae, 0xf3, 0x4b, 0xd8, 0xfb, 0x5a, 0x7b, 0x82, 0x9d, 0x3e, 0x86, 0x23, 0x71, 0xd2, 0xcf, 0xe5 };
+
+	// RFC 5649, section 6.
+	const unsigned char kwp_kek[24] = { 0x58, 0x40, 0xdf, 0x6e, 0x29, 0xb0, 0x2a, 0xf1, 0xab, 0x49, 0x3b, 0x70, 0x5b, 0xf1, 0x6e, 0xa1, 0xae, 0x83, 0x38, 0xf4, 0xdc, 0xc1, 0x76, 0xa8 };
+	const unsigned char kwp_key[7] = { 0x46, 0x6f, 0x72, 0x50, 0x61, 0x73, 0x69 };
+	const unsigned char kwp_expected[16] = { 0xaf, 0xbe, 0xb0, 0xf0, 0x7d, 0xfb, 0xf5, 0x41, 0x92, 0x00, 0xf2, 0xcc, 0xb5, 0x0b, 0xb2, 0x4f };
+
+	key_wrap kw(kek, sizeof(kek), key_wrap::rfc3394);
+	key_wrap kwp(kwp_kek, sizeof(kwp_kek), key_wrap::rfc5649);
+
+	unsigned char wrapped[2][24];
+	unsigned char unwrapped[2][16];
+
+	key_wrap::message messages[2] = {
+		{ key, sizeof(key), wrapped[0], sizeof(wrapped[0]), 0 },
+		{ key, sizeof(key), wrapped[1], sizeof(wrapped[1]), 0 }
+	};
+
+	kw.wrap(messages, 2);
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(expected), messages[0].result);
+	CPPUNIT_ASSERT(std::memcmp(wrapped[0], expected, sizeof(expected)) == 0);
+	CPPUNIT_ASSERT(std::memcmp(wrapped[1], expected, sizeof(expected)) == 0);
+
+	wrapped[1][0] ^= 0x01;
+
+	key_wrap::message unwrap_messages[2] = {
+		{ wrapped[0], sizeof(wrapped[0]), unwrapped[0], sizeof(unwrapped[0]), 0 },
+		{ wrapped[1], sizeof(wrapped[1]), unwrapped[1], sizeof(unwrapped[1]), 0 }
+	};
+
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), kw.unwrap(unwrap_messages, 2));
+	CPPUNIT_ASSERT_EQUAL(sizeof(key), unwrap_messages[0].result);
+	CPPUNIT_ASSERT(std::memcmp(unwrapped[0], key, sizeof(key)) == 0);
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), unwrap_messages[1].result);
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(kwp_expected), kwp.wrap(wrapped[0], sizeof(wrapped[0]), kwp_key, sizeof(kwp_key)));
+	CPPUNIT_ASSERT(std::memcmp(wrapped[0], kwp_expected, sizeof(kwp_expected)) == 0);
+	CPPUNIT_ASSERT_EQUAL(sizeof(kwp_key), kwp.unwrap(unwrapped[0], sizeof(unwrapped[0]), kwp_expected, sizeof(kwp_expected)));
+	CPPUNIT_ASSERT(std::memcmp(unwrapped[0], kwp_key, sizeof(kwp_key)) == 0);
+}
+
+void CipherTest::testXTSSectorCipher()
+{
+#ifdef EVP_CIPH_XTS_MODE
+	// IEEE P1619/D16, annex B, vector 2.
+	const unsigned char key[32] = {
+		0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22
+	};
+	const boost::uint64_t number = (static_cast<boost::uint64_t>(0x33) << 32) | 0x33333333;
+	const unsigned char expected[32] = {
+		0xc4, 0x54, 0x18, 0x5e, 0x6a, 0x16, 0x93, 0x6e, 0x39, 0x33, 0x40, 0x38, 0xac, 0xef, 0x83, 0x8b,
+		0xfb, 0x18, 0x6f, 0xff, 0x74, 0x80, 0xad, 0xc4, 0x28, 0x93, 0x82, 0xec, 0xd6, 0xd3, 0x94, 0xf0
+	};
+
+	const cipher_algorithm algorithm(EVP_aes_128_xts());
+	const std::vector<unsigned char> plaintext(sizeof(expected), 0x44);
+
+	{
+		const xts_sector_cipher xts(algorithm, key, sizeof(key), sizeof(expected));
+
+		std::vector<unsigned char> buf = plaintext;
+		xts_sector_cipher::sector sector = { number, &buf[0] };
+
+		xts.encrypt(&sector, 1);
+		CPPUNIT_ASSERT(std::memcmp(&buf[0], expected, sizeof(expected)) == 0);
+
+		xts.decrypt(&sector, 1);
+		CPPUNIT_ASSERT(buf == plaintext);
+
+		xts.encrypt(number, &buf[0], buf.size());
+		CPPUNIT_ASSERT(std::memcmp(&buf[0], expected, sizeof(expected)) == 0);
+
+		xts.decrypt(number, &buf[0], buf.size());
+		CPPUNIT_ASSERT(buf == plaintext);
+	}
+
+	{
+		// 64 sectors of 4 KiB are split in 4 chunks of 64 KiB, ciphered by as many threads.
+		const xts_sector_cipher xts(algorithm, key, sizeof(key));
+		const size_t sectors_count = 64;
+
+		std::vector<unsigned char> input(sectors_count * xts.sector_size());
+
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			input[i] = static_cast<unsigned char>(i * 7);
+		}
+
+		std::vector<unsigned char> reference = input;
+
+		for (size_t i = 0; i < sectors_count; ++i)
+		{
+			xts.encrypt(number + i, &reference[i * xts.sector_size()], xts.sector_size(), 1);
+		}
+
+		std::vector<unsigned char> buf = input;
+
+		xts.encrypt(number, &buf[0], buf.size(), 4);
+		CPPUNIT_ASSERT(buf == reference);
+
+		xts.decrypt(number, &buf[0], buf.size(), 4);
+		CPPUNIT_ASSERT(buf == input);
+
+		// The same sectors, in reverse order.
+		std::vector<xts_sector_cipher::sector> sectors(sectors_count);
+
+		for (size_t i = 0; i < sectors_count; ++i)
+		{
+			sectors[i].number = number + sectors_count - 1 - i;
+			sectors[i].data = &buf[(sectors_count - 1 - i) * xts.sector_size()];
+		}
+
+		xts.encrypt(&sectors[0], sectors.size(), 4);
+		CPPUNIT_ASSERT(buf == reference);
+
+		xts.decrypt(&sectors[0], sectors.size(), 4);
+		CPPUNIT_ASSERT(buf == input);
+	}
+#endif
+}
+
+void CipherTest::testEncryptThenMAC()
+{
+	// RFC 7518, appendix B.1 (AES_128_CBC_HMAC_SHA_256).
+	const unsigned char mac_key[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+	const unsigned char key[16] = { 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f };
+	const unsigned char iv[16] = { 0x1a, 0xf3, 0x8c, 0x2d, 0xc2, 0xb9, 0x6f, 0xfd, 0xd8, 0x66, 0x94, 0x09, 0x23, 0x41, 0xbc, 0x04 };
+	const unsigned char expected_tag[16] = { 0x65, 0x2c, 0x3f, 0xa3, 0x6b, 0x0a, 0x7c, 0x5b, 0x32, 0x19, 0xfa, 0xb3, 0xa3, 0x0b, 0xc1, 0xc4 };
+	const std::string plaintext = "A cipher system must not be required to be secret, and it must be able to fall into the hands of the enemy without inconvenience";
+	const std::string aad = "The second principle of Auguste Kerckhoffs";
+
+	const cipher_algorithm algorithm(EVP_aes_128_cbc());
+	const cryptoplus::hash::message_digest_algorithm mac_algorithm(EVP_sha256());
+
+	etm_context encrypt_ctx;
+	encrypt_ctx.initialize(algorithm, cipher_context::encrypt, key, sizeof(key), mac_algorithm, mac_key, sizeof(mac_key), 16);
+
+	std::vector<unsigned char> sealed(encrypt_ctx.max_sealed_size(plaintext.size()));
+	const size_t sealed_len = encrypt_ctx.seal(&sealed[0], sealed.size(), iv, sizeof(iv), aad.c_str(), aad.size(), plaintext.c_str(), plaintext.size());
+
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(144 + 16), sealed_len);
+	CPPUNIT_ASSERT(std::memcmp(&sealed[144], expected_tag, sizeof(expected_tag)) == 0);
+
+	etm_context decrypt_ctx;
+	decrypt_ctx.initialize(algorithm, cipher_context::decrypt, key, sizeof(key), mac_algorithm, mac_key, sizeof(mac_key), 16);
+
+	std::vector<unsigned char> opened(sealed_len + algorithm.block_size());
+	size_t opened_len = 0;
+
+	CPPUNIT_ASSERT(decrypt_ctx.open(&opened[0], opened.size(), iv, sizeof(iv), aad.c_str(), aad.size(), &sealed[0], sealed_len, opened_len));
+	CPPUNIT_ASSERT_EQUAL(plaintext.size(), opened_len);
+	CPPUNIT_ASSERT(std::memcmp(&opened[0], plaintext.c_str(), opened_len) == 0);
+
+	sealed[0] ^= 0x01;
+
+	CPPUNIT_ASSERT(!decrypt_ctx.open(&opened[0], opened.size(), iv, sizeof(iv), aad.c_str(), aad.size(), &sealed[0], sealed_len, opened_len));
+}
+
+void CipherTest::testAEADRanking()
+{
+	const std::vector<cryptoplus::aead_score>& ranking = cryptoplus::get_aead_ranking();
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+	CPPUNIT_ASSERT(!ranking.empty());
+#endif
+
+	for (size_t i = 1; i < ranking.size(); ++i)
+	{
+		CPPUNIT_ASSERT(ranking[i - 1].bytes_per_second >= ranking[i].bytes_per_second);
+	}
+
+	if (!ranking.empty())
+	{
+		CPPUNIT_ASSERT(cryptoplus::get_fastest_aead_algorithm(16).key_length() >= 16);
+		CPPUNIT_ASSERT(cryptoplus::get_fastest_aead_algorithm(32).key_length() >= 32);
+	}
+
+	CPPUNIT_ASSERT_THROW(cryptoplus::get_fastest_aead_algorithm(64), std::runtime_error);
+}
+
+void CipherTest::testNonceSource()
+{
+	const unsigned char fixed[4] = { 0x01, 0x02, 0x03, 0x04 };
+
+	nonce_source deterministic(fixed, sizeof(fixed));
+
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(12), deterministic.nonce_length());
+
+	unsigned char nonces[3][12];
+	deterministic.generate(nonces, sizeof(nonces[0]), 3);
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		CPPUNIT_ASSERT(std::memcmp(nonces[i], fixed, sizeof(fixed)) == 0);
+	}
+
+	// The counters are consecutive, big-endian.
+	for (size_t i = 1; i < 3; ++i)
+	{
+		unsigned char expected[8];
+		std::memcpy(expected, nonces[i - 1] + 4, sizeof(expected));
+
+		for (size_t j = sizeof(expected); (j > 0) && (++expected[j - 1] == 0); --j) {}
+
+		CPPUNIT_ASSERT(std::memcmp(nonces[i] + 4, expected, sizeof(expected)) == 0);
+	}
+
+	CPPUNIT_ASSERT_THROW(deterministic.generate(nonces[0], 8), std::runtime_error);
+
+	nonce_source random_source(nonce_source::random_nonce, 16);
+	const std::vector<unsigned char> first = random_source.generate<unsigned char>();
+	const std::vector<unsigned char> second = random_source.generate<unsigned char>();
+
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(16), first.size());
+	CPPUNIT_ASSERT(first != second);
+}
+
+void CipherTest::testMoveContext()
+{
+	// FIPS-197, appendix C.1.
+	const unsigned char key[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+	const unsigned char plaintext[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+	const unsigned char expected[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+	cipher_context ctx(make_encryption_context(cipher_algorithm(EVP_aes_128_ecb()), key, sizeof(key)));
+
+	cipher_context other;
+	other = boost::move(ctx);
+
+	unsigned char ciphertext[32];
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(expected), other.update(ciphertext, sizeof(ciphertext), plaintext, sizeof(plaintext)));
+	CPPUNIT_ASSERT(std::memcmp(ciphertext, expected, sizeof(expected)) == 0);
+}
+
+void CipherTest::testTypedCipher()
+{
+	// NIST SP 800-38A, F.2.1 (first block).
+	const typed_cipher<aes_128_cbc>::key_type key = {{ 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c }};
+	const typed_cipher<aes_128_cbc>::iv_type iv = {{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f }};
+	const unsigned char plaintext[16] = { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a };
+	const unsigned char expected[16] = { 0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d };
+
+	typed_cipher<aes_128_cbc> cbc(cipher_context::encrypt, key, iv);
+	cbc.context().set_padding(false);
+
+	unsigned char ciphertext[16 + typed_cipher<aes_128_cbc>::block_size];
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(expected), cbc.update(ciphertext, sizeof(ciphertext), plaintext, sizeof(plaintext)));
+	CPPUNIT_ASSERT(std::memcmp(ciphertext, expected, sizeof(expected)) == 0);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+	typedef typed_cipher<aes_256_gcm> gcm_type;
+
+	gcm_type::key_type gcm_key;
+	gcm_type::iv_type gcm_iv;
+	gcm_key.assign(0x42);
+	gcm_iv.assign(0x24);
+
+	gcm_type encrypt_gcm(cipher_context::encrypt, gcm_key);
+	gcm_type decrypt_gcm(cipher_context::decrypt, gcm_key);
+
+	unsigned char sealed[sizeof(plaintext) + gcm_type::tag_length];
+	unsigned char opened[sizeof(plaintext)];
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(sealed), encrypt_gcm.seal(sealed, sizeof(sealed), gcm_iv, NULL, 0, plaintext, sizeof(plaintext)));
+	CPPUNIT_ASSERT(decrypt_gcm.open(opened, sizeof(opened), gcm_iv, NULL, 0, sealed, sizeof(sealed)));
+	CPPUNIT_ASSERT(std::memcmp(opened, plaintext, sizeof(plaintext)) == 0);
+#endif
+}
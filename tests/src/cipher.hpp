@@ -0,0 +1,110 @@
+/*
+ * libcryptoplus - C++ portable OpenSSL cryptographic wrapper library.
+ * Copyright (C) 2010-2011 Julien Kauffmann <julien.kauffmann@freelan.org>
+ *
+ * This file is part of libcryptoplus.
+ *
+ * libcryptoplus is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libcryptoplus is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ *
+ * If you intend to use libcryptoplus in a commercial software, please
+ * contact me : we may arrange this for a small fee or no fee at all,
+ * depending on the nature of your project.
+ */
+
+/**
+ * \file cipher.hpp
+ * \author Julien Kauffmann <julien.kauffmann@freelan.org>
+ * \brief The cipher test file.
+ */
+
+#ifndef TESTS_CIPHER_HPP
+#define TESTS_CIPHER_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <stdexcept>
+
+class CipherTest : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(CipherTest);
+	CPPUNIT_TEST(testAEADSealOpen);
+	CPPUNIT_TEST(testBatch);
+	CPPUNIT_TEST(testParallelCTR);
+	CPPUNIT_TEST(testParallelGCM);
+	CPPUNIT_TEST(testParallelCBCDecrypt);
+	CPPUNIT_TEST(testKeyedCipher);
+	CPPUNIT_TEST(testAlgorithmRegistry);
+	CPPUNIT_TEST(testCipherStream);
+	CPPUNIT_TEST(testCipherStreamSink);
+	CPPUNIT_TEST(testChunkedContainer);
+	CPPUNIT_TEST(testFilePipeline);
+	CPPUNIT_TEST(testSealInitialize);
+	CPPUNIT_TEST(testEnvelopeSession);
+	CPPUNIT_TEST(testISO10126Padding);
+	CPPUNIT_TEST(testBufferedRandom);
+	CPPUNIT_TEST(testVerifyPadding);
+	CPPUNIT_TEST(testKeyWrap);
+	CPPUNIT_TEST(testXTSSectorCipher);
+	CPPUNIT_TEST(testEncryptThenMAC);
+	CPPUNIT_TEST(testAEADRanking);
+	CPPUNIT_TEST(testNonceSource);
+	CPPUNIT_TEST(testMoveContext);
+	CPPUNIT_TEST(testTypedCipher);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+
+		void setUp();
+		void tearDown();
+
+		void testAEADSealOpen();
+		void testBatch();
+		void testParallelCTR();
+		void testParallelGCM();
+		void testParallelCBCDecrypt();
+		void testKeyedCipher();
+		void testAlgorithmRegistry();
+		void testCipherStream();
+		void testCipherStreamSink();
+		void testChunkedContainer();
+		void testFilePipeline();
+		void testSealInitialize();
+		void testEnvelopeSession();
+		void testISO10126Padding();
+		void testBufferedRandom();
+		void testVerifyPadding();
+		void testKeyWrap();
+		void testXTSSectorCipher();
+		void testEncryptThenMAC();
+		void testAEADRanking();
+		void testNonceSource();
+		void testMoveContext();
+		void testTypedCipher();
+};
+
+#endif /* TESTS_CIPHER_HPP */
@@ -45,6 +45,22 @@
 #include "hash.hpp"
 
 #include <cryptoplus/hash/message_digest_algorithm.hpp>
+#include <cryptoplus/hash/cmac_context.hpp>
+#include <cryptoplus/hash/gmac_context.hpp>
+#include <cryptoplus/hash/message_digest_context.hpp>
+#include <cryptoplus/hash/hmac_context.hpp>
+#include <cryptoplus/hash/typed_digest.hpp>
+#include <cryptoplus/hash/digest_batch.hpp>
+#include <cryptoplus/hash/message_digest.hpp>
+#include <cryptoplus/hash/hmac.hpp>
+#include <cryptoplus/context_pool.hpp>
+#include <cryptoplus/capabilities.hpp>
+
+#include <boost/container/vector.hpp>
+
+#include <vector>
+#include <string>
+#include <cstring>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(HashTest);
 
@@ -70,3 +86,301 @@ void HashTest::testAlgorithms()
 
 	CPPUNIT_ASSERT(a1.raw() == a2.raw());
 }
+
+void HashTest::testContextPool()
+{
+	const std::string data = "The quick brown fox jumps over the lazy dog";
+	const std::string keys[] = { "key", "another key", "" };
+	const message_digest_algorithm algorithms[] = { message_digest_algorithm(EVP_sha256()), message_digest_algorithm(EVP_sha1()), message_digest_algorithm(EVP_sha512()) };
+	const size_t algorithms_count = sizeof(algorithms) / sizeof(algorithms[0]);
+
+	unsigned char expected[EVP_MAX_MD_SIZE];
+	unsigned char result[EVP_MAX_MD_SIZE];
+
+	// A context abandoned in the middle of an operation is reused, and its previous state does not leak into the next one.
+	cryptoplus::context_pool<message_digest_context> md_pool(1);
+	cryptoplus::context_pool<hmac_context> hmac_pool(1);
+	message_digest_context* md_ctx = NULL;
+	hmac_context* hmac_ctx = NULL;
+
+	for (size_t i = 0; i < 2 * algorithms_count; ++i)
+	{
+		const message_digest_algorithm& algorithm = algorithms[i % algorithms_count];
+		const std::string& key = keys[i % algorithms_count];
+
+		message_digest_context fresh_md_ctx;
+		fresh_md_ctx.initialize(algorithm);
+		fresh_md_ctx.update(data.c_str(), data.size());
+		const size_t expected_len = fresh_md_ctx.finalize(expected, sizeof(expected));
+
+		{
+			cryptoplus::context_pool<message_digest_context>::lease ctx(md_pool);
+
+			CPPUNIT_ASSERT((md_ctx == NULL) || (&ctx.get() == md_ctx));
+			md_ctx = &ctx.get();
+
+			ctx->initialize(algorithm);
+			ctx->update(data.c_str(), data.size());
+
+			CPPUNIT_ASSERT_EQUAL(expected_len, ctx->finalize(result, sizeof(result)));
+			CPPUNIT_ASSERT(std::memcmp(result, expected, expected_len) == 0);
+
+			ctx->initialize(algorithm);
+			ctx->update("abandoned", 9);
+		}
+
+		hmac_context fresh_hmac_ctx;
+		fresh_hmac_ctx.initialize(key.c_str(), key.size(), &algorithm);
+		fresh_hmac_ctx.update(data.c_str(), data.size());
+		CPPUNIT_ASSERT_EQUAL(expected_len, fresh_hmac_ctx.finalize(expected, sizeof(expected)));
+
+		{
+			cryptoplus::context_pool<hmac_context>::lease ctx(hmac_pool);
+
+			CPPUNIT_ASSERT((hmac_ctx == NULL) || (&ctx.get() == hmac_ctx));
+			hmac_ctx = &ctx.get();
+
+			ctx->initialize(key.c_str(), key.size(), &algorithm);
+			ctx->update(data.c_str(), data.size());
+
+			CPPUNIT_ASSERT_EQUAL(expected_len, ctx->finalize(result, sizeof(result)));
+			CPPUNIT_ASSERT(std::memcmp(result, expected, expected_len) == 0);
+
+			ctx->initialize("abandoned key", 13, &algorithm);
+			ctx->update("abandoned", 9);
+		}
+	}
+
+	// message_digest() and hmac() lease their contexts from their own pools: interleaved calls reuse them and always give the same results.
+	for (size_t i = 0; i < 3 * algorithms_count; ++i)
+	{
+		const message_digest_algorithm& algorithm = algorithms[i % algorithms_count];
+		const std::string& key = keys[(i / algorithms_count) % algorithms_count];
+
+		message_digest_context fresh_md_ctx;
+		fresh_md_ctx.initialize(algorithm);
+		fresh_md_ctx.update(data.c_str(), data.size());
+		const size_t expected_len = fresh_md_ctx.finalize(expected, sizeof(expected));
+
+		CPPUNIT_ASSERT_EQUAL(expected_len, message_digest(result, sizeof(result), data.c_str(), data.size(), algorithm));
+		CPPUNIT_ASSERT(std::memcmp(result, expected, expected_len) == 0);
+
+		hmac_context fresh_hmac_ctx;
+		fresh_hmac_ctx.initialize(key.c_str(), key.size(), &algorithm);
+		fresh_hmac_ctx.update(data.c_str(), data.size());
+		CPPUNIT_ASSERT_EQUAL(expected_len, fresh_hmac_ctx.finalize(expected, sizeof(expected)));
+
+		CPPUNIT_ASSERT_EQUAL(expected_len, hmac(result, sizeof(result), key.c_str(), key.size(), data.c_str(), data.size(), algorithm));
+		CPPUNIT_ASSERT(std::memcmp(result, expected, expected_len) == 0);
+	}
+}
+
+void HashTest::testAlgorithmRegistry()
+{
+	// Canonical names, aliases, case variants and unknown names: the lookups must always agree with OpenSSL.
+	const char* const names[] = { "sha256", "SHA256", "Sha256", "RSA-SHA256", "sha1", "SHA1", "ssl3-sha1", "md5", "MD5", "sha512", "unknown-digest", "" };
+
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+	{
+		const EVP_MD* const md = EVP_get_digestbyname(names[i]);
+
+		if (!md)
+		{
+			CPPUNIT_ASSERT_THROW(message_digest_algorithm(std::string(names[i])), std::invalid_argument);
+
+			continue;
+		}
+
+		const message_digest_algorithm by_name(names[i]);
+		const message_digest_algorithm by_type(EVP_MD_type(md));
+		const message_digest_algorithm by_pointer(md);
+
+		const message_digest_algorithm* const algorithms[] = { &by_name, &by_type, &by_pointer };
+
+		for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); ++a)
+		{
+			CPPUNIT_ASSERT(algorithms[a]->raw() == md);
+			CPPUNIT_ASSERT_EQUAL(EVP_MD_type(md), algorithms[a]->type());
+			CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(EVP_MD_size(md)), algorithms[a]->result_size());
+			CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(EVP_MD_block_size(md)), algorithms[a]->block_size());
+		}
+	}
+
+	CPPUNIT_ASSERT_THROW(message_digest_algorithm(NID_undef), std::invalid_argument);
+}
+
+void HashTest::testCMAC()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+	// RFC 4493, section 4, examples 1 and 2.
+	const unsigned char key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+	const unsigned char data[16] = { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a };
+	const unsigned char expected[2][16] = {
+		{ 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46 },
+		{ 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c }
+	};
+
+	cmac_context ctx;
+	ctx.initialize(key, sizeof(key), cryptoplus::cipher::cipher_algorithm(EVP_aes_128_cbc()));
+
+	unsigned char macs[2][16];
+
+	cmac_context::message messages[2] = {
+		{ data, 0, macs[0], sizeof(macs[0]), 0 },
+		{ data, sizeof(data), macs[1], sizeof(macs[1]), 0 }
+	};
+
+	ctx.compute(messages, 2);
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(expected[0]), messages[0].result);
+	CPPUNIT_ASSERT(std::memcmp(macs[0], expected[0], sizeof(expected[0])) == 0);
+	CPPUNIT_ASSERT(std::memcmp(macs[1], expected[1], sizeof(expected[1])) == 0);
+
+	ctx.reset();
+	ctx.update(data, 7);
+	ctx.update(data + 7, sizeof(data) - 7);
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(expected[1]), ctx.finalize(macs[0], sizeof(macs[0])));
+	CPPUNIT_ASSERT(std::memcmp(macs[0], expected[1], sizeof(expected[1])) == 0);
+#endif
+}
+
+void HashTest::testGMAC()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10001000
+	// NIST CAVP gcmEncryptExtIV128.rsp, [Keylen = 128] [IVlen = 96] [PTlen = 0] [AADlen = 128] [Taglen = 128], count 0.
+	const unsigned char key[16] = { 0x77, 0xbe, 0x63, 0x70, 0x89, 0x71, 0xc4, 0xe2, 0x40, 0xd1, 0xcb, 0x79, 0xe8, 0xd7, 0x7f, 0xeb };
+	const unsigned char iv[12] = { 0xe0, 0xe0, 0x0f, 0x19, 0xfe, 0xd7, 0xba, 0x01, 0x36, 0xa7, 0x97, 0xf3 };
+	const unsigned char data[16] = { 0x7a, 0x43, 0xec, 0x1d, 0x9c, 0x0a, 0x5a, 0x78, 0xa0, 0xb1, 0x65, 0x33, 0xa6, 0x21, 0x3c, 0xab };
+	const unsigned char expected[16] = { 0x20, 0x9f, 0xcc, 0x8d, 0x36, 0x75, 0xed, 0x93, 0x8e, 0x9c, 0x71, 0x66, 0x70, 0x9d, 0xd9, 0x46 };
+
+	gmac_context ctx;
+	ctx.initialize(key, sizeof(key), cryptoplus::cipher::cipher_algorithm(EVP_aes_128_gcm()), sizeof(iv));
+
+	unsigned char mac[16];
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(expected), ctx.compute(mac, sizeof(mac), iv, sizeof(iv), data, sizeof(data)));
+	CPPUNIT_ASSERT(std::memcmp(mac, expected, sizeof(expected)) == 0);
+
+	ctx.reset(iv, sizeof(iv));
+	ctx.update(data, 7);
+	ctx.update(data + 7, sizeof(data) - 7);
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(expected), ctx.finalize(mac, sizeof(mac)));
+	CPPUNIT_ASSERT(std::memcmp(mac, expected, sizeof(expected)) == 0);
+#endif
+}
+
+void HashTest::testHashRanking()
+{
+	const std::vector<cryptoplus::hash_score>& ranking = cryptoplus::get_hash_ranking();
+
+	CPPUNIT_ASSERT(!ranking.empty());
+
+	for (size_t i = 1; i < ranking.size(); ++i)
+	{
+		CPPUNIT_ASSERT(ranking[i - 1].bytes_per_second >= ranking[i].bytes_per_second);
+	}
+
+	CPPUNIT_ASSERT(cryptoplus::get_fastest_hash_algorithm(32).result_size() >= 32);
+	CPPUNIT_ASSERT(cryptoplus::get_fastest_hash_algorithm(64).result_size() >= 64);
+	CPPUNIT_ASSERT_THROW(cryptoplus::get_fastest_hash_algorithm(65), std::runtime_error);
+}
+
+void HashTest::testMoveContexts()
+{
+	const unsigned char expected_digest[32] = { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad };
+	const unsigned char expected_hmac[32] = { 0xf7, 0xbc, 0x83, 0xf4, 0x30, 0x53, 0x84, 0x24, 0xb1, 0x32, 0x98, 0xe6, 0xaa, 0x6f, 0xb1, 0x43, 0xef, 0x4d, 0x59, 0xa1, 0x49, 0x46, 0x17, 0x59, 0x97, 0x47, 0x9d, 0xbc, 0x2d, 0x1a, 0x3c, 0xd8 };
+	const std::string data = "The quick brown fox jumps over the lazy dog";
+
+	const message_digest_algorithm algorithm(EVP_sha256());
+	unsigned char result[32];
+
+	// A partially updated context carries on after being moved.
+	message_digest_context md_ctx;
+	md_ctx.initialize(algorithm);
+	md_ctx.update("a", 1);
+
+	message_digest_context moved_md_ctx(boost::move(md_ctx));
+	moved_md_ctx.update("bc", 2);
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(result), moved_md_ctx.finalize(result, sizeof(result)));
+	CPPUNIT_ASSERT(std::memcmp(result, expected_digest, sizeof(expected_digest)) == 0);
+
+	boost::container::vector<hmac_context> hmac_contexts;
+
+	for (size_t i = 0; i < 4; ++i)
+	{
+		hmac_context hmac_ctx;
+		hmac_ctx.initialize("key", 3, &algorithm);
+		hmac_contexts.push_back(boost::move(hmac_ctx));
+	}
+
+	for (size_t i = 0; i < hmac_contexts.size(); ++i)
+	{
+		hmac_contexts[i].update(data.c_str(), data.size());
+
+		CPPUNIT_ASSERT_EQUAL(sizeof(result), hmac_contexts[i].finalize(result, sizeof(result)));
+		CPPUNIT_ASSERT(std::memcmp(result, expected_hmac, sizeof(expected_hmac)) == 0);
+	}
+}
+
+void HashTest::testTypedDigest()
+{
+	// FIPS 180-2, appendix B.1.
+	const typed_digest<sha256>::result_type expected = {{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad }};
+
+	CPPUNIT_ASSERT(typed_digest<sha256>::compute("abc", 3) == expected);
+
+	typed_digest<sha256> digest;
+
+	// The digest is ready for another message after finalize().
+	for (size_t i = 0; i < 2; ++i)
+	{
+		digest.update("a", 1);
+		digest.update("bc", 2);
+
+		CPPUNIT_ASSERT(digest.finalize() == expected);
+	}
+}
+
+void HashTest::testDigestBatch()
+{
+	// Messages of different lengths end in different lanes, some with two padding blocks.
+	const size_t lengths[] = { 0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 300, 500, 17 };
+	const size_t messages_count = sizeof(lengths) / sizeof(lengths[0]);
+
+	std::vector<unsigned char> data(512);
+
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<unsigned char>(i * 7 + 3);
+	}
+
+	const message_digest_algorithm algorithms[] = { message_digest_algorithm(EVP_sha256()), message_digest_algorithm(EVP_sha1()) };
+
+	for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); ++a)
+	{
+		digest_batch batch(algorithms[a]);
+
+		std::vector<unsigned char> mds(messages_count * EVP_MAX_MD_SIZE);
+		std::vector<digest_batch::message> messages(messages_count);
+
+		for (size_t i = 0; i < messages_count; ++i)
+		{
+			const digest_batch::message msg = { &data[i], lengths[i], &mds[i * EVP_MAX_MD_SIZE], EVP_MAX_MD_SIZE, 0 };
+			messages[i] = msg;
+		}
+
+		batch.compute(messages);
+
+		for (size_t i = 0; i < messages_count; ++i)
+		{
+			unsigned char expected[EVP_MAX_MD_SIZE];
+			const size_t expected_len = message_digest(expected, sizeof(expected), &data[i], lengths[i], algorithms[a]);
+
+			CPPUNIT_ASSERT_EQUAL(expected_len, messages[i].result);
+			CPPUNIT_ASSERT(std::memcmp(&mds[i * EVP_MAX_MD_SIZE], expected, expected_len) == 0);
+		}
+	}
+}
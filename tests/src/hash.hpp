@@ -54,6 +54,14 @@ class HashTest : public CppUnit::TestFixture
 	CPPUNIT_TEST_SUITE(HashTest);
 	CPPUNIT_TEST_EXCEPTION(testInvalidNameException, std::invalid_argument);
 	CPPUNIT_TEST(testAlgorithms);
+	CPPUNIT_TEST(testContextPool);
+	CPPUNIT_TEST(testAlgorithmRegistry);
+	CPPUNIT_TEST(testCMAC);
+	CPPUNIT_TEST(testGMAC);
+	CPPUNIT_TEST(testHashRanking);
+	CPPUNIT_TEST(testMoveContexts);
+	CPPUNIT_TEST(testTypedDigest);
+	CPPUNIT_TEST(testDigestBatch);
 	CPPUNIT_TEST_SUITE_END();
 
 	public:
@@ -63,6 +71,14 @@ class HashTest : public CppUnit::TestFixture
 
 		void testInvalidNameException();
 		void testAlgorithms();
+		void testContextPool();
+		void testAlgorithmRegistry();
+		void testCMAC();
+		void testGMAC();
+		void testHashRanking();
+		void testMoveContexts();
+		void testTypedDigest();
+		void testDigestBatch();
 };
 
 #endif /* TESTS_HASH_HPP */